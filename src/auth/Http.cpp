@@ -5,8 +5,10 @@
  *
  */
 
+#include <pwd.h>
 #include <spdlog/spdlog.h>
 #include <string>
+#include <vector>
 #include "NacmIdentities.h"
 #include "http/utils.hpp"
 #include "auth/Http.h"
@@ -15,7 +17,8 @@
 
 namespace rousette::auth {
 
-void authorizeRequest(const Nacm& nacm, sysrepo::Session& sess, [[maybe_unused]] const nghttp2::asio_http2::server::request& req)
+/** @short Authenticate the HTTP request and return the name of the NACM user */
+std::string authorizeRequest(const Nacm& nacm, const nghttp2::asio_http2::server::request& req)
 {
     std::string nacmUser;
     if (auto authHeader = http::getHeaderValue(req.header(), "authorization")) {
@@ -25,9 +28,29 @@ void authorizeRequest(const Nacm& nacm, sysrepo::Session& sess, [[maybe_unused]]
         nacmUser = ANONYMOUS_USER;
     }
 
-    if (!nacm.authorize(sess, nacmUser)) {
+    if (!nacm.authorize(nacmUser)) {
         throw Error{"Access denied."};
     }
+
+    return nacmUser;
+}
+
+/** @short Use the name of a local system user as the NACM user, no further authentication */
+std::string authorizeLocalUser(const Nacm& nacm, const uid_t uid)
+{
+    passwd pwd;
+    passwd* result;
+    std::vector<char> buf(16384);
+    if (auto err = ::getpwuid_r(uid, &pwd, buf.data(), buf.size(), &result); err || !result) {
+        throw Error{"Unknown local user " + std::to_string(uid)};
+    }
+
+    std::string nacmUser = pwd.pw_name;
+    if (!nacm.authorize(nacmUser)) {
+        throw Error{"Access denied."};
+    }
+
+    return nacmUser;
 }
 
 void processAuthError(const nghttp2::asio_http2::server::request& req, const nghttp2::asio_http2::server::response& res, const auth::Error& error, const std::function<void()>& errorResponseCb)
@@ -8,15 +8,13 @@
 #pragma once
 
 #include <nghttp2/asio_http2_server.h>
+#include <sys/types.h>
 #include "auth/Error.h"
 
-namespace sysrepo {
-class Session;
-}
-
 namespace rousette::auth {
 class Nacm;
 
-void authorizeRequest(const Nacm& nacm, sysrepo::Session& sess, const nghttp2::asio_http2::server::request& req);
+std::string authorizeRequest(const Nacm& nacm, const nghttp2::asio_http2::server::request& req);
+std::string authorizeLocalUser(const Nacm& nacm, const uid_t uid);
 void processAuthError(const nghttp2::asio_http2::server::request& req, const nghttp2::asio_http2::server::response& res, const auth::Error& error, const std::function<void()>& errorResponseCb);
 }
@@ -5,6 +5,7 @@
  */
 
 #include <spdlog/spdlog.h>
+#include <sysrepo/netconf_acm.h>
 #include "Nacm.h"
 #include "NacmIdentities.h"
 
@@ -86,6 +87,24 @@ bool validAnonymousNacmRules(sysrepo::Session session, const std::string& anonGr
     return true;
 }
 
+/** @short Which NACM groups is each user a member of */
+std::map<std::string, std::set<std::string>> nacmGroups(sysrepo::Session session)
+{
+    std::map<std::string, std::set<std::string>> res;
+    if (auto data = session.getData("/ietf-netconf-acm:nacm/groups")) {
+        for (const auto& userName : data->findXPath("/ietf-netconf-acm:nacm/groups/group/user-name")) {
+            res[userName.asTerm().valueStr()].insert(userName.parent()->findPath("name")->asTerm().valueStr());
+        }
+    }
+    return res;
+}
+
+bool externalGroupsEnabled(sysrepo::Session session)
+{
+    auto node = session.getData("/ietf-netconf-acm:nacm/enable-external-groups");
+    // the default is "true"
+    return !node || node->findPath("/ietf-netconf-acm:nacm/enable-external-groups")->asTerm().valueStr() != "false";
+}
 }
 
 namespace rousette::auth {
@@ -94,11 +113,19 @@ Nacm::Nacm(sysrepo::Connection conn)
     : m_srSession(conn.sessionStart(sysrepo::Datastore::Running))
     , m_srSub(m_srSession.initNacm())
     , m_anonymousEnabled{false}
+    , m_externalGroups{true}
 {
     m_srSub.onModuleChange(
         "ietf-netconf-acm", [&](auto session, auto, auto, auto, auto, auto) {
             m_anonymousEnabled = validAnonymousNacmRules(session, ANONYMOUS_USER_GROUP);
             spdlog::info("NACM config validation: Anonymous user access {}", m_anonymousEnabled ? "enabled" : "disabled");
+            {
+                auto groups = nacmGroups(session);
+                auto externalGroups = externalGroupsEnabled(session);
+                std::lock_guard lock{m_groupsMutex};
+                m_groups = std::move(groups);
+                m_externalGroups = externalGroups;
+            }
             return sysrepo::ErrorCode::Ok;
         },
         std::nullopt,
@@ -106,16 +133,40 @@ Nacm::Nacm(sysrepo::Connection conn)
         sysrepo::SubscribeOptions::Enabled | sysrepo::SubscribeOptions::DoneOnly | sysrepo::SubscribeOptions::Passive);
 }
 
-/** @brief Tries to set @p user as NACM user in @p session. In case the user is the anonymous user we also check that anonymous access is enabled */
-bool Nacm::authorize(sysrepo::Session session, const std::string& user) const
+/** @brief Checks if @p user may access the server. In case the user is the anonymous user we also check that anonymous access is enabled
+ *
+ * Setting the NACM user in the session is up to the caller.
+ */
+bool Nacm::authorize(const std::string& user) const
 {
     if (user == ANONYMOUS_USER && !m_anonymousEnabled) {
         spdlog::trace("Anonymous access not configured");
         return false;
     }
 
-    session.setNacmUser(user);
     spdlog::trace("Authenticated as user {}", user);
     return true;
 }
+
+/** @short An identifier which is shared by all users that get the same NACM treatment
+ *
+ * NACM rules refer to groups, not to individual users, so data filtered for one user are also good for all other users
+ * who are members of the same groups. That's not the case when the system groups are taken into account, or for the
+ * recovery user who bypasses NACM.
+ */
+std::string Nacm::accessProfile(const std::string& user) const
+{
+    std::lock_guard lock{m_groupsMutex};
+    if (m_externalGroups || user == sr_nacm_get_recovery_user()) {
+        return "user " + user;
+    }
+
+    std::string res = "groups";
+    if (auto it = m_groups.find(user); it != m_groups.end()) {
+        for (const auto& group : it->second) {
+            res += " " + group;
+        }
+    }
+    return res;
+}
 }
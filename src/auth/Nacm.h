@@ -8,6 +8,9 @@
 #include <sysrepo-cpp/Connection.hpp>
 #include <sysrepo-cpp/Session.hpp>
 #include <sysrepo-cpp/Subscription.hpp>
+#include <map>
+#include <mutex>
+#include <set>
 #include <thread>
 
 namespace rousette::auth {
@@ -19,12 +22,16 @@ namespace rousette::auth {
 class Nacm {
 public:
     Nacm(sysrepo::Connection conn);
-    bool authorize(sysrepo::Session session, const std::string& user) const;
+    bool authorize(const std::string& user) const;
+    std::string accessProfile(const std::string& user) const;
 
 private:
     sysrepo::Session m_srSession;
     sysrepo::Subscription m_srSub;
     std::atomic<bool> m_anonymousEnabled;
+    mutable std::mutex m_groupsMutex;
+    std::map<std::string, std::set<std::string>> m_groups; ///< NACM groups of each user as configured in ietf-netconf-acm
+    bool m_externalGroups; ///< Users might also be members of system groups, see RFC 8341's enable-external-groups
 };
 
 }
@@ -0,0 +1,203 @@
+/*
+ * Copyright (C) 2026 CESNET, https://photonics.cesnet.cz/
+ *
+ * Written by Jan Kundrát <jan.kundrat@cesnet.cz>
+ *
+*/
+
+#include <algorithm>
+#include <array>
+#include <boost/algorithm/string.hpp>
+#include <map>
+#include <stdexcept>
+#include <vector>
+#include <zlib.h>
+#include <zstd.h>
+#include "http/Compression.h"
+
+namespace rousette::http {
+
+/** @short Pick the best of the supported content codings which the client accepts
+ *
+ * When the client prefers several codings equally, zstd wins over gzip, which wins over deflate.
+ */
+ContentCoding chooseContentCoding(const std::string& acceptEncoding)
+{
+    std::map<std::string, double> qValues;
+    std::vector<std::string> items;
+    boost::split(items, acceptEncoding, boost::is_any_of(","));
+    for (auto& item : items) {
+        std::vector<std::string> parts;
+        boost::split(parts, item, boost::is_any_of(";"));
+        auto coding = boost::algorithm::to_lower_copy(boost::algorithm::trim_copy(parts[0]));
+        if (coding.empty()) {
+            continue;
+        }
+
+        double q = 1;
+        for (auto it = parts.begin() + 1; it != parts.end(); ++it) {
+            auto param = boost::algorithm::trim_copy(*it);
+            if (param.starts_with("q=") || param.starts_with("Q=")) {
+                try {
+                    q = std::stod(param.substr(2));
+                } catch (const std::logic_error&) {
+                    q = 0;
+                }
+            }
+        }
+        qValues[coding == "x-gzip" ? "gzip" : coding] = q;
+    }
+
+    auto wildcard = qValues.find("*");
+    ContentCoding best = ContentCoding::Identity;
+    double bestQ = 0;
+    for (const auto& [coding, name] : {std::pair{ContentCoding::Zstd, "zstd"}, {ContentCoding::Gzip, "gzip"}, {ContentCoding::Deflate, "deflate"}}) {
+        double q = 0;
+        if (auto it = qValues.find(name); it != qValues.end()) {
+            q = it->second;
+        } else if (wildcard != qValues.end()) {
+            q = wildcard->second;
+        }
+        if (q > bestQ) {
+            best = coding;
+            bestQ = q;
+        }
+    }
+    return best;
+}
+
+/** @short The value of the Content-Encoding header, if any */
+std::optional<std::string> contentCodingName(const ContentCoding coding)
+{
+    switch (coding) {
+    case ContentCoding::Identity:
+        return std::nullopt;
+    case ContentCoding::Deflate:
+        return "deflate";
+    case ContentCoding::Gzip:
+        return "gzip";
+    case ContentCoding::Zstd:
+        return "zstd";
+    }
+    __builtin_unreachable();
+}
+
+struct Compressor::Impl {
+    virtual ~Impl() = default;
+    virtual std::string process(std::string_view data, const int mode) = 0;
+
+    enum Mode {
+        Continue,
+        Flush,
+        End,
+    };
+};
+
+namespace {
+/** @short The "deflate" coding of HTTP is actually the zlib format, see RFC 9110's section 8.4.1.2 */
+struct ZlibCompressor : Compressor::Impl {
+    z_stream stream{};
+
+    explicit ZlibCompressor(const ContentCoding coding)
+    {
+        const int windowBits = coding == ContentCoding::Gzip ? 15 + 16 : 15;
+        if (deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, windowBits, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+            throw std::runtime_error{"Cannot initialize zlib"};
+        }
+    }
+
+    ~ZlibCompressor() override
+    {
+        deflateEnd(&stream);
+    }
+
+    std::string process(std::string_view data, const int mode) override
+    {
+        const int flush = mode == End ? Z_FINISH : mode == Flush ? Z_SYNC_FLUSH : Z_NO_FLUSH;
+        std::string res;
+        std::array<unsigned char, 16384> buf;
+        stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.data()));
+        stream.avail_in = data.size();
+        int ret;
+        do {
+            stream.next_out = buf.data();
+            stream.avail_out = buf.size();
+            ret = deflate(&stream, flush);
+            if (ret == Z_STREAM_ERROR) {
+                throw std::runtime_error{"zlib compression failed"};
+            }
+            res.append(reinterpret_cast<const char*>(buf.data()), buf.size() - stream.avail_out);
+        } while (stream.avail_out == 0 || (flush == Z_FINISH && ret != Z_STREAM_END));
+        return res;
+    }
+};
+
+struct ZstdCompressor : Compressor::Impl {
+    ZSTD_CCtx* ctx;
+
+    ZstdCompressor()
+        : ctx(ZSTD_createCCtx())
+    {
+        if (!ctx) {
+            throw std::runtime_error{"Cannot initialize zstd"};
+        }
+    }
+
+    ~ZstdCompressor() override
+    {
+        ZSTD_freeCCtx(ctx);
+    }
+
+    std::string process(std::string_view data, const int mode) override
+    {
+        const auto directive = mode == End ? ZSTD_e_end : mode == Flush ? ZSTD_e_flush : ZSTD_e_continue;
+        std::string res;
+        std::array<char, 16384> buf;
+        ZSTD_inBuffer in{data.data(), data.size(), 0};
+        std::size_t remaining;
+        do {
+            ZSTD_outBuffer out{buf.data(), buf.size(), 0};
+            remaining = ZSTD_compressStream2(ctx, &out, &in, directive);
+            if (ZSTD_isError(remaining)) {
+                throw std::runtime_error{std::string{"zstd compression failed: "} + ZSTD_getErrorName(remaining)};
+            }
+            res.append(buf.data(), out.pos);
+        } while (directive == ZSTD_e_continue ? in.pos < in.size : remaining != 0);
+        return res;
+    }
+};
+}
+
+Compressor::Compressor(const ContentCoding coding)
+{
+    switch (coding) {
+    case ContentCoding::Identity:
+        throw std::logic_error{"Compressor: nothing to compress with"};
+    case ContentCoding::Deflate:
+    case ContentCoding::Gzip:
+        m_impl = std::make_unique<ZlibCompressor>(coding);
+        break;
+    case ContentCoding::Zstd:
+        m_impl = std::make_unique<ZstdCompressor>();
+        break;
+    }
+}
+
+Compressor::~Compressor() = default;
+
+std::string Compressor::compress(std::string_view data)
+{
+    return m_impl->process(data, Impl::Continue);
+}
+
+/** @short Everything which was passed to compress() so far can be decompressed from the output up to this point */
+std::string Compressor::flush()
+{
+    return m_impl->process({}, Impl::Flush);
+}
+
+std::string Compressor::finish()
+{
+    return m_impl->process({}, Impl::End);
+}
+}
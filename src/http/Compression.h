@@ -0,0 +1,50 @@
+/*
+ * Copyright (C) 2026 CESNET, https://photonics.cesnet.cz/
+ *
+ * Written by Jan Kundrát <jan.kundrat@cesnet.cz>
+ *
+*/
+
+#pragma once
+
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace rousette::http {
+
+/** @short Content codings for the HTTP Content-Encoding header, see RFC 9110's section 8.4.1 */
+enum class ContentCoding {
+    Identity,
+    Deflate,
+    Gzip,
+    Zstd,
+};
+
+ContentCoding chooseContentCoding(const std::string& acceptEncoding);
+std::optional<std::string> contentCodingName(const ContentCoding coding);
+
+/** @short Streaming compression of a response body
+ *
+ * Chunks of the body are fed to compress() as they become available, and the compressed data are sent as they come
+ * out. Compressors buffer some data internally, so the output of compress() might be empty. The body has to be
+ * terminated by finish().
+ * */
+class Compressor {
+public:
+    explicit Compressor(const ContentCoding coding);
+    ~Compressor();
+    Compressor(const Compressor&) = delete;
+    Compressor& operator=(const Compressor&) = delete;
+
+    std::string compress(std::string_view data);
+    std::string flush();
+    std::string finish();
+
+    struct Impl; ///< Implemented by each of the codings
+
+private:
+    std::unique_ptr<Impl> m_impl;
+};
+}
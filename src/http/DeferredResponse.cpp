@@ -0,0 +1,241 @@
+/*
+ * Copyright (C) 2026 CESNET, https://photonics.cesnet.cz/
+ *
+ * Written by Jan Kundrát <jan.kundrat@cesnet.cz>
+ *
+*/
+
+#include <algorithm>
+#include <array>
+#include <boost/asio/post.hpp>
+#include <nghttp2/asio_http2_server.h>
+#include <spdlog/spdlog.h>
+#include "http/DeferredResponse.h"
+
+namespace rousette::http {
+
+namespace {
+/** @short A body produced by a generator, compressed on the fly if needed */
+struct EncodedStream {
+    nghttp2::asio_http2::generator_cb source;
+    std::unique_ptr<Compressor> compressor;
+    std::array<uint8_t, 16384> chunk;
+    std::string out;
+    std::size_t offset = 0;
+    bool sourceFinished = false;
+    ssize_t sourceError = 0;
+
+    /** @short Read one chunk from the source; false when there is nothing right now */
+    bool pull()
+    {
+        uint32_t flags = 0;
+        auto n = source(chunk.data(), chunk.size(), &flags);
+        if (n == NGHTTP2_ERR_DEFERRED) {
+            return false;
+        } else if (n < 0) {
+            sourceError = n;
+            return false;
+        }
+        out.append(reinterpret_cast<const char*>(chunk.data()), n);
+        sourceFinished = flags & NGHTTP2_DATA_FLAG_EOF;
+        return true;
+    }
+
+    ssize_t generate(uint8_t* data, std::size_t length, uint32_t* flags)
+    {
+        while (offset == out.size()) {
+            out.clear();
+            offset = 0;
+            if (sourceError) {
+                return sourceError;
+            }
+            if (sourceFinished) {
+                *flags |= NGHTTP2_DATA_FLAG_EOF;
+                return 0;
+            }
+            if (!pull()) {
+                if (sourceError) {
+                    continue;
+                }
+                return NGHTTP2_ERR_DEFERRED;
+            }
+            if (compressor) {
+                out = compressor->compress(out);
+                if (sourceFinished) {
+                    out += compressor->finish();
+                }
+            }
+        }
+
+        auto n = std::min(length, out.size() - offset);
+        std::copy_n(out.data() + offset, n, data);
+        offset += n;
+        return n;
+    }
+};
+}
+
+DeferredResponse::State::State(const nghttp2::asio_http2::server::response& res)
+    : res(res)
+    , io(res.io_service())
+{
+}
+
+/** @short Must be called from the response's io_context, i.e., from within the nghttp2-asio request handler */
+DeferredResponse::DeferredResponse(const nghttp2::asio_http2::server::response& res)
+    : m_state(std::make_shared<State>(res))
+{
+    // The callback is invoked from the io_context's thread, just like the writes in end(), so there's no race between
+    // checking the flag and the response object going away.
+    res.on_close([state = m_state](auto) {
+        state->closed = true;
+    });
+}
+
+/** @short Responses which carry a body that is at least @p threshold bytes long are compressed with the @p coding
+
+Such responses are marked with `Vary: accept-encoding` even when the @p coding is the identity, because another client
+might get a compressed body.
+*/
+void DeferredResponse::encodeWith(const ContentCoding coding, const std::size_t threshold) const
+{
+    m_state->compressionEnabled = true;
+    m_state->coding = coding;
+    m_state->compressionThreshold = threshold;
+}
+
+bool DeferredResponse::State::hasBody() const
+{
+    return statusCode >= 200 && statusCode != 204 && statusCode != 304;
+}
+
+/** @short Could the body depend on the client's Accept-Encoding? */
+bool DeferredResponse::State::mayVary() const
+{
+    return compressionEnabled && hasBody();
+}
+
+void DeferredResponse::State::writeHead(const bool compressed, const bool varies)
+{
+    if (compressed) {
+        headers.emplace("content-encoding", nghttp2::asio_http2::header_value{*contentCodingName(coding), false});
+    }
+    if (varies) {
+        headers.emplace("vary", nghttp2::asio_http2::header_value{"accept-encoding", false});
+    }
+    res.write_head(statusCode, std::move(headers));
+}
+
+void DeferredResponse::write_head(unsigned int statusCode, nghttp2::asio_http2::header_map headers) const
+{
+    m_state->statusCode = statusCode;
+    m_state->headers = std::move(headers);
+}
+
+void DeferredResponse::end(std::string data) const
+{
+    dispatch([state = m_state, data = std::move(data)]() mutable {
+        if (state->closed) {
+            return;
+        }
+        bool compressed = false;
+        const bool varies = state->mayVary() && data.size() >= state->compressionThreshold;
+        if (varies && state->coding != ContentCoding::Identity) {
+            try {
+                Compressor compressor{state->coding};
+                data = compressor.compress(data) + compressor.finish();
+                compressed = true;
+            } catch (const std::exception& e) {
+                spdlog::error("Cannot compress the response: {}", e.what());
+            }
+        }
+        state->writeHead(compressed, varies);
+        state->res.end(std::move(data));
+    });
+}
+
+/** @short Send the body as it is produced by the generator, which is invoked from the response's io_context
+ *
+ * When compression is enabled, the generator is asked for data right away in order to find out whether the body is
+ * big enough to be worth compressing, even when this particular client does not accept any compressed content coding.
+ * A body whose size is not known yet because the generator has to wait for more data is compressed.
+ */
+void DeferredResponse::end(nghttp2::asio_http2::generator_cb cb) const
+{
+    dispatch([state = m_state, cb = std::move(cb)]() mutable {
+        if (state->closed) {
+            return;
+        }
+        if (!state->mayVary()) {
+            state->writeHead(false, false);
+            state->res.end(std::move(cb));
+            return;
+        }
+
+        auto stream = std::make_shared<EncodedStream>();
+        stream->source = std::move(cb);
+        while (!stream->sourceFinished && stream->out.size() < state->compressionThreshold && stream->pull()) {
+        }
+        if (stream->sourceFinished && stream->out.size() < state->compressionThreshold) {
+            state->writeHead(false, false);
+            state->res.end(std::move(stream->out));
+            return;
+        }
+
+        // without a compressor, the EncodedStream passes the data through unchanged
+        if (state->coding != ContentCoding::Identity) {
+            try {
+                auto compressor = std::make_unique<Compressor>(state->coding);
+                auto compressed = compressor->compress(stream->out);
+                if (stream->sourceFinished) {
+                    compressed += compressor->finish();
+                }
+                stream->out = std::move(compressed);
+                stream->compressor = std::move(compressor);
+            } catch (const std::exception& e) {
+                // the headers have not been sent yet, so it is still possible to fall back to the uncompressed data
+                spdlog::error("Cannot compress the response: {}", e.what());
+            }
+        }
+        state->writeHead(!!stream->compressor, true);
+        state->res.end([stream](uint8_t* data, std::size_t length, uint32_t* flags) -> ssize_t {
+            try {
+                return stream->generate(data, length, flags);
+            } catch (const std::exception& e) {
+                spdlog::error("Cannot compress the response: {}", e.what());
+                return NGHTTP2_ERR_TEMPORAL_CALLBACK_FAILURE;
+            }
+        });
+    });
+}
+
+/** @short Ask for more data from a generator which has returned NGHTTP2_ERR_DEFERRED */
+void DeferredResponse::resume() const
+{
+    boost::asio::post(m_state->io, [state = m_state]() {
+        if (!state->closed) {
+            state->res.resume();
+        }
+    });
+}
+
+void DeferredResponse::dispatch(std::function<void()> send) const
+{
+    if (m_state->io.get_executor().running_in_this_thread()) {
+        send();
+    } else {
+        boost::asio::post(m_state->io, std::move(send));
+    }
+}
+
+/** @short Has the client gone away already? */
+bool DeferredResponse::closed() const
+{
+    return m_state->closed;
+}
+
+boost::asio::io_context& DeferredResponse::io_service() const
+{
+    return m_state->io;
+}
+}
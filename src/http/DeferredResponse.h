@@ -0,0 +1,66 @@
+/*
+ * Copyright (C) 2026 CESNET, https://photonics.cesnet.cz/
+ *
+ * Written by Jan Kundrát <jan.kundrat@cesnet.cz>
+ *
+*/
+
+#pragma once
+
+#include <atomic>
+#include <boost/asio/io_context.hpp>
+#include <functional>
+#include <memory>
+#include <nghttp2/asio_http2.h>
+#include "http/Compression.h"
+
+namespace nghttp2::asio_http2::server {
+class response;
+}
+
+namespace rousette::http {
+
+/** @short A HTTP response which can be completed from any thread
+
+The nghttp2-asio response must only be accessed from the thread which runs its io_context, and it goes away as soon as
+the client disconnects. This is a cheap, copyable handle which marshals the actual writing back into the response's
+io_context. When the client has already disconnected by the time the response is ready, the response is dropped.
+
+Only one thread is supposed to produce the response at any given time.
+
+The body can be compressed transparently, see encodeWith().
+*/
+class DeferredResponse {
+public:
+    explicit DeferredResponse(const nghttp2::asio_http2::server::response& res);
+
+    void encodeWith(const ContentCoding coding, const std::size_t threshold) const;
+    void write_head(unsigned int statusCode, nghttp2::asio_http2::header_map headers = {}) const;
+    void end(std::string data = "") const;
+    void end(nghttp2::asio_http2::generator_cb cb) const;
+    void resume() const;
+    bool closed() const;
+    boost::asio::io_context& io_service() const;
+
+private:
+    struct State {
+        State(const nghttp2::asio_http2::server::response& res);
+
+        const nghttp2::asio_http2::server::response& res;
+        boost::asio::io_context& io;
+        std::atomic<bool> closed = false;
+        unsigned int statusCode = 0;
+        nghttp2::asio_http2::header_map headers;
+        bool compressionEnabled = false;
+        ContentCoding coding = ContentCoding::Identity;
+        std::size_t compressionThreshold = 0;
+
+        bool hasBody() const;
+        bool mayVary() const;
+        void writeHead(const bool compressed, const bool varies);
+    };
+    std::shared_ptr<State> m_state;
+
+    void dispatch(std::function<void()> send) const;
+};
+}
@@ -25,6 +25,7 @@ EventStream::EventStream(const server::request& req,
                          Termination& termination,
                          EventSignal& signal,
                          const std::chrono::seconds keepAlivePingInterval,
+                         const bool compression,
                          const std::optional<std::string>& initialEvent,
                          const std::function<void()>& onTerminationCb,
                          const std::function<void()>& onClientDisconnectedCb)
@@ -34,6 +35,9 @@ EventStream::EventStream(const server::request& req,
     , m_keepAlivePingInterval(keepAlivePingInterval)
     , onTerminationCb(onTerminationCb)
     , onClientDisconnectedCb(onClientDisconnectedCb)
+    , m_compression(compression)
+    , m_coding(compression ? chooseContentCoding(getHeaderValue(req.header(), "accept-encoding").value_or("")) : ContentCoding::Identity)
+    , m_compressor(m_coding == ContentCoding::Identity ? nullptr : std::make_unique<Compressor>(m_coding))
 {
     if (initialEvent) {
         enqueue(FIELD_DATA, *initialEvent);
@@ -75,10 +79,18 @@ void EventStream::activate()
     start_ping();
 
     auto myself = shared_from_this();
-    res.write_head(200, {
+    header_map headers{
         {"content-type", {"text/event-stream", false}},
         {"access-control-allow-origin", {"*", false}},
-    });
+    };
+    if (auto coding = contentCodingName(m_coding)) {
+        headers.emplace("content-encoding", header_value{*coding, false});
+    }
+    if (m_compression) {
+        // the stream has no end, so it is always big enough to be compressed for a client which accepts that
+        headers.emplace("vary", header_value{"accept-encoding", false});
+    }
+    res.write_head(200, headers);
 
     res.on_close([myself](const auto ec) {
         spdlog::debug("{}: closed ({})", myself->peer, nghttp2_http2_strerror(ec));
@@ -101,10 +113,9 @@ void EventStream::activate()
     });
 }
 
-size_t EventStream::send_chunk(uint8_t* destination, std::size_t len, uint32_t* data_flags [[maybe_unused]])
+std::size_t EventStream::copy_queued(uint8_t* destination, std::size_t len)
 {
     std::size_t written{0};
-    if (state != HasEvents) throw std::logic_error{std::to_string(__LINE__)};
     while (!queue.empty()) {
         auto num = std::min(queue.front().size(), len - written);
         std::copy_n(queue.front().begin(), num, destination + written);
@@ -117,7 +128,16 @@ size_t EventStream::send_chunk(uint8_t* destination, std::size_t len, uint32_t*
         queue.pop_front();
         spdlog::debug("{}: sent one event", peer);
     }
-    state = WaitingForEvents;
+    return written;
+}
+
+size_t EventStream::send_chunk(uint8_t* destination, std::size_t len, uint32_t* data_flags [[maybe_unused]])
+{
+    if (state != HasEvents) throw std::logic_error{std::to_string(__LINE__)};
+    auto written = copy_queued(destination, len);
+    if (queue.empty()) {
+        state = WaitingForEvents;
+    }
     return written;
 }
 
@@ -131,6 +151,15 @@ ssize_t EventStream::process(uint8_t* destination, std::size_t len, uint32_t* da
         spdlog::trace("{}: sleeping", peer);
         return NGHTTP2_ERR_DEFERRED;
     case WantToClose:
+        if (m_compressor) {
+            // Each chunk of a compressed stream depends on the previous ones, so the events which are still queued
+            // have to be sent as well. Then the stream has to be terminated properly.
+            queue.push_back(m_compressor->finish());
+            m_compressor.reset();
+        }
+        if (m_coding != ContentCoding::Identity && !queue.empty()) {
+            return copy_queued(destination, len);
+        }
         *data_flags |= NGHTTP2_DATA_FLAG_EOF;
         return 0;
     case Closed:
@@ -162,7 +191,12 @@ void EventStream::enqueue(const std::string& fieldName, const std::string& what)
             return a + b.size();
             });
     spdlog::trace("{}: new event, ∑ queue size = {}", peer, len);
-    queue.push_back(buf);
+    if (m_compressor) {
+        // flushing after each event makes it possible to decode the event right away
+        queue.push_back(m_compressor->compress(buf) + m_compressor->flush());
+    } else {
+        queue.push_back(buf);
+    }
     state = HasEvents;
     boost::asio::post(res.io_service(), [weak = weak_from_this()]() {
         auto myself = weak.lock();
@@ -216,11 +250,12 @@ std::shared_ptr<EventStream> EventStream::create(const nghttp2::asio_http2::serv
                                                  Termination& terminate,
                                                  EventSignal& signal,
                                                  const std::chrono::seconds keepAlivePingInterval,
+                                                 const bool compression,
                                                  const std::optional<std::string>& initialEvent,
                                                  const std::function<void()>& onTerminationCb,
                                                  const std::function<void()>& onClientDisconnectedCb)
 {
-    auto stream = std::shared_ptr<EventStream>(new EventStream(req, res, terminate, signal, keepAlivePingInterval, initialEvent, onTerminationCb, onClientDisconnectedCb));
+    auto stream = std::shared_ptr<EventStream>(new EventStream(req, res, terminate, signal, keepAlivePingInterval, compression, initialEvent, onTerminationCb, onClientDisconnectedCb));
     stream->activate();
     return stream;
 }
@@ -13,6 +13,7 @@
 #include <memory>
 #include <optional>
 #include <spdlog/spdlog.h>
+#include "http/Compression.h"
 
 namespace nghttp2::asio_http2::server {
 class request;
@@ -25,6 +26,10 @@ namespace rousette::http {
 /** @short Event delivery via text/event-stream
 
 Recieve data from an EventSignal, and deliver them to an HTTP client via a text/event-stream streamed response.
+
+When compression is enabled and the client accepts a compressed response, the whole stream is compressed by a single compressor, so that the
+repetitive bits of the events are shared across the entire stream. The compressor is flushed after each event, which
+means that the client can decode each event as soon as it arrives.
 */
 class EventStream : public std::enable_shared_from_this<EventStream> {
 public:
@@ -36,6 +41,7 @@ public:
                                                Termination& terminate,
                                                EventSignal& signal,
                                                const std::chrono::seconds keepAlivePingInterval,
+                                               const bool compression,
                                                const std::optional<std::string>& initialEvent = std::nullopt,
                                                const std::function<void()>& onTerminationCb = std::function<void()>(),
                                                const std::function<void()>& onClientDisconnectedCb = std::function<void()>());
@@ -58,7 +64,11 @@ private:
     const std::chrono::seconds m_keepAlivePingInterval;
     std::function<void()> onTerminationCb; ///< optional callback when the stream is terminated
     std::function<void()> onClientDisconnectedCb; ///< optional callback invoked in client.on_close()
+    const bool m_compression;
+    const ContentCoding m_coding;
+    std::unique_ptr<Compressor> m_compressor; ///< Protected by `mtx`, only set while the compressed stream has not been finished yet
 
+    std::size_t copy_queued(uint8_t* destination, std::size_t len);
     size_t send_chunk(uint8_t* destination, std::size_t len, uint32_t* data_flags);
     ssize_t process(uint8_t* destination, std::size_t len, uint32_t* data_flags);
     void enqueue(const std::string& fieldName, const std::string& what);
@@ -70,6 +80,7 @@ protected:
                 Termination& terminate,
                 EventSignal& signal,
                 const std::chrono::seconds keepAlivePingInterval,
+                const bool compression,
                 const std::optional<std::string>& initialEvent = std::nullopt,
                 const std::function<void()>& onTerminationCb = std::function<void()>(),
                 const std::function<void()>& onClientDisconnectedCb = std::function<void()>());
@@ -0,0 +1,176 @@
+/*
+ * Copyright (C) 2026 CESNET, https://photonics.cesnet.cz/
+ *
+ * Written by Jan Kundrát <jan.kundrat@cesnet.cz>
+ *
+*/
+
+#include <array>
+#include <boost/asio/connect.hpp>
+#include <boost/asio/local/stream_protocol.hpp>
+#include <boost/asio/write.hpp>
+#include <spdlog/spdlog.h>
+#include <sys/stat.h>
+#include <system_error>
+#include <unistd.h>
+#include "http/SocketRelay.h"
+
+namespace rousette::http {
+
+namespace {
+/** @short One accepted connection along with its TCP counterpart */
+struct Connection : public std::enable_shared_from_this<Connection> {
+    Connection(boost::asio::generic::stream_protocol::socket&& client, const std::optional<ucred>& credentials, std::shared_ptr<SocketRelay::Peers> peers)
+        : client(std::move(client))
+        , upstream(this->client.get_executor())
+        , credentials(credentials)
+        , peers(std::move(peers))
+    {
+    }
+
+    ~Connection()
+    {
+        if (endpoint) {
+            std::lock_guard lock{peers->mutex};
+            peers->credentials.erase(*endpoint);
+        }
+    }
+
+    void start(const boost::asio::ip::tcp::endpoint& server)
+    {
+        upstream.async_connect(server, [self = shared_from_this()](const boost::system::error_code& ec) {
+            if (ec) {
+                spdlog::error("Socket relay: cannot connect to the HTTP server: {}", ec.message());
+                self->close();
+                return;
+            }
+
+            // the peer has to be known before the HTTP server gets to see any data
+            if (self->credentials) {
+                self->endpoint = self->upstream.local_endpoint();
+                std::lock_guard lock{self->peers->mutex};
+                self->peers->credentials[*self->endpoint] = *self->credentials;
+            }
+
+            pump(self, self->client, self->upstream, self->toUpstream);
+            pump(self, self->upstream, self->client, self->toClient);
+        });
+    }
+
+    template <typename From, typename To>
+    static void pump(std::shared_ptr<Connection> self, From& from, To& to, std::array<char, 16384>& buf)
+    {
+        from.async_read_some(boost::asio::buffer(buf), [self, &from, &to, &buf](const boost::system::error_code& ec, std::size_t length) {
+            if (ec) {
+                self->close();
+                return;
+            }
+            boost::asio::async_write(to, boost::asio::buffer(buf, length), [self, &from, &to, &buf](const boost::system::error_code& ec, std::size_t) {
+                if (ec) {
+                    self->close();
+                    return;
+                }
+                pump(self, from, to, buf);
+            });
+        });
+    }
+
+    void close()
+    {
+        boost::system::error_code ignored;
+        client.close(ignored);
+        upstream.close(ignored);
+    }
+
+    boost::asio::generic::stream_protocol::socket client;
+    boost::asio::ip::tcp::socket upstream;
+    std::optional<ucred> credentials;
+    std::shared_ptr<SocketRelay::Peers> peers;
+    std::optional<boost::asio::ip::tcp::endpoint> endpoint;
+    std::array<char, 16384> toUpstream, toClient;
+};
+}
+
+/** @short Create a new UNIX socket at the given path */
+SocketRelay::SocketRelay(boost::asio::io_context& io, const std::string& path, const mode_t mode, const boost::asio::ip::tcp::endpoint& server)
+    : m_path(path)
+    , m_name(path)
+    , m_server(server)
+    , m_acceptor(io)
+    , m_peers(std::make_shared<Peers>())
+{
+    // a leftover from a previous run would prevent bind()
+    ::unlink(path.c_str());
+
+    boost::asio::generic::stream_protocol::endpoint endpoint{boost::asio::local::stream_protocol::endpoint{path}};
+    m_acceptor.open(endpoint.protocol());
+    m_acceptor.bind(endpoint);
+    if (::chmod(path.c_str(), mode)) {
+        throw std::system_error{errno, std::system_category(), "chmod " + path};
+    }
+    m_acceptor.listen();
+
+    accept();
+}
+
+/** @short Take over a socket which is already bound and listening */
+SocketRelay::SocketRelay(boost::asio::io_context& io, const int fd, const boost::asio::ip::tcp::endpoint& server)
+    : m_name("fd " + std::to_string(fd))
+    , m_server(server)
+    , m_acceptor(io)
+    , m_peers(std::make_shared<Peers>())
+{
+    sockaddr_storage addr;
+    socklen_t len = sizeof(addr);
+    if (::getsockname(fd, reinterpret_cast<sockaddr*>(&addr), &len)) {
+        throw std::system_error{errno, std::system_category(), "getsockname " + m_name};
+    }
+    m_acceptor.assign(boost::asio::generic::stream_protocol{addr.ss_family, 0}, fd);
+
+    accept();
+}
+
+SocketRelay::~SocketRelay()
+{
+    boost::system::error_code ignored;
+    m_acceptor.close(ignored);
+    if (m_path) {
+        ::unlink(m_path->c_str());
+    }
+}
+
+void SocketRelay::accept()
+{
+    m_acceptor.async_accept([this](const boost::system::error_code& ec, boost::asio::generic::stream_protocol::socket client) {
+        if (ec == boost::asio::error::operation_aborted) {
+            return;
+        }
+
+        if (ec) {
+            spdlog::warn("{}: accept: {}", m_name, ec.message());
+        } else if (client.local_endpoint().protocol().family() == AF_UNIX) {
+            ucred credentials;
+            socklen_t len = sizeof(credentials);
+            if (::getsockopt(client.native_handle(), SOL_SOCKET, SO_PEERCRED, &credentials, &len)) {
+                spdlog::warn("{}: cannot obtain peer credentials: {}", m_name, std::system_category().message(errno));
+            } else {
+                std::make_shared<Connection>(std::move(client), credentials, m_peers)->start(m_server);
+            }
+        } else {
+            std::make_shared<Connection>(std::move(client), std::nullopt, m_peers)->start(m_server);
+        }
+
+        accept();
+    });
+}
+
+/** @short Credentials of the process which is connected to the HTTP server through this relay from the given TCP endpoint */
+std::optional<ucred> SocketRelay::peer(const boost::asio::ip::tcp::endpoint& endpoint) const
+{
+    std::lock_guard lock{m_peers->mutex};
+    if (auto it = m_peers->credentials.find(endpoint); it != m_peers->credentials.end()) {
+        return it->second;
+    }
+    return std::nullopt;
+}
+}
@@ -0,0 +1,53 @@
+/*
+ * Copyright (C) 2026 CESNET, https://photonics.cesnet.cz/
+ *
+ * Written by Jan Kundrát <jan.kundrat@cesnet.cz>
+ *
+*/
+
+#pragma once
+
+#include <boost/asio/generic/stream_protocol.hpp>
+#include <boost/asio/ip/tcp.hpp>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <sys/socket.h>
+#include <sys/types.h>
+
+namespace rousette::http {
+
+/** @short Accept connections on an additional socket and pass them to the HTTP server's TCP listener
+
+nghttp2-asio can only serve connections which were accepted by its own TCP acceptors. This listens on another socket,
+either on a newly created UNIX socket (so that the usual file permissions control who may connect), or on an already
+listening socket which was passed from the outside (e.g., via systemd's socket activation). For each accepted connection
+it opens a TCP connection to the server and shuffles the bytes in both directions.
+
+For UNIX sockets, the credentials of the connecting process (SO_PEERCRED) are remembered for as long as the connection
+lasts. They can be looked up through the TCP endpoint which the HTTP server sees as the remote side of the connection.
+*/
+class SocketRelay {
+public:
+    SocketRelay(boost::asio::io_context& io, const std::string& path, const mode_t mode, const boost::asio::ip::tcp::endpoint& server);
+    SocketRelay(boost::asio::io_context& io, const int fd, const boost::asio::ip::tcp::endpoint& server);
+    ~SocketRelay();
+
+    std::optional<ucred> peer(const boost::asio::ip::tcp::endpoint& endpoint) const;
+
+    struct Peers {
+        mutable std::mutex mutex;
+        std::map<boost::asio::ip::tcp::endpoint, ucred> credentials;
+    };
+
+private:
+    std::optional<std::string> m_path; ///< Only set when this relay has created the UNIX socket
+    std::string m_name;
+    boost::asio::ip::tcp::endpoint m_server;
+    boost::asio::generic::stream_protocol::acceptor m_acceptor;
+    std::shared_ptr<Peers> m_peers;
+
+    void accept();
+};
+}
@@ -9,6 +9,11 @@
 #include <boost/fusion/adapted/struct/adapt_struct.hpp>
 #include <boost/lexical_cast.hpp>
 #include <boost/spirit/home/x3.hpp>
+#include <algorithm>
+#include <cstdio>
+#include <ctime>
+#include <iomanip>
+#include <sstream>
 #include "http/utils.hpp"
 
 namespace {
@@ -185,4 +190,66 @@ std::optional<std::string> parseUrlPrefix(const nghttp2::asio_http2::header_map&
 
     return std::nullopt;
 }
+
+/** @short The IMF-fixdate format of RFC 9110 (such as "Sun, 06 Nov 1994 08:49:37 GMT"), as used by Last-Modified */
+std::string formatHttpDate(const std::chrono::system_clock::time_point time)
+{
+    const auto t = std::chrono::system_clock::to_time_t(time);
+    std::tm tm;
+    gmtime_r(&t, &tm);
+
+    // not using std::put_time because the names of days and months must not be localized
+    static const char* days[] = {"Sun", "Mon", "Tue", "Wed", "Thu", "Fri", "Sat"};
+    static const char* months[] = {"Jan", "Feb", "Mar", "Apr", "May", "Jun", "Jul", "Aug", "Sep", "Oct", "Nov", "Dec"};
+    char buf[32];
+    std::snprintf(buf, sizeof(buf), "%s, %02d %s %04d %02d:%02d:%02d GMT", days[tm.tm_wday], tm.tm_mday, months[tm.tm_mon], tm.tm_year + 1900, tm.tm_hour, tm.tm_min, tm.tm_sec);
+    return buf;
+}
+
+/** @short Parse a date in the IMF-fixdate format; RFC 9110 allows ignoring invalid (and obsolete) date formats */
+std::optional<std::chrono::system_clock::time_point> parseHttpDate(const std::string& headerValue)
+{
+    std::tm tm{};
+    std::istringstream iss{headerValue};
+    iss.imbue(std::locale::classic());
+    iss >> std::get_time(&tm, "%a, %d %b %Y %H:%M:%S GMT");
+    if (iss.fail()) {
+        return std::nullopt;
+    }
+    return std::chrono::system_clock::from_time_t(timegm(&tm));
+}
+
+/** @short Split the value of an If-Match or If-None-Match header into individual entity tags */
+std::vector<std::string> parseEntityTagList(const std::string& headerValue)
+{
+    std::vector<std::string> res;
+    std::string_view rest{headerValue};
+    while (!rest.empty()) {
+        auto comma = rest.find(',');
+        auto item = rest.substr(0, comma);
+        rest = comma == std::string_view::npos ? std::string_view{} : rest.substr(comma + 1);
+
+        item.remove_prefix(std::min(item.find_first_not_of(" \t"), item.size()));
+        item.remove_suffix(item.size() - std::min(item.find_last_not_of(" \t") + 1, item.size()));
+        if (!item.empty()) {
+            res.emplace_back(item);
+        }
+    }
+    return res;
+}
+
+/** @short Is the @p entityTag listed in an If-Match or If-None-Match header?
+ *
+ * The wildcard "*" is not handled here because it is not about any particular entity tag.
+ */
+bool entityTagListContains(const std::string& headerValue, const std::string& entityTag, const bool weakComparison)
+{
+    auto opaque = [](std::string_view tag) {
+        return tag.starts_with("W/") ? tag.substr(2) : tag;
+    };
+
+    return std::ranges::any_of(parseEntityTagList(headerValue), [&](const std::string& item) {
+        return weakComparison ? opaque(item) == opaque(entityTag) : (!item.starts_with("W/") && item == entityTag);
+    });
+}
 }
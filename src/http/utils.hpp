@@ -5,6 +5,7 @@
  *
  */
 
+#include <chrono>
 #include <nghttp2/asio_http2_server.h>
 #include <optional>
 
@@ -22,4 +23,8 @@ std::vector<std::string> parseAcceptHeader(const std::string& headerValue);
 ProtoAndHost parseForwardedHeader(const std::string& headerValue);
 std::optional<std::string> parseUrlPrefix(const nghttp2::asio_http2::header_map& headers);
 std::optional<std::string> getHeaderValue(const nghttp2::asio_http2::header_map& headers, const std::string& header);
+std::string formatHttpDate(const std::chrono::system_clock::time_point time);
+std::optional<std::chrono::system_clock::time_point> parseHttpDate(const std::string& headerValue);
+std::vector<std::string> parseEntityTagList(const std::string& headerValue);
+bool entityTagListContains(const std::string& headerValue, const std::string& entityTag, const bool weakComparison);
 }
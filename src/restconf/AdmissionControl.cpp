@@ -0,0 +1,92 @@
+/*
+ * Copyright (C) 2026 CESNET, https://photonics.cesnet.cz/
+ *
+ * Written by Jan Kundrát <jan.kundrat@cesnet.cz>
+ *
+*/
+
+#include <libyang-cpp/Context.hpp>
+#include <spdlog/spdlog.h>
+#include "restconf/AdmissionControl.h"
+#include "restconf/uri.h"
+
+namespace rousette::restconf {
+
+AdmissionControl::Ticket::Ticket(std::shared_ptr<std::atomic<std::size_t>> counter)
+    : m_counter(std::move(counter))
+{
+}
+
+AdmissionControl::Ticket::~Ticket()
+{
+    if (m_counter) {
+        --*m_counter;
+    }
+}
+
+AdmissionControl::AdmissionControl(const std::map<RequestClass, std::size_t>& limits)
+{
+    for (const auto& [requestClass, max] : limits) {
+        m_limits.emplace(requestClass, Limit{max, std::make_shared<std::atomic<std::size_t>>(0)});
+    }
+}
+
+/** @short Estimate the cost of a request from its type, the target datastore, the path and the depth */
+AdmissionControl::RequestClass AdmissionControl::classify(const libyang::Context& ctx, const RestconfRequest& request)
+{
+    switch (request.type) {
+    case RestconfRequest::Type::RestconfRoot:
+    case RestconfRequest::Type::YangLibraryVersion:
+    case RestconfRequest::Type::ListRPC:
+    case RestconfRequest::Type::OptionsQuery:
+        return RequestClass::Cheap;
+    case RestconfRequest::Type::CreateOrReplaceThisNode:
+    case RestconfRequest::Type::CreateChildren:
+    case RestconfRequest::Type::MergeData:
+    case RestconfRequest::Type::DeleteNode:
+        return RequestClass::Edit;
+    case RestconfRequest::Type::Execute:
+    case RestconfRequest::Type::ExecuteInternal:
+        return RequestClass::Rpc;
+    case RestconfRequest::Type::GetData:
+        break;
+    }
+
+    if (auto it = request.queryParams.find("depth"); it != request.queryParams.end() && std::holds_alternative<unsigned int>(it->second) && std::get<unsigned int>(it->second) == 1) {
+        return RequestClass::Cheap;
+    }
+
+    if (request.path == "/*") {
+        return RequestClass::DatastoreDump;
+    }
+
+    try {
+        if (auto nodeType = ctx.findPath(request.path).nodeType(); nodeType == libyang::NodeType::Leaf || nodeType == libyang::NodeType::Leaflist) {
+            return RequestClass::Cheap;
+        }
+    } catch (const libyang::Error& e) {
+        spdlog::trace("Cannot classify request for {}: {}", request.path, e.what());
+    }
+
+    return request.datastore.value_or(sysrepo::Datastore::Operational) == sysrepo::Datastore::Operational ? RequestClass::OperationalRead : RequestClass::ConfigurationRead;
+}
+
+/** @short Try to reserve a slot for a request of the given class, returns nullopt if the class is already at its limit */
+std::optional<AdmissionControl::Ticket> AdmissionControl::admit(const RequestClass requestClass)
+{
+    auto it = m_limits.find(requestClass);
+    if (it == m_limits.end()) {
+        return Ticket{};
+    }
+
+    auto& [max, current] = it->second;
+    auto value = current->load();
+    do {
+        if (value >= max) {
+            return std::nullopt;
+        }
+    } while (!current->compare_exchange_weak(value, value + 1));
+
+    return Ticket{current};
+}
+}
@@ -0,0 +1,65 @@
+/*
+ * Copyright (C) 2026 CESNET, https://photonics.cesnet.cz/
+ *
+ * Written by Jan Kundrát <jan.kundrat@cesnet.cz>
+ *
+*/
+
+#pragma once
+
+#include <atomic>
+#include <map>
+#include <memory>
+#include <optional>
+
+namespace libyang {
+class Context;
+}
+
+namespace rousette::restconf {
+
+struct RestconfRequest;
+
+/** @short Limits the number of expensive requests which are processed at once
+ *
+ * Requests are sorted into classes according to their expected cost. Each class has its own limit of requests which can
+ * be processed concurrently, and the excess requests are rejected right away, before they get to occupy any worker.
+ * Cheap requests are never limited, so they keep flowing even when, e.g., many clients ask for a full datastore dump.
+ * */
+class AdmissionControl {
+public:
+    enum class RequestClass {
+        Cheap, ///< API metadata, OPTIONS, reads of a single leaf or with depth=1
+        DatastoreDump, ///< Reading a complete datastore
+        OperationalRead, ///< Reading a subtree of the operational datastore
+        ConfigurationRead, ///< Reading a subtree of a configuration datastore
+        Edit, ///< Changes to any datastore
+        Rpc, ///< RPCs and actions
+    };
+
+    /** @short Permission to process a request, the slot is released upon destruction */
+    class Ticket {
+    public:
+        Ticket() = default;
+        explicit Ticket(std::shared_ptr<std::atomic<std::size_t>> counter);
+        Ticket(Ticket&& other) = default;
+        Ticket& operator=(Ticket&& other) = delete;
+        ~Ticket();
+
+    private:
+        std::shared_ptr<std::atomic<std::size_t>> m_counter; ///< Null when this ticket does not occupy any slot
+    };
+
+    AdmissionControl(const std::map<RequestClass, std::size_t>& limits);
+
+    static RequestClass classify(const libyang::Context& ctx, const RestconfRequest& request);
+    std::optional<Ticket> admit(const RequestClass requestClass);
+
+private:
+    struct Limit {
+        std::size_t max;
+        std::shared_ptr<std::atomic<std::size_t>> current;
+    };
+    std::map<RequestClass, Limit> m_limits; ///< Classes without an entry are not limited
+};
+}
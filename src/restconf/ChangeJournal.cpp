@@ -0,0 +1,266 @@
+/*
+ * Copyright (C) 2026 CESNET, https://photonics.cesnet.cz/
+ *
+ * Written by Jan Kundrát <jan.kundrat@cesnet.cz>
+ *
+*/
+
+#include <algorithm>
+#include <chrono>
+#include <libyang-cpp/Context.hpp>
+#include <spdlog/spdlog.h>
+#include <sysrepo-cpp/Changes.hpp>
+#include <sysrepo-cpp/Session.hpp>
+#include <sysrepo-cpp/utils/exception.hpp>
+#include "restconf/ChangeJournal.h"
+#include "restconf/Exceptions.h"
+#include "restconf/utils/yang.h"
+
+namespace rousette::restconf {
+
+namespace {
+/** @short Does the @p path refer to a node below the node at @p prefix? */
+bool isBelow(const std::string& path, const std::string& prefix)
+{
+    return path.size() > prefix.size() && path.starts_with(prefix) && path[prefix.size()] == '/';
+}
+
+/** @short Where in a user-ordered list was the entry placed, as RFC 8072's "where" and "point" */
+void setPosition(const libyang::Context& ctx, ChangeJournal::Edit& edit, const sysrepo::Change& change)
+{
+    std::optional<std::string> predicate;
+    if (change.node.schema().nodeType() == libyang::NodeType::List && change.previousList) {
+        predicate = std::string{*change.previousList};
+    } else if (change.node.schema().nodeType() == libyang::NodeType::Leaflist && change.previousValue) {
+        predicate = std::string{*change.previousValue};
+        if (!predicate->empty()) {
+            predicate = leaflistKeyPredicate(*predicate);
+        }
+    }
+
+    if (!predicate) {
+        return;
+    }
+    if (predicate->empty()) {
+        edit.where = "first";
+        return;
+    }
+
+    // the preceding entry is known just by its keys, so build a node for it in order to get its full path
+    const auto parentPath = change.node.parent() ? change.node.parent()->path() : std::string{};
+    auto preceding = ctx.newPath2(parentPath + '/' + change.node.schema().module().name() + ':' + change.node.schema().name() + *predicate);
+    edit.where = "after";
+    edit.point = asRestconfPath(*preceding.createdNode);
+}
+
+std::string asToken(const std::string& instance, const uint64_t revision)
+{
+    return fmt::format("{}-{:x}", instance, revision);
+}
+}
+
+ChangeJournal::ChangeJournal(sysrepo::Connection conn, const std::size_t maxEdits)
+    : m_maxEdits(maxEdits)
+    , m_instance(fmt::format("{:x}", std::chrono::system_clock::now().time_since_epoch().count()))
+{
+    for (const auto datastore : {sysrepo::Datastore::Running, sysrepo::Datastore::Startup}) {
+        auto session = conn.sessionStart(datastore);
+        std::optional<sysrepo::Subscription> sub;
+
+        for (const auto& mod : session.getContext().modules()) {
+            if (!mod.implemented() || mod.name() == "sysrepo") {
+                continue;
+            }
+
+            sysrepo::ModuleChangeCb cb = [this](auto session, auto, auto module, auto, auto, auto) {
+                record(session, std::string{module});
+                return sysrepo::ErrorCode::Ok;
+            };
+            try {
+                if (sub) {
+                    sub->onModuleChange(mod.name(), cb, std::nullopt, 0, sysrepo::SubscribeOptions::DoneOnly | sysrepo::SubscribeOptions::Passive);
+                } else {
+                    sub = session.onModuleChange(mod.name(), cb, std::nullopt, 0, sysrepo::SubscribeOptions::DoneOnly | sysrepo::SubscribeOptions::Passive);
+                }
+            } catch (sysrepo::ErrorWithCode& e) {
+                // nothing to listen for in modules without any configuration data
+                if (e.code() == sysrepo::ErrorCode::NotFound) {
+                    continue;
+                }
+                throw;
+            }
+        }
+
+        if (sub) {
+            m_subscriptions.emplace_back(std::move(*sub));
+        }
+    }
+}
+
+void ChangeJournal::record(sysrepo::Session session, const std::string& module)
+{
+    const auto datastore = session.activeDatastore();
+    std::vector<Edit> edits;
+    // sysrepo reports every node of a created or deleted subtree, but the edit of the subtree's root covers all of them
+    std::vector<std::string> subtrees;
+
+    for (const auto& change : session.getChanges("/" + module + ":*//.")) {
+        const auto path = change.node.path();
+        if (std::any_of(subtrees.begin(), subtrees.end(), [&path](const auto& subtree) { return isBelow(path, subtree); })) {
+            continue;
+        }
+
+        Edit edit{
+            .datastore = datastore,
+            .target = asRestconfPath(change.node),
+            .path = path,
+            .parentPath = change.node.parent() ? std::optional{change.node.parent()->path()} : std::nullopt,
+            .hasValue = change.operation == sysrepo::ChangeOperation::Created || change.operation == sysrepo::ChangeOperation::Modified,
+        };
+        switch (change.operation) {
+        case sysrepo::ChangeOperation::Created:
+            setPosition(session.getContext(), edit, change);
+            edit.operation = edit.where ? "insert" : "create";
+            subtrees.emplace_back(path);
+            break;
+        case sysrepo::ChangeOperation::Deleted:
+            edit.operation = "delete";
+            subtrees.emplace_back(path);
+            break;
+        case sysrepo::ChangeOperation::Modified:
+            edit.operation = "replace";
+            break;
+        case sysrepo::ChangeOperation::Moved:
+            setPosition(session.getContext(), edit, change);
+            edit.operation = "move";
+            break;
+        }
+        edits.emplace_back(std::move(edit));
+    }
+
+    std::lock_guard lock{m_mutex};
+    ++m_revision;
+    for (auto& edit : edits) {
+        edit.id = ++m_lastEditId;
+        edit.revision = m_revision;
+        m_edits.emplace_back(std::move(edit));
+    }
+    while (m_edits.size() > m_maxEdits) {
+        m_forgotten = m_edits.front().revision;
+        m_edits.pop_front();
+    }
+    spdlog::trace("Change journal: revision {} of {} has {} edits", m_revision, module, edits.size());
+}
+
+/** @short Edits of the datastore which happened after the @p revision, or nullopt if they are not known
+ *
+ * When no revision is given, there are no edits, just the current revision.
+ *
+ * @pre m_mutex is held
+ */
+std::optional<ChangeJournal::Delta> ChangeJournal::since(const sysrepo::Datastore datastore, const std::optional<std::string>& revision) const
+{
+    Delta res{asToken(m_instance, m_revision), {}};
+    if (!revision) {
+        return res;
+    }
+
+    const auto prefix = m_instance + '-';
+    if (!revision->starts_with(prefix)) {
+        return std::nullopt;
+    }
+    uint64_t seen;
+    try {
+        std::size_t end;
+        seen = std::stoull(revision->substr(prefix.size()), &end, 16);
+        if (end != revision->size() - prefix.size()) {
+            return std::nullopt;
+        }
+    } catch (const std::logic_error&) {
+        return std::nullopt;
+    }
+    if (seen < m_forgotten || seen > m_revision) {
+        return std::nullopt;
+    }
+
+    for (const auto& edit : m_edits) {
+        if (edit.revision > seen && edit.datastore == datastore) {
+            res.edits.emplace_back(edit);
+        }
+    }
+    return res;
+}
+
+/** @short The rousette:changes-since RPC
+ *
+ * The journal does not evaluate any NACM rules on its own. The changed nodes are read from the datastore on behalf of
+ * the session's NACM user instead, so sysrepo filters them exactly as it filters a GET of the same data. This means that
+ * the edits come with the current content of their targets rather than with the content they had back then; applying
+ * the edits in order leads to the current data all the same. The edits of nodes which the user cannot read (or which
+ * are gone already) are left out.
+ *
+ * A deleted node cannot be read anymore, so there is no telling whether the user could read it. Users other than the
+ * NACM recovery user therefore have to read the data again when the changes include a deletion below some node which
+ * they can read.
+ */
+void ChangeJournal::changesSince(sysrepo::Session& session, const std::optional<std::string>&, const libyang::DataFormat, const libyang::DataNode& rpcInput, libyang::DataNode& rpcOutput) const
+{
+    auto datastore = sysrepo::Datastore::Running;
+    if (auto node = rpcInput.findPath("datastore"); node && node->asTerm().valueStr() == "startup") {
+        datastore = sysrepo::Datastore::Startup;
+    }
+    std::optional<std::string> revision;
+    if (auto node = rpcInput.findPath("revision")) {
+        revision = node->asTerm().valueStr();
+    }
+
+    std::optional<Delta> delta;
+    {
+        std::lock_guard lock{m_mutex};
+        delta = since(datastore, revision);
+    }
+    if (!delta) {
+        throw ErrorResponse(410, "application", "operation-failed", "Changes since this revision are not known; the data have to be read again.");
+    }
+
+    auto reader = session.getConnection().sessionStart(datastore);
+    const auto user = session.getNacmUser();
+    if (user) {
+        reader.setNacmUser(*user);
+    }
+    const bool unrestricted = !user || *user == sysrepo::Session::getNacmRecoveryUser();
+    auto readAsUser = [&reader](const std::string& path, const uint32_t maxDepth) -> std::optional<libyang::DataNode> {
+        auto data = reader.getData(path, maxDepth);
+        return data ? data->findPath(path) : std::nullopt;
+    };
+
+    rpcOutput.newPath("revision", delta->revision, libyang::CreationOptions::Output);
+    for (const auto& edit : delta->edits) {
+        std::optional<libyang::DataNode> current;
+        if (edit.operation != "delete") {
+            current = readAsUser(edit.path, 0);
+            if (!current) {
+                continue;
+            }
+        } else if (!unrestricted) {
+            if (!edit.parentPath || readAsUser(*edit.parentPath, 1)) {
+                throw ErrorResponse(410, "application", "operation-failed", "Changes since this revision include a deletion; the data have to be read again.");
+            }
+            continue;
+        }
+
+        const auto prefix = "edit[edit-id='" + std::to_string(edit.id) + "']/";
+        rpcOutput.newPath(prefix + "operation", edit.operation, libyang::CreationOptions::Output);
+        rpcOutput.newPath(prefix + "target", edit.target, libyang::CreationOptions::Output);
+        if (edit.where) {
+            rpcOutput.newPath(prefix + "where", *edit.where, libyang::CreationOptions::Output);
+        }
+        if (edit.point) {
+            rpcOutput.newPath(prefix + "point", *edit.point, libyang::CreationOptions::Output);
+        }
+        if (edit.hasValue) {
+            rpcOutput.newPath2(prefix + "value", current->duplicate(libyang::DuplicationOptions::Recursive | libyang::DuplicationOptions::WithFlags), libyang::CreationOptions::Output);
+        }
+    }
+}
+}
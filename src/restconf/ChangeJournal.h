@@ -0,0 +1,69 @@
+/*
+ * Copyright (C) 2026 CESNET, https://photonics.cesnet.cz/
+ *
+ * Written by Jan Kundrát <jan.kundrat@cesnet.cz>
+ *
+*/
+
+#pragma once
+
+#include <deque>
+#include <libyang-cpp/DataNode.hpp>
+#include <mutex>
+#include <optional>
+#include <sysrepo-cpp/Connection.hpp>
+#include <sysrepo-cpp/Subscription.hpp>
+
+namespace rousette::restconf {
+
+/** @short Remembers recent changes of the configuration datastores
+ *
+ * Clients which keep a copy of the configuration do not have to read all of it again after they reconnect; they can
+ * ask for the edits which happened since the revision they have seen, and apply them in the style of a YANG patch.
+ *
+ * The edits are captured from sysrepo's module change notifications, and each commit (of a single module) bumps the
+ * revision. Only a limited number of edits is kept; once an edit is dropped, clients which have not seen it yet have
+ * to read the data again. The same applies to revisions from a different rousette process, or from before a restart.
+ *
+ * Clients only get the edits of data which their NACM user can read. The journal does not evaluate the NACM rules on its
+ * own; it reads the changed data on behalf of the user, and sysrepo filters them.
+ * */
+class ChangeJournal {
+public:
+    /** @short One edit of the RFC 8072 YANG patch */
+    struct Edit {
+        uint64_t id;
+        uint64_t revision; ///< The commit which this edit was a part of
+        sysrepo::Datastore datastore;
+        std::string operation;
+        std::string target; ///< Data resource identifier, i.e., in the format of RESTCONF URIs
+        std::optional<std::string> where; ///< Position of entries of user-ordered lists
+        std::optional<std::string> point;
+        std::string path; ///< Path of the changed node in the libyang format
+        std::optional<std::string> parentPath;
+        bool hasValue; ///< Does the edit carry the new content of the node, i.e., is the node's subtree included?
+    };
+
+    struct Delta {
+        std::string revision; ///< Token which identifies the current state of the journal
+        std::vector<Edit> edits;
+    };
+
+    ChangeJournal(sysrepo::Connection conn, const std::size_t maxEdits);
+
+    void changesSince(sysrepo::Session& session, const std::optional<std::string>& requestSchemeAndHost, const libyang::DataFormat requestEncoding, const libyang::DataNode& rpcInput, libyang::DataNode& rpcOutput) const;
+
+private:
+    const std::size_t m_maxEdits;
+    const std::string m_instance; ///< Tells apart revisions of different journals
+    mutable std::mutex m_mutex; ///< Protects the edits and the revisions
+    std::deque<Edit> m_edits;
+    uint64_t m_revision = 0;
+    uint64_t m_lastEditId = 0;
+    uint64_t m_forgotten = 0; ///< Edits of this revision and of all older ones might have been dropped
+    std::vector<sysrepo::Subscription> m_subscriptions;
+
+    void record(sysrepo::Session session, const std::string& module);
+    std::optional<Delta> since(const sysrepo::Datastore datastore, const std::optional<std::string>& revision) const;
+};
+}
@@ -0,0 +1,90 @@
+/*
+ * Copyright (C) 2026 CESNET, https://photonics.cesnet.cz/
+ *
+ * Written by Jan Kundrát <jan.kundrat@cesnet.cz>
+ *
+*/
+
+#include <spdlog/spdlog.h>
+#include "restconf/DatastoreMirror.h"
+#include "restconf/ModuleChanges.h"
+#include "restconf/utils/yang.h"
+
+namespace rousette::restconf {
+
+DatastoreMirror::DatastoreMirror(const ModuleChanges& changes, const std::size_t maxEntries)
+    : m_changes(changes)
+    , m_maxEntries(maxEntries)
+{
+}
+
+/** @short The same as sysrepo::Session::getData() with an unlimited depth and default options
+ *
+ * The data come from the copy which belongs to the session's NACM user. Paths which cannot be answered from a single
+ * module's copy (the whole datastore, or paths which do not match anything in the copy) are passed to sysrepo.
+ */
+std::optional<libyang::DataNode> DatastoreMirror::getData(sysrepo::Session& session, const std::string& path, const std::chrono::milliseconds timeout)
+{
+    const auto datastore = session.activeDatastore();
+    const auto module = ModuleChanges::topLevelModule(path);
+    const auto revision = module ? m_changes.revisionOfPath(datastore, path) : std::nullopt;
+    if (!revision) {
+        return session.getData(path, 0, sysrepo::GetOptions::Default, timeout);
+    }
+    // obtained before the data so that a concurrent change cannot go unnoticed
+    const auto nacmRevision = m_changes.nacmRevision();
+
+    const Key key{datastore, *module, session.getNacmUser().value_or("")};
+    bool upToDate = false;
+    {
+        std::lock_guard lock{m_mutex};
+        if (auto it = m_data.find(key); it != m_data.end()) {
+            if (it->second.revision == *revision && it->second.nacmRevision == nacmRevision) {
+                m_lru.splice(m_lru.begin(), m_lru, it->second.lru);
+                if (auto res = it->second.tree ? copyWithParents(*it->second.tree, path) : std::nullopt) {
+                    spdlog::trace("Datastore mirror: hit for {}", path);
+                    return res;
+                }
+                upToDate = true;
+            } else {
+                evict(it);
+            }
+        }
+    }
+
+    if (upToDate) {
+        return session.getData(path, 0, sysrepo::GetOptions::Default, timeout);
+    }
+
+    // sysrepo applies the NACM rules of the session's user
+    auto tree = session.getData("/" + *module + ":*", 0, sysrepo::GetOptions::Default, timeout);
+
+    std::optional<libyang::DataNode> res;
+    {
+        std::lock_guard lock{m_mutex};
+        if (auto it = m_data.find(key); it != m_data.end()) {
+            evict(it);
+        }
+        while (!m_lru.empty() && m_data.size() >= m_maxEntries) {
+            spdlog::trace("Datastore mirror: too many copies, dropping the least recently used one");
+            evict(m_data.find(m_lru.back()));
+        }
+        // the other threads only access the stored tree with the mutex held, and so must this one
+        m_lru.push_front(key);
+        auto& stored = m_data.emplace(key, Copy{tree, *revision, nacmRevision, m_lru.begin()}).first->second;
+        tree.reset();
+        res = stored.tree ? copyWithParents(*stored.tree, path) : std::nullopt;
+    }
+
+    if (res) {
+        return res;
+    }
+    return session.getData(path, 0, sysrepo::GetOptions::Default, timeout);
+}
+
+void DatastoreMirror::evict(std::map<Key, Copy>::iterator it)
+{
+    m_lru.erase(it->second.lru);
+    m_data.erase(it);
+}
+}
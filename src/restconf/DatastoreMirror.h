@@ -0,0 +1,61 @@
+/*
+ * Copyright (C) 2026 CESNET, https://photonics.cesnet.cz/
+ *
+ * Written by Jan Kundrát <jan.kundrat@cesnet.cz>
+ *
+*/
+
+#pragma once
+
+#include <chrono>
+#include <libyang-cpp/DataNode.hpp>
+#include <list>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <sysrepo-cpp/Session.hpp>
+
+namespace rousette::restconf {
+
+class ModuleChanges;
+
+/** @short An in-memory copy of the running and startup datastores
+ *
+ * Configuration datastores change rarely, yet each read used to go all the way to sysrepo. This keeps a copy of the
+ * data of each YANG module and serves reads of these datastores from memory.
+ *
+ * The NACM rules are applied by sysrepo: each NACM user gets their own copy, which is filled lazily through that user's
+ * session upon the first read of a module. A copy is refetched once sysrepo reports a change of its module, or of the
+ * NACM configuration, see ModuleChanges. Once there are too many copies, the least recently used one is dropped.
+ * */
+class DatastoreMirror {
+public:
+    DatastoreMirror(const ModuleChanges& changes, const std::size_t maxEntries);
+
+    std::optional<libyang::DataNode> getData(sysrepo::Session& session, const std::string& path, const std::chrono::milliseconds timeout);
+
+private:
+    struct Key {
+        sysrepo::Datastore datastore;
+        std::string module;
+        std::string user;
+
+        auto operator<=>(const Key&) const = default;
+    };
+
+    struct Copy {
+        std::optional<libyang::DataNode> tree; ///< A nullopt means "no data which this user can read"
+        uint64_t revision;
+        uint64_t nacmRevision;
+        std::list<Key>::iterator lru;
+    };
+
+    const ModuleChanges& m_changes;
+    const std::size_t m_maxEntries;
+    std::mutex m_mutex;
+    std::map<Key, Copy> m_data;
+    std::list<Key> m_lru; ///< The most recently used copy is at the front
+
+    void evict(std::map<Key, Copy>::iterator it);
+};
+}
@@ -99,11 +99,13 @@ sysrepo::DynamicSubscription makeStreamSubscription(sysrepo::Session& session, c
 
 namespace rousette::restconf {
 
-DynamicSubscriptions::DynamicSubscriptions(const std::string& streamRootUri, const nghttp2::asio_http2::server::http2& server, const std::chrono::seconds inactivityTimeout)
+DynamicSubscriptions::DynamicSubscriptions(const std::string& streamRootUri, const nghttp2::asio_http2::server::http2& server, const std::chrono::seconds inactivityTimeout, const std::optional<uint8_t> instanceId)
     : m_restconfStreamUri(streamRootUri)
     , m_server(server)
     , m_uuidGenerator(boost::uuids::random_generator())
     , m_inactivityTimeout(inactivityTimeout)
+    , m_nextIoService(0)
+    , m_instanceId(instanceId)
 {
 }
 
@@ -140,7 +142,7 @@ void DynamicSubscriptions::establishSubscription(sysrepo::Session& session, cons
             dataFormat,
             uuid,
             *session.getNacmUser(),
-            *m_server.io_services().at(0),
+            nextIoService(),
             m_inactivityTimeout,
             [this, subId = sub.subscriptionId()]() { terminateSubscription(subId); });
     } catch (const sysrepo::ErrorWithCode& e) {
@@ -168,7 +170,11 @@ void DynamicSubscriptions::deleteSubscription(sysrepo::Session& session, [[maybe
     }
 
     spdlog::debug("Terminating subscription id {}", subId);
-    subscriptionData->subscription.terminate("ietf-subscribed-notifications:no-such-subscription");
+    {
+        // the subscription's event processing might be running in another thread
+        std::lock_guard subLock(subscriptionData->mutex);
+        subscriptionData->subscription.terminate("ietf-subscribed-notifications:no-such-subscription");
+    }
 
     std::unique_lock lock(m_mutex);
     m_subscriptions.erase(subscriptionData->uuid);
@@ -189,7 +195,10 @@ void DynamicSubscriptions::terminateSubscription(const uint32_t subId)
 
     const auto& [uuid, subscriptionData] = *it;
     spdlog::debug("{}: termination requested", fmt::streamed(*subscriptionData));
-    subscriptionData->terminate("ietf-subscribed-notifications:no-such-subscription");
+    {
+        std::lock_guard subLock(subscriptionData->mutex);
+        subscriptionData->terminate("ietf-subscribed-notifications:no-such-subscription");
+    }
     m_subscriptions.erase(uuid);
 }
 
@@ -226,11 +235,28 @@ std::shared_ptr<DynamicSubscriptions::SubscriptionData> DynamicSubscriptions::ge
     return nullptr;
 }
 
+/** @brief Picks the io_context for the subscription's timers so that the subscriptions are spread across all server threads */
+boost::asio::io_context& DynamicSubscriptions::nextIoService()
+{
+    const auto& ioServices = m_server.io_services();
+    return *ioServices.at(m_nextIoService++ % ioServices.size());
+}
+
+/** @short Generate a new random UUID for a subscription
+ *
+ * The subscription only exists in this process. When there are several server processes, the first byte of the UUID
+ * is replaced by the instance ID, i.e., the first two hex digits of the subscription URI identify the process which
+ * has to handle the GET request. A reverse proxy can then route these requests based on the URI prefix.
+ */
 boost::uuids::uuid DynamicSubscriptions::makeUUID()
 {
     // uuid generator instance accesses must be synchronized (https://www.boost.org/doc/libs/1_88_0/libs/uuid/doc/html/uuid.html#design_notes)
     std::lock_guard lock(m_mutex);
-    return m_uuidGenerator();
+    auto uuid = m_uuidGenerator();
+    if (m_instanceId) {
+        uuid.data[0] = *m_instanceId;
+    }
+    return uuid;
 }
 
 DynamicSubscriptions::SubscriptionData::SubscriptionData(
@@ -357,6 +383,7 @@ DynamicSubscriptionHttpStream::DynamicSubscriptionHttpStream(
     rousette::http::EventStream::Termination& termination,
     std::shared_ptr<rousette::http::EventStream::EventSignal> signal,
     const std::chrono::seconds keepAlivePingInterval,
+    const bool compression,
     const std::shared_ptr<DynamicSubscriptions::SubscriptionData>& subscriptionData)
     : EventStream(
           req,
@@ -364,6 +391,7 @@ DynamicSubscriptionHttpStream::DynamicSubscriptionHttpStream(
           termination,
           *signal,
           keepAlivePingInterval,
+          compression,
           std::nullopt /* no initial event */,
           [this]() {
               std::lock_guard lock(m_subscriptionData->mutex);
@@ -427,10 +455,11 @@ std::shared_ptr<DynamicSubscriptionHttpStream> DynamicSubscriptionHttpStream::cr
     const nghttp2::asio_http2::server::response& res,
     rousette::http::EventStream::Termination& termination,
     const std::chrono::seconds keepAlivePingInterval,
+    const bool compression,
     const std::shared_ptr<DynamicSubscriptions::SubscriptionData>& subscriptionData)
 {
     auto signal = std::make_shared<rousette::http::EventStream::EventSignal>();
-    auto stream = std::shared_ptr<DynamicSubscriptionHttpStream>(new DynamicSubscriptionHttpStream(req, res, termination, signal, keepAlivePingInterval, subscriptionData));
+    auto stream = std::shared_ptr<DynamicSubscriptionHttpStream>(new DynamicSubscriptionHttpStream(req, res, termination, signal, keepAlivePingInterval, compression, subscriptionData));
     stream->activate();
     return stream;
 }
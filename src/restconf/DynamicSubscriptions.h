@@ -67,7 +67,7 @@ public:
         void inactivityCancel();
     };
 
-    DynamicSubscriptions(const std::string& streamRootUri, const nghttp2::asio_http2::server::http2& server, const std::chrono::seconds inactivityTimeout);
+    DynamicSubscriptions(const std::string& streamRootUri, const nghttp2::asio_http2::server::http2& server, const std::chrono::seconds inactivityTimeout, const std::optional<uint8_t> instanceId = std::nullopt);
     ~DynamicSubscriptions();
     std::shared_ptr<SubscriptionData> getSubscriptionForUser(const boost::uuids::uuid& uuid, const std::optional<std::string>& user);
     std::shared_ptr<SubscriptionData> getSubscriptionForUser(const uint32_t subId, const std::optional<std::string>& user);
@@ -82,8 +82,11 @@ private:
     std::map<boost::uuids::uuid, std::shared_ptr<SubscriptionData>> m_subscriptions;
     boost::uuids::random_generator m_uuidGenerator;
     std::chrono::seconds m_inactivityTimeout;
+    std::atomic<std::size_t> m_nextIoService; ///< Round-robin counter for spreading subscription timers across io_contexts
+    std::optional<uint8_t> m_instanceId; ///< When running as one of several server processes, this is encoded in the subscription UUIDs
 
     void terminateSubscription(const uint32_t subId);
+    boost::asio::io_context& nextIoService();
 
     boost::uuids::uuid makeUUID();
 };
@@ -102,6 +105,7 @@ public:
         const nghttp2::asio_http2::server::response& res,
         rousette::http::EventStream::Termination& termination,
         const std::chrono::seconds keepAlivePingInterval,
+        const bool compression,
         const std::shared_ptr<DynamicSubscriptions::SubscriptionData>& subscriptionData);
 
 private:
@@ -118,6 +122,7 @@ protected:
         rousette::http::EventStream::Termination& termination,
         std::shared_ptr<rousette::http::EventStream::EventSignal> signal,
         const std::chrono::seconds keepAlivePingInterval,
+        const bool compression,
         const std::shared_ptr<DynamicSubscriptions::SubscriptionData>& subscriptionData);
     void activate();
 };
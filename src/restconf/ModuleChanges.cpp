@@ -0,0 +1,176 @@
+/*
+ * Copyright (C) 2026 CESNET, https://photonics.cesnet.cz/
+ *
+ * Written by Jan Kundrát <jan.kundrat@cesnet.cz>
+ *
+*/
+
+#include <spdlog/spdlog.h>
+#include <sysrepo-cpp/Session.hpp>
+#include <sysrepo-cpp/utils/exception.hpp>
+#include "restconf/ModuleChanges.h"
+
+namespace rousette::restconf {
+
+void ModuleChanges::Changes::bump()
+{
+    lastModified = std::chrono::system_clock::now().time_since_epoch().count();
+    ++revision;
+}
+
+ModuleChanges::ModuleChanges(sysrepo::Connection conn)
+    : m_started(std::chrono::system_clock::now())
+{
+    for (const auto datastore : {sysrepo::Datastore::Running, sysrepo::Datastore::Startup}) {
+        m_datastores[datastore].lastModified = m_started.time_since_epoch().count();
+        auto session = conn.sessionStart(datastore);
+        std::optional<sysrepo::Subscription> sub;
+
+        for (const auto& mod : session.getContext().modules()) {
+            if (!mod.implemented() || mod.name() == "sysrepo") {
+                continue;
+            }
+
+            auto& module = m_modules[{datastore, mod.name()}];
+            module.lastModified = m_started.time_since_epoch().count();
+            sysrepo::ModuleChangeCb cb = [&module, &total = m_datastores.at(datastore)](auto, auto, auto, auto, auto, auto) {
+                module.bump();
+                total.bump();
+                return sysrepo::ErrorCode::Ok;
+            };
+            try {
+                if (sub) {
+                    sub->onModuleChange(mod.name(), cb, std::nullopt, 0, sysrepo::SubscribeOptions::DoneOnly | sysrepo::SubscribeOptions::Passive);
+                } else {
+                    sub = session.onModuleChange(mod.name(), cb, std::nullopt, 0, sysrepo::SubscribeOptions::DoneOnly | sysrepo::SubscribeOptions::Passive);
+                }
+            } catch (sysrepo::ErrorWithCode& e) {
+                // modules without any configuration data have nothing to listen for, and their copies cannot be checked
+                if (e.code() == sysrepo::ErrorCode::NotFound && mod.name() != "ietf-netconf-acm") {
+                    m_modules.erase({datastore, mod.name()});
+                    continue;
+                }
+                throw;
+            }
+        }
+
+        if (sub) {
+            m_subscriptions.emplace_back(std::move(*sub));
+        }
+    }
+
+    spdlog::debug("Watching changes of {} modules in the configuration datastores", m_modules.size());
+}
+
+/** @short Are changes of this datastore tracked at all? */
+bool ModuleChanges::covers(const sysrepo::Datastore datastore)
+{
+    return datastore == sysrepo::Datastore::Running || datastore == sysrepo::Datastore::Startup;
+}
+
+/** @short Name of the module which the top-level node of a libyang path belongs to */
+std::optional<std::string> ModuleChanges::topLevelModule(const std::string& path)
+{
+    if (path.size() < 2 || path[0] != '/') {
+        return std::nullopt;
+    }
+    auto colon = path.find(':');
+    if (colon == std::string::npos || path.find_first_of("/[*", 1) < colon) {
+        return std::nullopt;
+    }
+    return path.substr(1, colon - 1);
+}
+
+/** @short An edit of these modules has just been applied */
+void ModuleChanges::committed(const sysrepo::Datastore datastore, const std::set<std::string>& modules)
+{
+    if (!covers(datastore)) {
+        return;
+    }
+    for (const auto& module : modules) {
+        if (auto it = m_modules.find({datastore, module}); it != m_modules.end()) {
+            it->second.bump();
+        }
+    }
+    m_datastores.at(datastore).bump();
+}
+
+/** @short An edit which might have changed anything in the datastore has just been applied */
+void ModuleChanges::committed(const sysrepo::Datastore datastore)
+{
+    if (!covers(datastore)) {
+        return;
+    }
+    for (auto& [key, changes] : m_modules) {
+        if (key.first == datastore) {
+            changes.bump();
+        }
+    }
+    m_datastores.at(datastore).bump();
+}
+
+/** @short How many times has this module changed, or nullopt if its changes are not tracked */
+std::optional<uint64_t> ModuleChanges::revision(const sysrepo::Datastore datastore, const std::string& module) const
+{
+    if (auto it = m_modules.find({datastore, module}); it != m_modules.end()) {
+        return it->second.revision.load();
+    }
+    return std::nullopt;
+}
+
+/** @short How many times has any module in this datastore changed */
+uint64_t ModuleChanges::revision(const sysrepo::Datastore datastore) const
+{
+    return m_datastores.at(datastore).revision.load();
+}
+
+/** @short Revision of whatever data the given libyang path (or "/*" for the whole datastore) might refer to */
+std::optional<uint64_t> ModuleChanges::revisionOfPath(const sysrepo::Datastore datastore, const std::string& path) const
+{
+    if (!covers(datastore)) {
+        return std::nullopt;
+    }
+    if (path == "/*") {
+        return revision(datastore);
+    }
+    if (auto module = topLevelModule(path)) {
+        return revision(datastore, *module);
+    }
+    return std::nullopt;
+}
+
+/** @short How many times has the NACM configuration changed; any data filtered by NACM depend on this */
+uint64_t ModuleChanges::nacmRevision() const
+{
+    return m_modules.at({sysrepo::Datastore::Running, "ietf-netconf-acm"}).revision.load();
+}
+
+/** @short When did whatever data the given libyang path might refer to change for the last time, including their NACM rules */
+std::optional<std::chrono::system_clock::time_point> ModuleChanges::lastModifiedOfPath(const sysrepo::Datastore datastore, const std::string& path) const
+{
+    if (!covers(datastore)) {
+        return std::nullopt;
+    }
+
+    const Changes* changes = nullptr;
+    if (path == "/*") {
+        changes = &m_datastores.at(datastore);
+    } else if (auto module = topLevelModule(path)) {
+        if (auto it = m_modules.find({datastore, *module}); it != m_modules.end()) {
+            changes = &it->second;
+        }
+    }
+    if (!changes) {
+        return std::nullopt;
+    }
+
+    const auto& nacm = m_modules.at({sysrepo::Datastore::Running, "ietf-netconf-acm"});
+    return std::chrono::system_clock::time_point{std::chrono::system_clock::duration{std::max(changes->lastModified.load(), nacm.lastModified.load())}};
+}
+
+/** @short When did the tracking start; this tells apart revisions which were seen by different instances of rousette */
+std::chrono::system_clock::time_point ModuleChanges::started() const
+{
+    return m_started;
+}
+}
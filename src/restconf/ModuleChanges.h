@@ -0,0 +1,63 @@
+/*
+ * Copyright (C) 2026 CESNET, https://photonics.cesnet.cz/
+ *
+ * Written by Jan Kundrát <jan.kundrat@cesnet.cz>
+ *
+*/
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <optional>
+#include <set>
+#include <sysrepo-cpp/Connection.hpp>
+#include <sysrepo-cpp/Subscription.hpp>
+
+namespace rousette::restconf {
+
+/** @short Counts changes of YANG modules in the configuration datastores
+ *
+ * Anything which keeps a copy of some configuration data can remember the revision of the data's module, and later
+ * tell whether the copy is still up-to-date. The counters are bumped from sysrepo's module change notifications,
+ * which are delivered asynchronously; a copy might therefore appear current for a short while after a commit. That's
+ * why rousette reports its own edits via committed() as soon as they are applied, before it responds to the client.
+ * The notification of such an edit bumps the revision once more when it arrives, which can only make a current copy
+ * look stale, never the other way round.
+ *
+ * The time of the last change is recorded as well. Changes which happened before rousette started are not known, so
+ * until the first change, data are considered to have been modified at the time this object was created.
+ * */
+class ModuleChanges {
+public:
+    explicit ModuleChanges(sysrepo::Connection conn);
+
+    static bool covers(const sysrepo::Datastore datastore);
+    static std::optional<std::string> topLevelModule(const std::string& path);
+
+    void committed(const sysrepo::Datastore datastore, const std::set<std::string>& modules);
+    void committed(const sysrepo::Datastore datastore);
+
+    std::optional<uint64_t> revision(const sysrepo::Datastore datastore, const std::string& module) const;
+    uint64_t revision(const sysrepo::Datastore datastore) const;
+    std::optional<uint64_t> revisionOfPath(const sysrepo::Datastore datastore, const std::string& path) const;
+    uint64_t nacmRevision() const;
+    std::optional<std::chrono::system_clock::time_point> lastModifiedOfPath(const sysrepo::Datastore datastore, const std::string& path) const;
+    std::chrono::system_clock::time_point started() const;
+
+private:
+    struct Changes {
+        std::atomic<uint64_t> revision{0};
+        std::atomic<std::chrono::system_clock::rep> lastModified;
+
+        void bump();
+    };
+
+    const std::chrono::system_clock::time_point m_started;
+    /** @short Modules whose changes are reported by sysrepo; the map itself is never modified after construction */
+    std::map<std::pair<sysrepo::Datastore, std::string>, Changes> m_modules;
+    std::map<sysrepo::Datastore, Changes> m_datastores;
+    std::vector<sysrepo::Subscription> m_subscriptions;
+};
+}
@@ -91,12 +91,13 @@ NotificationStream::NotificationStream(
     rousette::http::EventStream::Termination& termination,
     std::shared_ptr<rousette::http::EventStream::EventSignal> signal,
     const std::chrono::seconds keepAlivePingInterval,
+    const bool compression,
     sysrepo::Session session,
     libyang::DataFormat dataFormat,
     const std::optional<std::string>& filter,
     const std::optional<sysrepo::NotificationTimeStamp>& startTime,
     const std::optional<sysrepo::NotificationTimeStamp>& stopTime)
-    : EventStream(req, res, termination, *signal, keepAlivePingInterval)
+    : EventStream(req, res, termination, *signal, keepAlivePingInterval, compression)
     , m_notificationSignal(signal)
     , m_session(std::move(session))
     , m_dataFormat(dataFormat)
@@ -203,6 +204,7 @@ std::shared_ptr<NotificationStream> NotificationStream::create(
     const nghttp2::asio_http2::server::response& res,
     rousette::http::EventStream::Termination& termination,
     const std::chrono::seconds keepAlivePingInterval,
+    const bool compression,
     sysrepo::Session sess,
     libyang::DataFormat dataFormat,
     const std::optional<std::string>& filter,
@@ -210,7 +212,7 @@ std::shared_ptr<NotificationStream> NotificationStream::create(
     const std::optional<sysrepo::NotificationTimeStamp>& stopTime)
 {
     auto signal = std::make_shared<rousette::http::EventStream::EventSignal>();
-    auto stream = std::shared_ptr<NotificationStream>(new NotificationStream(req, res, termination, signal, keepAlivePingInterval, std::move(sess), dataFormat, filter, startTime, stopTime));
+    auto stream = std::shared_ptr<NotificationStream>(new NotificationStream(req, res, termination, signal, keepAlivePingInterval, compression, std::move(sess), dataFormat, filter, startTime, stopTime));
     stream->activate();
     return stream;
 }
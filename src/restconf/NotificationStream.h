@@ -44,6 +44,7 @@ public:
         const nghttp2::asio_http2::server::response& res,
         rousette::http::EventStream::Termination& termination,
         const std::chrono::seconds keepAlivePingInterval,
+        const bool compression,
         sysrepo::Session sess,
         libyang::DataFormat dataFormat,
         const std::optional<std::string>& filter,
@@ -57,6 +58,7 @@ protected:
         rousette::http::EventStream::Termination& termination,
         std::shared_ptr<rousette::http::EventStream::EventSignal> signal,
         const std::chrono::seconds keepAlivePingInterval,
+        const bool compression,
         sysrepo::Session sess,
         libyang::DataFormat dataFormat,
         const std::optional<std::string>& filter,
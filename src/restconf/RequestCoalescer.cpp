@@ -0,0 +1,79 @@
+/*
+ * Copyright (C) 2026 CESNET, https://photonics.cesnet.cz/
+ *
+ * Written by Jan Kundrát <jan.kundrat@cesnet.cz>
+ *
+*/
+
+#include "restconf/RequestCoalescer.h"
+
+namespace rousette::restconf {
+
+RequestCoalescer::Leader::Leader(RequestCoalescer& coalescer, const Key& key)
+    : m_coalescer(coalescer)
+    , m_key(key)
+{
+}
+
+RequestCoalescer::Leader::~Leader()
+{
+    if (!m_finished) {
+        m_coalescer.release(m_key, Outcome{});
+    }
+}
+
+/** @short Hand the complete response over to everybody who has been waiting for it */
+void RequestCoalescer::Leader::finish(std::string&& body)
+{
+    if (m_finished) {
+        return;
+    }
+    m_finished = true;
+    m_coalescer.release(m_key, Outcome{.body = std::make_shared<const std::string>(std::move(body)), .error = std::nullopt});
+}
+
+/** @short Reject everybody who has been waiting with the same error as the leader's own request */
+void RequestCoalescer::Leader::fail(const ErrorResponse& error)
+{
+    if (m_finished) {
+        return;
+    }
+    m_finished = true;
+    m_coalescer.release(m_key, Outcome{.body = nullptr, .error = error});
+}
+
+/** @short Either become the leader for this key, or wait for the response of the current one
+ *
+ * Returns the leader's handle when there is no identical request in progress; the caller must process the request,
+ * and eventually either finish() it, fail() it, or destroy the handle. Otherwise, the @p waiter is invoked once the current leader
+ * is done, from whatever thread that happens in, and a nullptr is returned.
+ */
+std::shared_ptr<RequestCoalescer::Leader> RequestCoalescer::join(const Key& key, Waiter waiter)
+{
+    std::lock_guard lock{m_mutex};
+    if (auto it = m_waiters.find(key); it != m_waiters.end()) {
+        it->second.emplace_back(std::move(waiter));
+        return nullptr;
+    }
+    m_waiters.try_emplace(key);
+    return std::make_shared<Leader>(*this, key);
+}
+
+void RequestCoalescer::release(const Key& key, const Outcome& outcome)
+{
+    std::vector<Waiter> waiters;
+    {
+        std::lock_guard lock{m_mutex};
+        auto node = m_waiters.extract(key);
+        if (node.empty()) {
+            return;
+        }
+        waiters = std::move(node.mapped());
+    }
+
+    // whoever comes now becomes a new leader, so the waiters can safely start their own requests
+    for (const auto& waiter : waiters) {
+        waiter(outcome);
+    }
+}
+}
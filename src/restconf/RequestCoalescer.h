@@ -0,0 +1,69 @@
+/*
+ * Copyright (C) 2026 CESNET, https://photonics.cesnet.cz/
+ *
+ * Written by Jan Kundrát <jan.kundrat@cesnet.cz>
+ *
+*/
+
+#pragma once
+
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <vector>
+#include "restconf/Exceptions.h"
+#include "restconf/ResponseCache.h"
+
+namespace rousette::restconf {
+
+/** @short Answer identical reads which are being processed at the same time just once
+ *
+ * When many clients poll the same data at once, the first request (the leader) fetches and prints the data, and the
+ * other ones wait for the leader's response and get a copy of the very same bytes. Requests are identical when their
+ * ResponseCache::Key is, which means that they are also subject to the same NACM rules.
+ *
+ * Nothing is remembered once the leader has finished; that is what the ResponseCache is for. When the leader ends up
+ * with an ErrorResponse, the waiting requests get that very error as well. If the leader gives up for any other reason
+ * (a client which went away, a response which is too big to be copied), the waiting requests are told so, and they are
+ * expected to join() again so that one of them becomes the new leader.
+ * */
+class RequestCoalescer {
+public:
+    using Key = ResponseCache::Key;
+    /** @short What the leader has come up with; neither a body nor an error means that it has given up */
+    struct Outcome {
+        std::shared_ptr<const std::string> body;
+        std::optional<ErrorResponse> error;
+    };
+    using Waiter = std::function<void(const Outcome&)>;
+
+    /** @short Responses bigger than this are not shared */
+    static constexpr std::size_t maxBodySize = 16 * 1024 * 1024;
+
+    /** @short The request which does the actual work; the waiters are released once this goes away */
+    class Leader {
+    public:
+        Leader(RequestCoalescer& coalescer, const Key& key);
+        Leader(const Leader&) = delete;
+        Leader& operator=(const Leader&) = delete;
+        ~Leader();
+        void finish(std::string&& body);
+        void fail(const ErrorResponse& error);
+
+    private:
+        RequestCoalescer& m_coalescer;
+        Key m_key;
+        bool m_finished = false;
+    };
+
+    std::shared_ptr<Leader> join(const Key& key, Waiter waiter);
+
+private:
+    std::mutex m_mutex;
+    std::map<Key, std::vector<Waiter>> m_waiters;
+
+    void release(const Key& key, const Outcome& outcome);
+};
+}
@@ -0,0 +1,175 @@
+/*
+ * Copyright (C) 2026 CESNET, https://photonics.cesnet.cz/
+ *
+ * Written by Jan Kundrát <jan.kundrat@cesnet.cz>
+ *
+*/
+
+#include "restconf/ModuleChanges.h"
+#include "restconf/ResponseCache.h"
+
+namespace rousette::restconf {
+
+namespace {
+std::size_t entrySize(const ResponseCache::Key& key, const std::string& body)
+{
+    // a rough estimate of the bookkeeping overhead
+    return body.size() + 2 * (key.path.size() + key.query.size() + key.accessProfile.size() + key.urlPrefix.value_or("").size()) + 128;
+}
+
+/** @short Does the @p path refer to the node at @p prefix, or to anything below it? */
+bool isWithin(const std::string& path, const std::string& prefix)
+{
+    return path.starts_with(prefix) && (path.size() == prefix.size() || path[prefix.size()] == '/' || path[prefix.size()] == '[');
+}
+}
+
+ResponseCache::ResponseCache(const ModuleChanges& changes, const std::size_t maxBytes)
+    : m_changes(changes)
+    , m_maxBytes(maxBytes)
+{
+}
+
+/** @short Current revision of the configuration data which the response would be made of, or nullopt if there are no such data */
+std::optional<ResponseCache::Revision> ResponseCache::revision(const Key& key) const
+{
+    if (auto data = m_changes.revisionOfPath(key.datastore, key.path)) {
+        return Revision{*data, m_changes.nacmRevision()};
+    }
+    return std::nullopt;
+}
+
+/** @short How long can operational data at the given path be cached, if at all; the most specific policy wins */
+std::optional<std::chrono::milliseconds> ResponseCache::timeToLive(const std::string& path) const
+{
+    std::lock_guard lock{m_mutex};
+    std::optional<std::pair<std::string, std::chrono::milliseconds>> best;
+    for (const auto& [prefix, ttl] : m_timeToLive) {
+        if (isWithin(path, prefix) && (!best || prefix.size() > best->first.size())) {
+            best = {prefix, ttl};
+        }
+    }
+    if (best && best->second.count() > 0) {
+        return best->second;
+    }
+    return std::nullopt;
+}
+
+/** @short Replace all TTL policies, which also drops all cached operational data */
+void ResponseCache::setTimeToLive(const std::map<std::string, std::chrono::milliseconds>& policies)
+{
+    std::lock_guard lock{m_mutex};
+    m_timeToLive = policies;
+    for (auto it = m_entries.begin(); it != m_entries.end();) {
+        auto current = it++;
+        if (std::holds_alternative<Expiry>(current->second.validity)) {
+            evict(current);
+        }
+    }
+}
+
+/** @short A cached response which can still be used */
+ResponseCache::Lookup ResponseCache::get(const Key& key)
+{
+    auto current = revision(key);
+    const auto now = std::chrono::steady_clock::now();
+
+    std::lock_guard lock{m_mutex};
+    auto it = m_entries.find(key);
+    if (it == m_entries.end()) {
+        ++m_misses;
+        return {};
+    }
+
+    Lookup res{it->second.body};
+    if (auto* revision = std::get_if<Revision>(&it->second.validity); revision && *revision != current) {
+        res.body = nullptr;
+    } else if (auto* expiry = std::get_if<Expiry>(&it->second.validity); expiry && now >= expiry->fresh) {
+        if (now >= expiry->fresh + expiry->timeToLive) {
+            res.body = nullptr;
+        } else if (!expiry->refreshing) {
+            // only one refresh at a time, the other requests get the stale data meanwhile
+            expiry->refreshing = true;
+            res.refresh = true;
+        }
+    }
+
+    if (!res.body) {
+        evict(it);
+        ++m_misses;
+        return {};
+    }
+
+    ++m_hits;
+    m_lru.splice(m_lru.begin(), m_lru, it->second.lru);
+    return res;
+}
+
+/** @short Remember a response which was made of configuration data at the given revision
+ *
+ * The @p revision must have been obtained before the data were fetched. If the data have changed since then, the
+ * response is not stored at all.
+ */
+void ResponseCache::put(const Key& key, const Revision& revision, std::string&& body)
+{
+    if (this->revision(key) != revision) {
+        return;
+    }
+    store(key, revision, std::move(body));
+}
+
+/** @short Remember a response with operational data which were just fetched */
+void ResponseCache::put(const Key& key, const std::chrono::milliseconds timeToLive, std::string&& body)
+{
+    store(key, Expiry{std::chrono::steady_clock::now() + timeToLive, timeToLive, false}, std::move(body));
+}
+
+/** @short Forget the response, e.g., because it cannot be refreshed */
+void ResponseCache::drop(const Key& key)
+{
+    std::lock_guard lock{m_mutex};
+    if (auto it = m_entries.find(key); it != m_entries.end()) {
+        evict(it);
+    }
+}
+
+/** @short Responses bigger than this are not worth caching because they would push out too many other ones */
+std::size_t ResponseCache::maxEntrySize() const
+{
+    return m_maxBytes / 8;
+}
+
+ResponseCache::Stats ResponseCache::stats() const
+{
+    std::lock_guard lock{m_mutex};
+    return {m_hits, m_misses, m_entries.size(), m_bytes};
+}
+
+void ResponseCache::store(const Key& key, std::variant<Revision, Expiry>&& validity, std::string&& body)
+{
+    if (body.size() > maxEntrySize()) {
+        return;
+    }
+
+    const auto size = entrySize(key, body);
+    std::lock_guard lock{m_mutex};
+    if (auto it = m_entries.find(key); it != m_entries.end()) {
+        evict(it);
+    }
+
+    while (!m_lru.empty() && m_bytes + size > m_maxBytes) {
+        evict(m_entries.find(m_lru.back()));
+    }
+
+    m_lru.push_front(key);
+    m_entries.emplace(key, Entry{std::make_shared<const std::string>(std::move(body)), std::move(validity), m_lru.begin()});
+    m_bytes += size;
+}
+
+void ResponseCache::evict(std::map<Key, Entry>::iterator it)
+{
+    m_bytes -= entrySize(it->first, *it->second.body);
+    m_lru.erase(it->second.lru);
+    m_entries.erase(it);
+}
+}
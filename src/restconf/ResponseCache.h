@@ -0,0 +1,111 @@
+/*
+ * Copyright (C) 2026 CESNET, https://photonics.cesnet.cz/
+ *
+ * Written by Jan Kundrát <jan.kundrat@cesnet.cz>
+ *
+*/
+
+#pragma once
+
+#include <chrono>
+#include <libyang-cpp/Enum.hpp>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <sysrepo-cpp/Enum.hpp>
+#include <variant>
+
+namespace rousette::restconf {
+
+class ModuleChanges;
+
+/** @short Serialized responses to recent reads
+ *
+ * Identical requests which are repeated over and over again are answered with the very same bytes, without asking
+ * sysrepo and without printing the data. Responses depend on the NACM rules, so users which are members of different
+ * NACM groups do not share the cache entries.
+ *
+ * Responses with configuration data are only used as long as the module which the requested path refers to (and the
+ * NACM configuration) has not changed, see ModuleChanges. Operational data can change at any time without a notice,
+ * so these are only cached for paths with a configured time-to-live. Once that expires, the stale response is still
+ * served for up to another TTL while the caller refreshes it in the background.
+ *
+ * The least recently used entries are evicted once the total size of the cached responses exceeds the configured
+ * limit.
+ * */
+class ResponseCache {
+public:
+    struct Key {
+        sysrepo::Datastore datastore;
+        std::string path; ///< In the libyang format, "/*" for the whole datastore
+        std::string query; ///< Query parameters as they came from the client
+        libyang::DataFormat format;
+        std::string accessProfile; ///< See auth::Nacm::accessProfile()
+        std::optional<std::string> urlPrefix; ///< Scheme and host as seen by the client, some data contain URLs
+
+        auto operator<=>(const Key&) const = default;
+    };
+
+    /** @short State of the configuration data at the time when they were fetched */
+    struct Revision {
+        uint64_t data;
+        uint64_t nacm;
+
+        bool operator==(const Revision&) const = default;
+    };
+
+    struct Lookup {
+        std::shared_ptr<const std::string> body; ///< nullptr if nothing usable is cached
+        bool refresh = false; ///< The response is stale and the caller is responsible for refreshing it
+    };
+
+    struct Stats {
+        uint64_t hits;
+        uint64_t misses;
+        std::size_t entries;
+        std::size_t bytes;
+    };
+
+    ResponseCache(const ModuleChanges& changes, const std::size_t maxBytes);
+
+    std::optional<Revision> revision(const Key& key) const;
+    std::optional<std::chrono::milliseconds> timeToLive(const std::string& path) const;
+    void setTimeToLive(const std::map<std::string, std::chrono::milliseconds>& policies);
+
+    Lookup get(const Key& key);
+    void put(const Key& key, const Revision& revision, std::string&& body);
+    void put(const Key& key, const std::chrono::milliseconds timeToLive, std::string&& body);
+    void drop(const Key& key);
+    std::size_t maxEntrySize() const;
+    Stats stats() const;
+
+private:
+    /** @short Until when is a response with operational data fresh */
+    struct Expiry {
+        std::chrono::steady_clock::time_point fresh;
+        std::chrono::milliseconds timeToLive;
+        bool refreshing;
+    };
+
+    struct Entry {
+        std::shared_ptr<const std::string> body;
+        std::variant<Revision, Expiry> validity;
+        std::list<Key>::iterator lru;
+    };
+
+    const ModuleChanges& m_changes;
+    const std::size_t m_maxBytes;
+    mutable std::mutex m_mutex;
+    std::map<std::string, std::chrono::milliseconds> m_timeToLive; ///< Per-path TTL of operational data
+    std::map<Key, Entry> m_entries;
+    std::list<Key> m_lru; ///< The most recently used entry is at the front
+    std::size_t m_bytes = 0;
+    uint64_t m_hits = 0;
+    uint64_t m_misses = 0;
+
+    void store(const Key& key, std::variant<Revision, Expiry>&& validity, std::string&& body);
+    void evict(std::map<Key, Entry>::iterator it);
+};
+}
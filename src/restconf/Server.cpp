@@ -5,14 +5,21 @@
  *
 */
 
+#include <boost/algorithm/string.hpp>
+#include <cctype>
+#include <charconv>
 #include <experimental/iterator>
+#include <limits>
 #include <libyang-cpp/Enum.hpp>
 #include <libyang-cpp/Time.hpp>
 #include <nghttp2/asio_http2_server.h>
+#include <nghttp2/nghttp2.h>
 #include <spdlog/spdlog.h>
 #include <sysrepo-cpp/Enum.hpp>
 #include <sysrepo-cpp/Subscription.hpp>
 #include <sysrepo-cpp/utils/exception.hpp>
+#include "http/DeferredResponse.h"
+#include "http/SocketRelay.h"
 #include "http/utils.hpp"
 #include "restconf/Exceptions.h"
 #include "restconf/NotificationStream.h"
@@ -21,6 +28,7 @@
 #include "restconf/YangSchemaLocations.h"
 #include "restconf/uri.h"
 #include "restconf/utils/dataformat.h"
+#include "restconf/utils/print.h"
 #include "restconf/utils/yang.h"
 #include "sr/OpticalEvents.h"
 
@@ -59,6 +67,24 @@ constexpr auto restconfRoot = "/restconf/";
 constexpr auto yangSchemaRoot = "/yang/";
 constexpr auto netconfStreamRoot = "/streams/";
 
+/** @short How many requests per worker thread can wait for their turn before the server starts rejecting new ones */
+constexpr std::size_t maxPendingRequestsPerWorker = 16;
+constexpr auto retryAfter = std::chrono::seconds{1}; ///< What to suggest to clients which get rejected due to overload
+
+/** @short Limits of concurrently processed expensive requests, proportional to the number of workers */
+std::map<AdmissionControl::RequestClass, std::size_t> admissionLimits(const std::size_t workerThreads)
+{
+    using RequestClass = AdmissionControl::RequestClass;
+    return {
+        // a couple of these can already keep all the workers busy for a long time
+        {RequestClass::DatastoreDump, std::max<std::size_t>(1, workerThreads / 2)},
+        {RequestClass::OperationalRead, workerThreads * 2},
+        {RequestClass::ConfigurationRead, workerThreads * 2},
+        {RequestClass::Edit, workerThreads * 2},
+        {RequestClass::Rpc, workerThreads * 2},
+    };
+}
+
 bool isSameNode(const libyang::DataNode& child, const PathSegment& lastPathSegment)
 {
     return child.schema().module().name() == *lastPathSegment.apiIdent.prefix && child.schema().name() == lastPathSegment.apiIdent.identifier;
@@ -89,12 +115,28 @@ auto contentType(const libyang::DataFormat dataFormat)
     return contentType(asMimeType(dataFormat));
 }
 
+/** @short A copy of the request data which remains valid even after the HTTP stream goes away */
+struct RequestInfo {
+    std::string peer;
+    std::string method;
+    nghttp2::asio_http2::uri_ref uri;
+    nghttp2::asio_http2::header_map headers;
+
+    explicit RequestInfo(const request& req)
+        : peer(http::peer_from_request(req))
+        , method(req.method())
+        , uri(req.uri())
+        , headers(req.header())
+    {
+    }
+};
+
 /** @brief Rejects the request with an error response and sends the HTTP response. Recommend to use rejectWithError which has more convenient API.
  * @pre The error errorContainer must be a node from ietf-restconf module, grouping "errors", container "errors".
  * */
-void rejectWithErrorImpl(libyang::Context ctx, const libyang::DataFormat& dataFormat, const libyang::DataNode& parent, libyang::DataNode& errorContainer, const request& req, const response& res, const int code, const std::string errorType, const std::string& errorTag, const std::string& errorMessage, const std::optional<std::string>& errorPath, const std::optional<ErrorResponse::ErrorInfo>& errorInfo = std::nullopt)
+void rejectWithErrorImpl(libyang::Context ctx, const libyang::DataFormat& dataFormat, const libyang::DataNode& parent, libyang::DataNode& errorContainer, const RequestInfo& req, const http::DeferredResponse& res, const int code, const std::string errorType, const std::string& errorTag, const std::string& errorMessage, const std::optional<std::string>& errorPath, const std::optional<ErrorResponse::ErrorInfo>& errorInfo = std::nullopt)
 {
-    spdlog::debug("{}: Rejected with {}: {}", http::peer_from_request(req), errorTag, errorMessage);
+    spdlog::debug("{}: Rejected with {}: {}", req.peer, errorTag, errorMessage);
 
     errorContainer.newPath("error[1]/error-type", errorType);
     errorContainer.newPath("error[1]/error-tag", errorTag);
@@ -115,14 +157,18 @@ void rejectWithErrorImpl(libyang::Context ctx, const libyang::DataFormat& dataFo
     nghttp2::asio_http2::header_map headers = {contentType(dataFormat), CORS};
 
     if (code == 405) {
-        headers.merge(httpOptionsHeaders(allowedHttpMethodsForUri(ctx, req.uri().path)));
+        headers.merge(httpOptionsHeaders(allowedHttpMethodsForUri(ctx, req.uri.path)));
+    }
+
+    if (code == 503) {
+        headers.emplace("retry-after", nghttp2::asio_http2::header_value{std::to_string(retryAfter.count()), false});
     }
 
     res.write_head(code, headers);
     res.end(*parent.printStr(dataFormat, libyang::PrintFlags::Siblings));
 }
 
-void rejectWithError(libyang::Context ctx, const libyang::DataFormat& dataFormat, const request& req, const response& res, const int code, const std::string errorType, const std::string& errorTag, const std::string& errorMessage, const std::optional<std::string>& errorPath, const std::optional<ErrorResponse::ErrorInfo>& errorInfo = std::nullopt)
+void rejectWithError(libyang::Context ctx, const libyang::DataFormat& dataFormat, const RequestInfo& req, const http::DeferredResponse& res, const int code, const std::string errorType, const std::string& errorTag, const std::string& errorMessage, const std::optional<std::string>& errorPath, const std::optional<ErrorResponse::ErrorInfo>& errorInfo = std::nullopt)
 {
     auto errors = ctx.newPath("/ietf-restconf:errors", std::nullopt);
     rejectWithErrorImpl(ctx, dataFormat, errors, errors, req, res, code, errorType, errorTag, errorMessage, errorPath, errorInfo);
@@ -133,8 +179,8 @@ auto rejectYangPatch(const std::string& patchId)
 {
     return [patchId](libyang::Context ctx,
                      const libyang::DataFormat& dataFormat,
-                     const request& req,
-                     const response& res,
+                     const RequestInfo& req,
+                     const http::DeferredResponse& res,
                      const int code,
                      const std::string errorType,
                      const std::string& errorTag,
@@ -153,8 +199,8 @@ auto rejectYangPatch(const std::string& patchId, const std::string& editId)
 {
     return [patchId, editId](libyang::Context ctx,
                              const libyang::DataFormat& dataFormat,
-                             const request& req,
-                             const response& res,
+                             const RequestInfo& req,
+                             const http::DeferredResponse& res,
                              const int code,
                              const std::string errorType,
                              const std::string& errorTag,
@@ -247,15 +293,124 @@ auto childLeafValue(const libyang::DataNode& node, const std::string& childName)
     throw ErrorResponse(400, "protocol", "invalid-value", "Expected data node '" + childName + "' not found.");
 }
 
+/** @short What the If-Match and If-Unmodified-Since headers of an edit say about its target */
+enum class Preconditions {
+    None, ///< The client has sent no preconditions
+    Satisfied, ///< The client has seen the current version of the data
+    TargetExists, ///< "If-Match: *", which is only satisfied if the target exists
+};
+
 struct RequestContext {
-    const nghttp2::asio_http2::server::request& req;
-    const nghttp2::asio_http2::server::response& res;
+    RequestInfo req;
+    http::DeferredResponse res;
     DataFormat dataFormat;
-    sysrepo::Session sess;
+    SessionPool::Lease sess;
     RestconfRequest restconfRequest;
+    AdmissionControl::Ticket ticket;
+    std::chrono::milliseconds defaultTimeout; ///< Timeout of sysrepo operations when the request has no deadline
+    std::optional<std::chrono::steady_clock::time_point> deadline;
     std::string payload;
+    ModuleChanges* moduleChanges = nullptr; ///< Where the edits of this request are reported right after they are applied, if anywhere
+    bool entityTags = false; ///< Should the preconditions of edits be evaluated?
+    Preconditions preconditions = Preconditions::None;
+    bool compact = false; ///< Print the response data without any indentation
+
+    std::chrono::milliseconds timeout() const;
+    void checkCancelled() const;
+    libyang::PrintFlags outputFlags(const libyang::PrintFlags flags) const;
 };
 
+/** @short The client has gone away, so there is no point in working on its request anymore */
+class RequestCancelled : public std::exception {
+};
+
+/** @short Stop processing once the client has closed the HTTP stream */
+void RequestContext::checkCancelled() const
+{
+    if (res.closed()) {
+        throw RequestCancelled{};
+    }
+}
+
+/** @short Time remaining for the next sysrepo operation of this request, throws when the deadline has expired already */
+std::chrono::milliseconds RequestContext::timeout() const
+{
+    if (!deadline) {
+        return defaultTimeout;
+    }
+
+    // sysrepo treats a zero timeout as "use the default one"
+    auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(*deadline - std::chrono::steady_clock::now());
+    if (remaining <= std::chrono::milliseconds{0}) {
+        throw ErrorResponse(504, "application", "operation-failed", "Request deadline has expired.");
+    }
+    return remaining;
+}
+
+/** @short Should the data be printed without any indentation? The `pretty` query parameter overrides the server's default. */
+bool compactOutput(const RestconfRequest& restconfRequest, const bool compactByDefault)
+{
+    if (auto it = restconfRequest.queryParams.find("pretty"); it != restconfRequest.queryParams.end()) {
+        return std::holds_alternative<queryParams::pretty::Disabled>(it->second);
+    }
+    return compactByDefault;
+}
+
+libyang::PrintFlags withCompactOutput(const bool compact, const libyang::PrintFlags flags)
+{
+    return compact ? flags | libyang::PrintFlags::Shrink : flags;
+}
+
+/** @short Flags for printing the response data, adjusted for the requested indentation */
+libyang::PrintFlags RequestContext::outputFlags(const libyang::PrintFlags flags) const
+{
+    return withCompactOutput(compact, flags);
+}
+
+std::chrono::milliseconds maxTimeoutFor(const MaxTimeouts& maxTimeouts, const RestconfRequest::Type type)
+{
+    switch (type) {
+    case RestconfRequest::Type::CreateOrReplaceThisNode:
+    case RestconfRequest::Type::CreateChildren:
+    case RestconfRequest::Type::MergeData:
+    case RestconfRequest::Type::DeleteNode:
+        return maxTimeouts.edit;
+    case RestconfRequest::Type::Execute:
+    case RestconfRequest::Type::ExecuteInternal:
+        return maxTimeouts.rpc;
+    default:
+        return maxTimeouts.read;
+    }
+}
+
+/** @short When should the request be finished at the latest, if at all
+ *
+ * Clients can ask for a deadline via the request-timeout header (in milliseconds), which is capped by the server's
+ * maximum for this kind of request.
+ */
+std::optional<std::chrono::steady_clock::time_point> requestDeadline(const RequestInfo& req, const std::chrono::milliseconds maxTimeout)
+{
+    std::optional<std::chrono::milliseconds> budget;
+
+    if (auto it = req.headers.find("request-timeout"); it != req.headers.end()) {
+        unsigned long value;
+        auto [ptr, ec] = std::from_chars(it->second.value.data(), it->second.value.data() + it->second.value.size(), value);
+        if (ec != std::errc{} || ptr != it->second.value.data() + it->second.value.size() || value == 0) {
+            throw ErrorResponse(400, "protocol", "invalid-value", "Invalid request-timeout header.");
+        }
+        budget = std::chrono::milliseconds{value};
+    }
+
+    if (maxTimeout.count() > 0) {
+        budget = std::min(budget.value_or(maxTimeout), maxTimeout);
+    }
+
+    if (!budget) {
+        return std::nullopt;
+    }
+    return std::chrono::steady_clock::now() + *budget;
+}
+
 void yangInsert(const libyang::Context& ctx, libyang::DataNode& listEntryNode, const std::string& where, const std::optional<queryParams::insert::PointParsed>& point)
 {
     auto modYang = *ctx.getModuleImplemented("yang");
@@ -305,7 +460,7 @@ void yangInsert(const RequestContext& requestCtx, libyang::DataNode& listEntryNo
         point = std::get<queryParams::insert::PointParsed>(requestCtx.restconfRequest.queryParams.find("point")->second);
     }
 
-    yangInsert(requestCtx.sess.getContext(), listEntryNode, where, point);
+    yangInsert(requestCtx.sess->getContext(), listEntryNode, where, point);
 }
 
 void yangInsert(const libyang::Context& ctx, libyang::DataNode& listEntryNode, std::string& where, const std::optional<std::string>& point)
@@ -341,23 +496,27 @@ constexpr auto withRestconfExceptions(T func, U rejectWithError)
     {
         try {
             func(requestCtx, std::forward<decltype(args)>(args)...);
+        } catch (const RequestCancelled&) {
+            spdlog::debug("{}: Client has gone away, request abandoned", requestCtx->req.peer);
         } catch (const ErrorResponse& e) {
-            rejectWithError(requestCtx->sess.getContext(), requestCtx->dataFormat.response, requestCtx->req, requestCtx->res, e.code, e.errorType, e.errorTag, e.errorMessage, e.errorPath, e.errorInfo);
+            rejectWithError(requestCtx->sess->getContext(), requestCtx->dataFormat.response, requestCtx->req, requestCtx->res, e.code, e.errorType, e.errorTag, e.errorMessage, e.errorPath, e.errorInfo);
         } catch (const libyang::ErrorWithCode& e) {
             if (e.code() == libyang::ErrorCode::ValidationFailure) {
-                rejectWithError(requestCtx->sess.getContext(), requestCtx->dataFormat.response, requestCtx->req, requestCtx->res, 400, "protocol", "invalid-value", "Validation failure: "s + e.what(), std::nullopt, std::nullopt);
+                rejectWithError(requestCtx->sess->getContext(), requestCtx->dataFormat.response, requestCtx->req, requestCtx->res, 400, "protocol", "invalid-value", "Validation failure: "s + e.what(), std::nullopt, std::nullopt);
             } else {
-                rejectWithError(requestCtx->sess.getContext(), requestCtx->dataFormat.response, requestCtx->req, requestCtx->res, 500, "application", "operation-failed", "Internal server error due to libyang exception: "s + e.what(), std::nullopt, std::nullopt);
+                rejectWithError(requestCtx->sess->getContext(), requestCtx->dataFormat.response, requestCtx->req, requestCtx->res, 500, "application", "operation-failed", "Internal server error due to libyang exception: "s + e.what(), std::nullopt, std::nullopt);
             }
         } catch (const sysrepo::ErrorWithCode& e) {
             if (e.code() == sysrepo::ErrorCode::Unauthorized) {
-                rejectWithError(requestCtx->sess.getContext(), requestCtx->dataFormat.response, requestCtx->req, requestCtx->res, 403, "application", "access-denied", "Access denied.", std::nullopt, std::nullopt);
+                rejectWithError(requestCtx->sess->getContext(), requestCtx->dataFormat.response, requestCtx->req, requestCtx->res, 403, "application", "access-denied", "Access denied.", std::nullopt, std::nullopt);
             } else if (e.code() == sysrepo::ErrorCode::NotFound) {
-                rejectWithError(requestCtx->sess.getContext(), requestCtx->dataFormat.response, requestCtx->req, requestCtx->res, 400, "protocol", "invalid-value", e.what(), std::nullopt, std::nullopt);
+                rejectWithError(requestCtx->sess->getContext(), requestCtx->dataFormat.response, requestCtx->req, requestCtx->res, 400, "protocol", "invalid-value", e.what(), std::nullopt, std::nullopt);
+            } else if (e.code() == sysrepo::ErrorCode::TimeOut) {
+                rejectWithError(requestCtx->sess->getContext(), requestCtx->dataFormat.response, requestCtx->req, requestCtx->res, 504, "application", "operation-failed", "Request deadline has expired.", std::nullopt, std::nullopt);
             } else if (e.code() == sysrepo::ErrorCode::ItemAlreadyExists) {
-                rejectWithError(requestCtx->sess.getContext(), requestCtx->dataFormat.response, requestCtx->req, requestCtx->res, 409, "application", "resource-denied", "Resource already exists.", std::nullopt, std::nullopt);
+                rejectWithError(requestCtx->sess->getContext(), requestCtx->dataFormat.response, requestCtx->req, requestCtx->res, 409, "application", "resource-denied", "Resource already exists.", std::nullopt, std::nullopt);
             } else if (e.code() == sysrepo::ErrorCode::ValidationFailed) {
-                bool isAction = requestCtx->restconfRequest.path != "/" && requestCtx->sess.getContext().findPath(requestCtx->restconfRequest.path).nodeType() == libyang::NodeType::Action;
+                bool isAction = requestCtx->restconfRequest.path != "/" && requestCtx->sess->getContext().findPath(requestCtx->restconfRequest.path).nodeType() == libyang::NodeType::Action;
                 /*
                  * FIXME: This happens on invalid input data (e.g., missing mandatory nodes) or missing action data node.
                  * The former (invalid input data) should probably be validated by libyang's parseOp but it only parses.
@@ -365,10 +524,10 @@ constexpr auto withRestconfExceptions(T func, U rejectWithError)
                  * sending the RPC but that is racy because two sysrepo operations must be done (query + rpc) and
                  * operational DS cannot be locked.
                  */
-                rejectWithError(requestCtx->sess.getContext(), requestCtx->dataFormat.response, requestCtx->req, requestCtx->res, 400, "application", "operation-failed",
+                rejectWithError(requestCtx->sess->getContext(), requestCtx->dataFormat.response, requestCtx->req, requestCtx->res, 400, "application", "operation-failed",
                         "Validation failed. Invalid input data"s + (isAction ? " or the action node is not present" : "") + ".", std::nullopt, std::nullopt);
             } else {
-                rejectWithError(requestCtx->sess.getContext(), requestCtx->dataFormat.response, requestCtx->req, requestCtx->res, 500, "application", "operation-failed",
+                rejectWithError(requestCtx->sess->getContext(), requestCtx->dataFormat.response, requestCtx->req, requestCtx->res, 500, "application", "operation-failed",
                         "Internal server error due to sysrepo exception: "s + e.what(), std::nullopt, std::nullopt);
             }
         }
@@ -445,20 +604,188 @@ libyang::CreatedNodes createEditForPutAndPatch(libyang::Context& ctx, const std:
     return {editNode, replacementNode};
 }
 
-std::optional<libyang::DataNode> processInternalRPC(sysrepo::Session& sess, libyang::DataNode& rpcInput, const std::optional<std::string>& schemeAndHost, const libyang::DataFormat requestEncoding, DynamicSubscriptions& dynamicSubscriptions)
+int sysrepoMaxDepth(const RestconfRequest& restconfRequest)
+{
+    int maxDepth = 0; /* unbounded depth is the RFC default, which in sysrepo terms is 0 */
+    if (auto it = restconfRequest.queryParams.find("depth"); it != restconfRequest.queryParams.end() && std::holds_alternative<unsigned int>(it->second)) {
+        maxDepth = std::get<unsigned int>(it->second);
+    }
+    return maxDepth;
+}
+
+sysrepo::GetOptions sysrepoGetOptions(const RestconfRequest& restconfRequest)
+{
+    sysrepo::GetOptions getOptions = sysrepo::GetOptions::Default; /* default get options: return all nodes */
+    if (auto it = restconfRequest.queryParams.find("content"); it != restconfRequest.queryParams.end()) {
+        if(std::holds_alternative<queryParams::content::OnlyNonConfigNodes>(it->second)) {
+            getOptions = sysrepo::GetOptions::OperNoConfig;
+        } else if(std::holds_alternative<queryParams::content::OnlyConfigNodes>(it->second)) {
+            getOptions = sysrepo::GetOptions::OperNoState;
+        }
+    }
+    return getOptions;
+}
+
+/** @short XPath of the data which a GET request asks for */
+std::string dataXPath(const libyang::Context& ctx, const RestconfRequest& restconfRequest)
+{
+    if (auto it = restconfRequest.queryParams.find("fields"); it != restconfRequest.queryParams.end()) {
+        auto fields = std::get<queryParams::fields::Expr>(it->second);
+        return fieldsToXPath(ctx, restconfRequest.path == "/*" ? "" : restconfRequest.path, fields);
+    }
+    if (auto it = restconfRequest.queryParams.find("filter"); it != restconfRequest.queryParams.end()) {
+        return filterToXPath(restconfRequest.path, std::get<std::string>(it->second));
+    }
+    return restconfRequest.path;
+}
+
+/** @short Might the data of one of these GET requests contain some data of the other one? */
+bool overlaps(const std::string& pathA, const std::string& pathB)
+{
+    auto isWithin = [](const std::string& path, const std::string& prefix) {
+        return path.starts_with(prefix) && (path.size() == prefix.size() || path[prefix.size()] == '/' || path[prefix.size()] == '[');
+    };
+    return pathA == "/*" || pathB == "/*" || isWithin(pathA, pathB) || isWithin(pathB, pathA);
+}
+
+/** @short The rousette:bulk-read RPC
+ *
+ * Reads which use the same datastore and the same options are answered by a single sysrepo query for a union of their
+ * XPaths, unless the data of one of them would be mixed with the data of another one. The result of each read is then
+ * picked from the combined data. When such a combined query fails, each of its reads is retried on its own so that
+ * the error is reported for the right one. Each sysrepo query gets the time which remains until the request's deadline.
+ */
+void bulkRead(sysrepo::Session& sess, const std::optional<std::string>& schemeAndHost, const std::function<std::chrono::milliseconds()>& timeout, const libyang::DataNode& rpcInput, libyang::DataNode& rpcOutput)
+{
+    struct Read {
+        std::string id;
+        std::optional<RestconfRequest> request;
+        std::optional<libyang::DataNode> data;
+        std::optional<ErrorResponse> error;
+    };
+    std::vector<Read> reads;
+
+    for (const auto& node : rpcInput.findXPath("read")) {
+        Read read{.id = node.findPath("id")->asTerm().valueStr()};
+        std::vector<std::string> query;
+        for (const auto& param : {"depth", "fields", "content"}) {
+            if (auto value = node.findPath(param)) {
+                query.emplace_back(param + "="s + value->asTerm().valueStr());
+            }
+        }
+        try {
+            read.request = asRestconfRequest(sess.getContext(), "GET", node.findPath("path")->asTerm().valueStr(), boost::algorithm::join(query, "&"));
+            if (read.request->type != RestconfRequest::Type::GetData) {
+                throw ErrorResponse(400, "application", "operation-failed", "Only data resources can be read");
+            }
+        } catch (const ErrorResponse& e) {
+            read.error = e;
+        }
+        reads.emplace_back(std::move(read));
+    }
+
+    std::vector<std::vector<Read*>> batches;
+    for (auto& read : reads) {
+        if (!read.request) {
+            continue;
+        }
+        auto batch = std::find_if(batches.begin(), batches.end(), [&read](const auto& batch) {
+            const auto& first = *batch.front()->request;
+            return first.datastore == read.request->datastore
+                && sysrepoMaxDepth(first) == sysrepoMaxDepth(*read.request)
+                && sysrepoGetOptions(first) == sysrepoGetOptions(*read.request)
+                && std::none_of(batch.begin(), batch.end(), [&read](const Read* other) { return overlaps(other->request->path, read.request->path); });
+        });
+        if (batch != batches.end()) {
+            batch->emplace_back(&read);
+        } else {
+            batches.push_back({&read});
+        }
+    }
+
+    auto fetch = [&sess, &schemeAndHost, &timeout](const std::vector<Read*>& batch) {
+        const auto& first = *batch.front()->request;
+        std::vector<std::string> xpaths;
+        for (const auto* read : batch) {
+            xpaths.emplace_back(dataXPath(sess.getContext(), *read->request));
+        }
+
+        sess.switchDatastore(first.datastore.value_or(sysrepo::Datastore::Operational));
+        auto data = sess.getData(boost::algorithm::join(xpaths, " | "), sysrepoMaxDepth(first), sysrepoGetOptions(first), timeout());
+        if (data) {
+            data = replaceYangLibraryLocations(schemeAndHost, yangSchemaRoot, *data);
+            data = replaceStreamLocations(schemeAndHost, *data);
+        }
+
+        for (auto* read : batch) {
+            if (data && batch.size() == 1) {
+                read->data = data;
+            } else if (data) {
+                // a target can match several nodes, e.g., all entries of a list when a field of theirs was asked for
+                read->data = copyWithParents(*data, read->request->path);
+            }
+            if (!read->data) {
+                read->error = ErrorResponse(404, "application", "invalid-value", "No data from sysrepo.");
+            }
+        }
+    };
+
+    for (const auto& batch : batches) {
+        if (batch.size() > 1) {
+            try {
+                fetch(batch);
+                continue;
+            } catch (const std::exception& e) {
+                spdlog::debug("Bulk read of {} paths failed, trying them one by one: {}", batch.size(), e.what());
+            }
+        }
+
+        for (auto* read : batch) {
+            try {
+                fetch({read});
+            } catch (const ErrorResponse& e) {
+                read->error = e;
+            } catch (const std::exception& e) {
+                read->error = ErrorResponse(500, "application", "operation-failed", e.what());
+            }
+        }
+    }
+
+    for (const auto& read : reads) {
+        const auto prefix = "result[id=" + escapeListKey(read.id) + "]/";
+        if (read.error) {
+            rpcOutput.newPath(prefix + "error/status", std::to_string(read.error->code), libyang::CreationOptions::Output);
+            rpcOutput.newPath(prefix + "error/error-type", read.error->errorType, libyang::CreationOptions::Output);
+            rpcOutput.newPath(prefix + "error/error-tag", read.error->errorTag, libyang::CreationOptions::Output);
+            rpcOutput.newPath(prefix + "error/error-message", read.error->errorMessage, libyang::CreationOptions::Output);
+            if (read.error->errorPath) {
+                rpcOutput.newPath(prefix + "error/error-path", *read.error->errorPath, libyang::CreationOptions::Output);
+            }
+        } else {
+            rpcOutput.newPath2(prefix + "data", *read.data, libyang::CreationOptions::Output);
+        }
+    }
+}
+
+std::optional<libyang::DataNode> processInternalRPC(sysrepo::Session& sess, libyang::DataNode& rpcInput, const std::optional<std::string>& schemeAndHost, const libyang::DataFormat requestEncoding, const std::function<std::chrono::milliseconds()>& timeout, DynamicSubscriptions& dynamicSubscriptions, const ChangeJournal* changeJournal)
 {
     struct InternalRPCHandler {
         std::optional<std::string> validationDataXPath; ///< XPath to data used for RPC input validation
         std::function<void(sysrepo::Session&, const std::optional<std::string>&, const libyang::DataFormat, const libyang::DataNode&, libyang::DataNode&)> rpcHandler; // The function that processes the RPC
     };
-    const std::map<std::string, InternalRPCHandler> handlers{
+    std::map<std::string, InternalRPCHandler> handlers{
         {"/ietf-subscribed-notifications:establish-subscription",
          {"/ietf-subscribed-notifications:filters", [&dynamicSubscriptions](auto&&... args) { return dynamicSubscriptions.establishSubscription(std::forward<decltype(args)>(args)...); }}},
         {"/ietf-subscribed-notifications:kill-subscription",
          {std::nullopt, [&dynamicSubscriptions](auto&&... args) { return dynamicSubscriptions.deleteSubscription(std::forward<decltype(args)>(args)...); }}},
         {"/ietf-subscribed-notifications:delete-subscription",
          {std::nullopt, [&dynamicSubscriptions](auto&&... args) { return dynamicSubscriptions.deleteSubscription(std::forward<decltype(args)>(args)...); }}},
+        {"/rousette:bulk-read",
+         {std::nullopt, [&timeout](auto& sess, const auto& schemeAndHost, auto, const auto& rpcInput, auto& rpcOutput) { bulkRead(sess, schemeAndHost, timeout, rpcInput, rpcOutput); }}},
     };
+    if (changeJournal) {
+        handlers.emplace("/rousette:changes-since", InternalRPCHandler{std::nullopt, [changeJournal](auto&&... args) { return changeJournal->changesSince(std::forward<decltype(args)>(args)...); }});
+    }
 
     const auto rpcPath = rpcInput.path();
 
@@ -475,7 +802,7 @@ std::optional<libyang::DataNode> processInternalRPC(sysrepo::Session& sess, liby
 
     // RPC input validation.
     sess.switchDatastore(sysrepo::Datastore::Operational);
-    auto validationData = handlerIt->second.validationDataXPath ? sess.getData(*handlerIt->second.validationDataXPath) : std::nullopt;
+    auto validationData = handlerIt->second.validationDataXPath ? sess.getData(*handlerIt->second.validationDataXPath, 0, sysrepo::GetOptions::Default, timeout()) : std::nullopt;
 
     try {
         libyang::validateOp(rpcInput, validationData, libyang::OperationType::RpcRestconf);
@@ -496,10 +823,10 @@ std::optional<libyang::DataNode> processInternalRPC(sysrepo::Session& sess, liby
     return *parent;
 }
 
-void processActionOrRPC(std::shared_ptr<RequestContext> requestCtx, const std::chrono::milliseconds timeout, DynamicSubscriptions& dynamicSubscriptions)
+void processActionOrRPC(std::shared_ptr<RequestContext> requestCtx, DynamicSubscriptions& dynamicSubscriptions, const ChangeJournal* changeJournal)
 {
-    requestCtx->sess.switchDatastore(sysrepo::Datastore::Operational);
-    auto ctx = requestCtx->sess.getContext();
+    requestCtx->sess->switchDatastore(sysrepo::Datastore::Operational);
+    auto ctx = requestCtx->sess->getContext();
 
     auto rpcSchemaNode = ctx.findPath(requestCtx->restconfRequest.path);
     if (!requestCtx->dataFormat.request && static_cast<bool>(rpcSchemaNode.asActionRpc().input().child())) {
@@ -513,8 +840,8 @@ void processActionOrRPC(std::shared_ptr<RequestContext> requestCtx, const std::c
          *  - The data node exists but might get deleted right after this check: Sysrepo throws an error when this happens.
          *  - The data node does not exist but might get created right after this check: The node was not there when the request was issues so it should not be a problem
          */
-        auto [pathToParent, pathSegment] = asLibyangPathSplit(ctx, requestCtx->req.uri().raw_path);
-        if (!requestCtx->sess.getData(pathToParent, 0, sysrepo::GetOptions::Default, timeout)) {
+        auto [pathToParent, pathSegment] = asLibyangPathSplit(ctx, requestCtx->req.uri.raw_path);
+        if (!requestCtx->sess->getData(pathToParent, 0, sysrepo::GetOptions::Default, requestCtx->timeout())) {
             throw ErrorResponse(400, "application", "operation-failed", "Action data node '" + requestCtx->restconfRequest.path + "' does not exist.");
         }
     }
@@ -528,10 +855,11 @@ void processActionOrRPC(std::shared_ptr<RequestContext> requestCtx, const std::c
 
     std::optional<libyang::DataNode> rpcReply;
     if (requestCtx->restconfRequest.type == RestconfRequest::Type::Execute) {
-        rpcReply = requestCtx->sess.sendRPC(*rpcNode, timeout);
+        requestCtx->checkCancelled();
+        rpcReply = requestCtx->sess->sendRPC(*rpcNode, requestCtx->timeout());
     } else if (requestCtx->restconfRequest.type == RestconfRequest::Type::ExecuteInternal) {
-        auto schemeAndHost = http::parseUrlPrefix(requestCtx->req.header());
-        rpcReply = processInternalRPC(requestCtx->sess, *rpcNode, schemeAndHost, *requestCtx->dataFormat.request, dynamicSubscriptions);
+        auto schemeAndHost = http::parseUrlPrefix(requestCtx->req.headers);
+        rpcReply = processInternalRPC(*requestCtx->sess, *rpcNode, schemeAndHost, *requestCtx->dataFormat.request, [&requestCtx]() { return requestCtx->timeout(); }, dynamicSubscriptions, changeJournal);
     }
 
     if (!rpcReply || rpcReply->immediateChildren().empty()) {
@@ -551,12 +879,137 @@ void processActionOrRPC(std::shared_ptr<RequestContext> requestCtx, const std::c
                                         contentType(requestCtx->dataFormat.response),
                                         CORS,
                                     });
-    requestCtx->res.end(*envelope->printStr(requestCtx->dataFormat.response, libyang::PrintFlags::Siblings | libyang::PrintFlags::EmptyContainers));
+    requestCtx->res.end(*envelope->printStr(requestCtx->dataFormat.response, requestCtx->outputFlags(libyang::PrintFlags::Siblings | libyang::PrintFlags::EmptyContainers)));
 }
 
-void processPost(std::shared_ptr<RequestContext> requestCtx, const std::chrono::milliseconds timeout)
+/** @short The leading part of all entity tags of the data at the given path, which only changes along with the data */
+std::optional<std::string> dataVersion(const ModuleChanges& changes, const sysrepo::Datastore datastore, const std::string& path)
 {
-    auto ctx = requestCtx->sess.getContext();
+    if (auto revision = changes.revisionOfPath(datastore, path)) {
+        return fmt::format("\"{:x}-{:x}-", changes.started().time_since_epoch().count(), *revision);
+    }
+    return std::nullopt;
+}
+
+/** @short Evaluate the preconditions of an edit as per RFC 9110's section 13.2.1, throw 412 if these are not satisfied
+ *
+ * The client might have obtained the entity tag from any representation of the target, such as one in a different
+ * encoding, so only the part of the tag which identifies the version of the data is compared.
+ */
+Preconditions checkPreconditions(const ModuleChanges& changes, const sysrepo::Datastore datastore, const std::string& path, const RequestInfo& req)
+{
+    const auto libyangPath = path == "/" ? "/*"s : path;
+
+    if (auto ifMatch = http::getHeaderValue(req.headers, "if-match")) {
+        if (*ifMatch == "*") {
+            return Preconditions::TargetExists;
+        }
+        auto version = dataVersion(changes, datastore, libyangPath);
+        if (!version || !std::ranges::any_of(http::parseEntityTagList(*ifMatch), [&](const auto& tag) { return tag.starts_with(*version); })) {
+            throw ErrorResponse(412, "protocol", "operation-failed", "The data have been modified since the entity tag was obtained.");
+        }
+        return Preconditions::Satisfied;
+    }
+
+    if (auto ifUnmodifiedSince = http::getHeaderValue(req.headers, "if-unmodified-since")) {
+        // invalid dates and data without a modification date mean that the header is ignored
+        auto since = http::parseHttpDate(*ifUnmodifiedSince);
+        auto lastModified = changes.lastModifiedOfPath(datastore, libyangPath);
+        if (!since || !lastModified) {
+            return Preconditions::None;
+        }
+        if (std::chrono::floor<std::chrono::seconds>(*lastModified) > *since) {
+            throw ErrorResponse(412, "protocol", "operation-failed", "The data have been modified since the given time.");
+        }
+        return Preconditions::Satisfied;
+    }
+
+    return Preconditions::None;
+}
+
+/** @short Does the client make the edit conditional on the state of the target? */
+bool hasPreconditions(const RequestInfo& req)
+{
+    return req.headers.contains("if-match") || req.headers.contains("if-unmodified-since");
+}
+
+/** @short Modules which might own some data changed by the edit, i.e., anything which can appear below its top-level nodes */
+std::optional<std::set<std::string>> modulesOfEdit(const libyang::DataNode& edit)
+{
+    std::set<std::string> modules;
+    for (const auto& topLevel : edit.siblings()) {
+        if (topLevel.isOpaque()) {
+            return std::nullopt;
+        }
+        modules.emplace(topLevel.schema().module().name());
+        for (const auto& node : topLevel.schema().childrenDfs()) {
+            modules.emplace(node.module().name());
+        }
+    }
+    return modules;
+}
+
+using ModuleLocks = std::vector<std::unique_ptr<sysrepo::Lock>>;
+
+/** @short Lock the module which the target belongs to, or the whole datastore when the target is the datastore itself
+ *
+ * Sysrepo stores the nodes which other modules augment into a subtree along with the subtree's top-level node, so the
+ * module of that node is the only one which has to be locked, even when the target itself is an augmentation.
+ */
+ModuleLocks lockModules(const RequestContext& requestCtx)
+{
+    ModuleLocks locks;
+    // The candidate DS in sysrepo rolls back on unlock, so we cannot take that lock.
+    // So, there's a race when modifying the candidate DS.
+    if (requestCtx.sess->activeDatastore() == sysrepo::Datastore::Candidate) {
+        return locks;
+    }
+
+    auto lockTimeout = [&requestCtx]() { return requestCtx.deadline ? std::optional{requestCtx.timeout()} : std::nullopt; };
+    if (requestCtx.restconfRequest.path == "/") {
+        locks.emplace_back(std::make_unique<sysrepo::Lock>(*requestCtx.sess, std::nullopt, lockTimeout()));
+        return locks;
+    }
+    locks.emplace_back(std::make_unique<sysrepo::Lock>(*requestCtx.sess, ModuleChanges::topLevelModule(requestCtx.restconfRequest.path), lockTimeout()));
+    return locks;
+}
+
+/** @short Lock the target's modules if the edit depends on the current data, and evaluate the client's preconditions
+ *
+ * The preconditions are only meaningful when nobody else can change the data between their evaluation and the commit,
+ * so they are evaluated under the lock, and the revisions of the data are bumped by applyEdit() before it is released.
+ */
+ModuleLocks lockForEdit(RequestContext& requestCtx, const bool dependsOnCurrentData)
+{
+    ModuleLocks locks;
+    if (dependsOnCurrentData || hasPreconditions(requestCtx.req)) {
+        locks = lockModules(requestCtx);
+    }
+    if (requestCtx.entityTags) {
+        requestCtx.preconditions = checkPreconditions(*requestCtx.moduleChanges, requestCtx.sess->activeDatastore(), requestCtx.restconfRequest.path, requestCtx.req);
+    }
+    return locks;
+}
+
+/** @short Apply the edit, and make sure that any copies of the old data are invalidated before the client gets a response */
+void applyEdit(const RequestContext& requestCtx, const libyang::DataNode& edit)
+{
+    requestCtx.sess->editBatch(edit, sysrepo::DefaultOperation::Merge);
+    requestCtx.sess->applyChanges(requestCtx.timeout());
+
+    if (requestCtx.moduleChanges) {
+        if (auto modules = modulesOfEdit(edit)) {
+            requestCtx.moduleChanges->committed(requestCtx.sess->activeDatastore(), *modules);
+        } else {
+            requestCtx.moduleChanges->committed(requestCtx.sess->activeDatastore());
+        }
+    }
+}
+
+void processPost(std::shared_ptr<RequestContext> requestCtx)
+{
+    auto ctx = requestCtx->sess->getContext();
+    auto locks = lockForEdit(*requestCtx, false);
 
     std::optional<libyang::DataNode> edit;
     std::optional<libyang::DataNode> node;
@@ -602,8 +1055,7 @@ void processPost(std::shared_ptr<RequestContext> requestCtx, const std::chrono::
     createdNodes.begin()->newMeta(*modNetconf, "operation", "create");
     yangInsert(*requestCtx, *createdNodes.begin());
 
-    requestCtx->sess.editBatch(*edit, sysrepo::DefaultOperation::Merge);
-    requestCtx->sess.applyChanges(timeout);
+    applyEdit(*requestCtx, *edit);
 
     requestCtx->res.write_head(201,
                                {
@@ -635,14 +1087,14 @@ std::optional<std::string> yangPatchValueAsJSON(const libyang::DataNode& editCon
 
 void processYangPatchEdit(const std::shared_ptr<RequestContext>& requestCtx, const libyang::DataNode& editContainer, std::optional<libyang::DataNode>& mergedEdits)
 {
-    auto ctx = requestCtx->sess.getContext();
+    auto ctx = requestCtx->sess->getContext();
     auto netconfMod = *ctx.getModuleImplemented("ietf-netconf");
 
     auto target = childLeafValue(editContainer, "target");
     auto operation = childLeafValue(editContainer, "operation");
 
     auto [singleEdit, replacementNode] = createEditForPutAndPatch(ctx,
-                                                                  uriJoin(requestCtx->req.uri().raw_path, target),
+                                                                  uriJoin(requestCtx->req.uri.raw_path, target),
                                                                   yangPatchValueAsJSON(editContainer),
                                                                   libyang::DataFormat::JSON);
     validateInputMetaAttributes(ctx, *singleEdit);
@@ -659,7 +1111,7 @@ void processYangPatchEdit(const std::shared_ptr<RequestContext>& requestCtx, con
                 throw ErrorResponse(400, "protocol", "invalid-value", "Required leaf 'point' not set.");
             }
 
-            point = requestCtx->req.uri().path + pointNode->asTerm().valueStr();
+            point = requestCtx->req.uri.path + pointNode->asTerm().valueStr();
         } else if (pointNode) {
             throw ErrorResponse(400, "protocol", "invalid-value", "Leaf 'point' must always come with leaf 'where' set to 'before' or 'after'");
         }
@@ -678,12 +1130,13 @@ void processYangPatchEdit(const std::shared_ptr<RequestContext>& requestCtx, con
 }
 
 /** @short RFC 8072 "YANG patch" processing once the patch-id is known */
-void processYangPatchImpl(const std::shared_ptr<RequestContext>& requestCtx, const libyang::DataNode& patch, const std::string& patchId, const std::chrono::milliseconds timeout)
+void processYangPatchImpl(const std::shared_ptr<RequestContext>& requestCtx, const libyang::DataNode& patch, const std::string& patchId)
 {
     // create one big edit from all the edits because we need to apply all at once.
     std::optional<libyang::DataNode> mergedEdits;
 
     for (const auto& editContainer : patch.findXPath("edit")) {
+        requestCtx->checkCancelled();
         auto editId = childLeafValue(editContainer, "edit-id");
 
         // errors while processing a single edit are reported in the edit-status container
@@ -691,14 +1144,15 @@ void processYangPatchImpl(const std::shared_ptr<RequestContext>& requestCtx, con
     }
 
     if (mergedEdits) {
-        requestCtx->sess.editBatch(*mergedEdits, sysrepo::DefaultOperation::Merge);
-        requestCtx->sess.applyChanges(timeout);
+        requestCtx->checkCancelled();
+        applyEdit(*requestCtx, *mergedEdits);
     }
 }
 
-void processYangPatch(std::shared_ptr<RequestContext> requestCtx, const std::chrono::milliseconds timeout)
+void processYangPatch(std::shared_ptr<RequestContext> requestCtx)
 {
-    auto ctx = requestCtx->sess.getContext();
+    auto ctx = requestCtx->sess->getContext();
+    auto locks = lockForEdit(*requestCtx, false);
     auto patch = ctx.parseData(requestCtx->payload, *requestCtx->dataFormat.request, libyang::ParseOptions::Strict | libyang::ParseOptions::NoState | libyang::ParseOptions::ParseOnly);
     if (!patch) {
         throw ErrorResponse(400, "protocol", "invalid-value", "Empty patch.");
@@ -706,7 +1160,7 @@ void processYangPatch(std::shared_ptr<RequestContext> requestCtx, const std::chr
 
     // now we have patch-id so we can respond to errors with yang-patch-status
     auto patchId = childLeafValue(*patch, "patch-id");
-    WITH_RESTCONF_EXCEPTIONS(processYangPatchImpl, rejectYangPatch(patchId))(requestCtx, *patch, patchId, timeout);
+    WITH_RESTCONF_EXCEPTIONS(processYangPatchImpl, rejectYangPatch(patchId))(requestCtx, *patch, patchId);
 
     // everything went well
     auto yangPatchStatus = ctx.newPath("/ietf-yang-patch:yang-patch-status", std::nullopt);
@@ -714,12 +1168,19 @@ void processYangPatch(std::shared_ptr<RequestContext> requestCtx, const std::chr
     yangPatchStatus.newPath("/ietf-yang-patch:yang-patch-status/ok", std::nullopt);
 
     requestCtx->res.write_head(200, {contentType(requestCtx->dataFormat.response), CORS});
-    requestCtx->res.end(*yangPatchStatus.printStr(requestCtx->dataFormat.response, libyang::PrintFlags::Siblings));
+    requestCtx->res.end(*yangPatchStatus.printStr(requestCtx->dataFormat.response, requestCtx->outputFlags(libyang::PrintFlags::Siblings)));
 }
 
-void processPutOrPlainPatch(std::shared_ptr<RequestContext> requestCtx, const std::chrono::milliseconds timeout)
+void processPutOrPlainPatch(std::shared_ptr<RequestContext> requestCtx)
 {
-    auto ctx = requestCtx->sess.getContext();
+    auto ctx = requestCtx->sess->getContext();
+
+    // The HTTP status code for PUT depends on whether the node already existed before the operation.
+    // To prevent a race when someone else creates the node while this request is being processed,
+    // this needs locking. A successful PATCH is always a 204, so there's no need to lock anything for
+    // that, unless the client has sent some preconditions.
+    // Only the module which the data belong to is locked, edits of other modules can proceed.
+    auto locks = lockForEdit(*requestCtx, requestCtx->req.method == "PUT" && requestCtx->restconfRequest.path != "/");
 
     // PUT / means replace everything. PATCH / means merge into datastore. Also, asLibyangPathSplit() won't do the right thing on "/".
     if (requestCtx->restconfRequest.path == "/") {
@@ -730,48 +1191,43 @@ void processPutOrPlainPatch(std::shared_ptr<RequestContext> requestCtx, const st
 
         validateInputMetaAttributes(ctx, *edit);
 
-        if (requestCtx->req.method() == "PUT") {
-            requestCtx->sess.replaceConfig(edit, std::nullopt, timeout);
+        if (requestCtx->req.method == "PUT") {
+            requestCtx->sess->replaceConfig(edit, std::nullopt, requestCtx->timeout());
+            if (requestCtx->moduleChanges) {
+                requestCtx->moduleChanges->committed(requestCtx->sess->activeDatastore());
+            }
 
             requestCtx->res.write_head(edit ? 201 : 204, {CORS});
         } else {
-            requestCtx->sess.editBatch(*edit, sysrepo::DefaultOperation::Merge);
-            requestCtx->sess.applyChanges(timeout);
+            applyEdit(*requestCtx, *edit);
             requestCtx->res.write_head(204, {CORS});
         }
         requestCtx->res.end();
         return;
     }
 
-    // The HTTP status code for PUT depends on whether the node already existed before the operation.
-    // To prevent a race when someone else creates the node while this request is being processed,
-    // this needs locking.
-    std::unique_ptr<sysrepo::Lock> lock;
-    if (requestCtx->sess.activeDatastore() != sysrepo::Datastore::Candidate) {
-        // ...except that the candidate DS in sysrepo rolls back on unlock, so we cannot take that lock.
-        // So, there's a race when modifying the candidate DS.
-        lock = std::make_unique<sysrepo::Lock>(requestCtx->sess);
-    }
+    bool nodeExisted = !!requestCtx->sess->getData(requestCtx->restconfRequest.path, 0, sysrepo::GetOptions::Default, requestCtx->timeout());
 
-    bool nodeExisted = !!requestCtx->sess.getData(requestCtx->restconfRequest.path, 0, sysrepo::GetOptions::Default, timeout);
+    if (requestCtx->preconditions == Preconditions::TargetExists && !nodeExisted) {
+        throw ErrorResponse(412, "protocol", "operation-failed", "Target resource does not exist.");
+    }
 
-    if (requestCtx->req.method() == "PATCH" && !nodeExisted) {
+    if (requestCtx->req.method == "PATCH" && !nodeExisted) {
         throw ErrorResponse(400, "protocol", "invalid-value", "Target resource does not exist");
     }
 
-    auto [edit, replacementNode] = createEditForPutAndPatch(ctx, requestCtx->req.uri().raw_path, requestCtx->payload, *requestCtx->dataFormat.request /* caller checks if the dataFormat.request is present */);
+    auto [edit, replacementNode] = createEditForPutAndPatch(ctx, requestCtx->req.uri.raw_path, requestCtx->payload, *requestCtx->dataFormat.request /* caller checks if the dataFormat.request is present */);
     validateInputMetaAttributes(ctx, *edit);
 
-    if (requestCtx->req.method() == "PUT") {
+    if (requestCtx->req.method == "PUT") {
         auto modNetconf = ctx.getModuleImplemented("ietf-netconf");
         replacementNode->newMeta(*modNetconf, "operation", "replace");
         yangInsert(*requestCtx, *replacementNode);
     }
 
-    requestCtx->sess.editBatch(*edit, sysrepo::DefaultOperation::Merge);
-    requestCtx->sess.applyChanges(timeout);
+    applyEdit(*requestCtx, *edit);
 
-    if (requestCtx->req.method() == "PUT") {
+    if (requestCtx->req.method == "PUT") {
         requestCtx->res.write_head(nodeExisted ? 204 : 201, {CORS});
     } else {
         requestCtx->res.write_head(204, {CORS});
@@ -846,7 +1302,8 @@ libyang::PrintFlags libyangPrintFlags(const libyang::DataNode& dataNode, const s
     } catch(const libyang::Error& e) {
     }
 
-    libyang::PrintFlags ret = libyang::PrintFlags::Siblings | libyang::PrintFlags::EmptyContainers;
+    // TreePrinter takes care of the siblings
+    libyang::PrintFlags ret = libyang::PrintFlags::EmptyContainers;
 
     if (!withDefaults && node && (node->schema().nodeType() == libyang::NodeType::Leaf || node->schema().nodeType() == libyang::NodeType::Leaflist) && node->asTerm().isImplicitDefault()) {
         return ret | libyang::PrintFlags::WithDefaultsAll;
@@ -867,10 +1324,581 @@ libyang::PrintFlags libyangPrintFlags(const libyang::DataNode& dataNode, const s
 }
 
 /* @brief Returns if the request should be treated as a YANG patch request */
-bool isYangPatch(const nghttp2::asio_http2::server::request& req)
+bool isYangPatch(const RequestInfo& req)
+{
+    auto it = req.headers.find("content-type");
+    return it != req.headers.end() && (it->second.value == "application/yang-patch+xml" || it->second.value == "application/yang-patch+json");
+}
+
+/** @short Where to put a copy of the whole response body once it has been printed, if anywhere */
+struct ResponseSink {
+    std::function<void(std::string&&)> store;
+    std::size_t maxSize;
+    std::function<void(const ErrorResponse&)> fail; ///< Where to report that the request has been rejected, if anywhere
+};
+
+/** @short Compress the response with the best content coding which the client accepts */
+void negotiateContentCoding(const nghttp2::asio_http2::header_map& headers, const http::DeferredResponse& res, const OutputOptions& options)
+{
+    if (!options.compression) {
+        return;
+    }
+    // even a client which does not accept any compressed coding has to learn that the response depends on that
+    res.encodeWith(http::chooseContentCoding(http::getHeaderValue(headers, "accept-encoding").value_or("")), options.compressionThreshold);
+}
+
+/** @short Does the client insist on fresh data via Cache-Control: no-cache? */
+bool noCacheRequested(const RequestInfo& req)
+{
+    auto [begin, end] = req.headers.equal_range("cache-control");
+    return std::any_of(begin, end, [](const auto& header) {
+        return header.second.value.find("no-cache") != std::string::npos;
+    });
+}
+
+/** @short Validators of a representation of configuration data, see RFC 8040's section 3.4.1 */
+struct Validators {
+    std::string entityTag;
+    std::chrono::system_clock::time_point lastModified;
+};
+
+std::optional<Validators> validators(const ModuleChanges& changes, const ResponseCache::Key& key)
+{
+    auto version = dataVersion(changes, key.datastore, key.path);
+    auto lastModified = changes.lastModifiedOfPath(key.datastore, key.path);
+    if (!version || !lastModified) {
+        return std::nullopt;
+    }
+
+    // a strong entity tag is specific to a representation, and that depends on much more than just the data
+    const auto representation = std::hash<std::string>{}(fmt::format("{}\n{}\n{}\n{}\n{}\n{}",
+        static_cast<int>(key.datastore), key.path, key.query, static_cast<int>(key.format), key.accessProfile, key.urlPrefix.value_or("")));
+    return Validators{
+        fmt::format("{}{:x}-{:x}\"", *version, changes.nacmRevision(), representation),
+        *lastModified,
+    };
+}
+
+void addValidators(nghttp2::asio_http2::header_map& headers, const std::optional<Validators>& validators)
+{
+    if (validators) {
+        headers.emplace("etag", nghttp2::asio_http2::header_value{validators->entityTag, false});
+        headers.emplace("last-modified", nghttp2::asio_http2::header_value{http::formatHttpDate(validators->lastModified), false});
+    }
+}
+
+/** @short Does the client have the current representation already, as per RFC 9110's section 13.2.2? */
+bool notModified(const RequestInfo& req, const Validators& validators)
+{
+    if (auto ifNoneMatch = http::getHeaderValue(req.headers, "if-none-match")) {
+        return http::entityTagListContains(*ifNoneMatch, validators.entityTag, true);
+    }
+    if (auto ifModifiedSince = http::getHeaderValue(req.headers, "if-modified-since")) {
+        auto since = http::parseHttpDate(*ifModifiedSince);
+        return since && std::chrono::floor<std::chrono::seconds>(validators.lastModified) <= *since;
+    }
+    return false;
+}
+
+/** @short Feed the serialized data into nghttp2 chunk by chunk, whenever the flow control allows sending more
+ *
+ * The @p prefix is what has been taken out of the printer already.
+ */
+nghttp2::asio_http2::generator_cb streamedResponse(const std::string& peer, std::shared_ptr<ParallelTreePrinter> printer, std::string&& prefix)
 {
-    auto it = req.header().find("content-type");
-    return it != req.header().end() && (it->second.value == "application/yang-patch+xml" || it->second.value == "application/yang-patch+json");
+    return [peer, printer = std::move(printer), buffer = std::move(prefix), offset = std::size_t{0}](uint8_t* data, std::size_t length, uint32_t* flags) mutable -> ssize_t {
+        try {
+            while (offset == buffer.size()) {
+                switch (printer->next(buffer)) {
+                case ParallelTreePrinter::Status::Ready:
+                    offset = 0;
+                    break;
+                case ParallelTreePrinter::Status::Pending:
+                    return NGHTTP2_ERR_DEFERRED;
+                case ParallelTreePrinter::Status::Finished:
+                    *flags |= NGHTTP2_DATA_FLAG_EOF;
+                    return 0;
+                }
+            }
+        } catch (const std::exception& e) {
+            // the headers are gone already, so the only option is to reset the stream
+            spdlog::error("{}: Cannot serialize data: {}", peer, e.what());
+            return NGHTTP2_ERR_TEMPORAL_CALLBACK_FAILURE;
+        }
+
+        auto n = std::min(length, buffer.size() - offset);
+        std::copy_n(buffer.data() + offset, n, data);
+        offset += n;
+        return n;
+    };
+}
+
+/** @short Drop the entries of lists and leaf-lists nested in the @p targets beyond the first ones, as asked for by the sublist-limit query parameter */
+void limitSublists(const RestconfRequest& restconfRequest, const std::vector<libyang::DataNode>& targets)
+{
+    auto it = restconfRequest.queryParams.find("sublist-limit");
+    if (it == restconfRequest.queryParams.end() || !std::holds_alternative<unsigned int>(it->second)) {
+        return;
+    }
+    const auto limit = std::get<unsigned int>(it->second);
+
+    std::vector<libyang::DataNode> excess;
+    for (const auto& target : targets) {
+        for (const auto& node : target.childrenDfs()) {
+            std::map<std::string, unsigned> entries;
+            for (const auto& child : node.immediateChildren()) {
+                const auto nodeType = child.schema().nodeType();
+                if ((nodeType == libyang::NodeType::List || nodeType == libyang::NodeType::Leaflist) && ++entries[child.schema().path()] > limit) {
+                    excess.emplace_back(child);
+                }
+            }
+        }
+    }
+
+    for (auto& node : excess) {
+        node.unlink();
+    }
+}
+
+/** @short Data for a GET request, with the URLs adjusted so that they point to the server as seen by the client */
+std::optional<libyang::DataNode> fetchData(sysrepo::Session& sess, const RestconfRequest& restconfRequest, const std::chrono::milliseconds timeout, DatastoreMirror* mirror, const std::optional<std::string>& urlPrefix)
+{
+    const auto maxDepth = sysrepoMaxDepth(restconfRequest);
+    const auto getOptions = sysrepoGetOptions(restconfRequest);
+
+    const auto xpath = dataXPath(sess.getContext(), restconfRequest);
+
+    std::optional<libyang::DataNode> data;
+    // the mirror holds complete copies of the configuration datastores, so any filtering has to be done by sysrepo
+    if (mirror && maxDepth == 0 && getOptions != sysrepo::GetOptions::OperNoConfig && !restconfRequest.queryParams.contains("fields") && !restconfRequest.queryParams.contains("filter")) {
+        data = mirror->getData(sess, xpath, timeout);
+    } else {
+        data = sess.getData(xpath, maxDepth, getOptions, timeout);
+    }
+
+    if (data) {
+        if (restconfRequest.queryParams.contains("sublist-limit")) {
+            std::vector<libyang::DataNode> targets;
+            for (const auto& node : data->findXPath(restconfRequest.path)) {
+                targets.emplace_back(node);
+            }
+            limitSublists(restconfRequest, targets);
+        }
+        data = replaceYangLibraryLocations(urlPrefix, yangSchemaRoot, *data);
+        data = replaceStreamLocations(urlPrefix, *data);
+    }
+    return data;
+}
+
+/** @short A cursor of the list pagination is an opaque token for clients, but it is just the keys of the list entry */
+std::string asCursor(const libyang::DataNode& entry)
+{
+    std::vector<std::string> values;
+    if (entry.schema().nodeType() == libyang::NodeType::Leaflist) {
+        values.emplace_back(entry.asTerm().valueStr());
+    } else {
+        for (const auto& key : entry.schema().asList().keys()) {
+            values.emplace_back(entry.findPath(std::string{key.name()})->asTerm().valueStr());
+        }
+    }
+
+    std::string res;
+    for (std::size_t i = 0; i < values.size(); ++i) {
+        if (i > 0) {
+            res += '-';
+        }
+        for (const unsigned char c : values[i]) {
+            res += fmt::format("{:02x}", c);
+        }
+    }
+    return res;
+}
+
+/** @short The key predicate of the list entry that the @p cursor refers to */
+std::string cursorPredicate(const libyang::SchemaNode& schema, const std::string& cursor)
+{
+    std::vector<std::string> values{""};
+    for (std::size_t i = 0; i < cursor.size(); ++i) {
+        if (cursor[i] == '-') {
+            values.emplace_back();
+        } else if (i + 1 < cursor.size() && std::isxdigit(static_cast<unsigned char>(cursor[i])) && std::isxdigit(static_cast<unsigned char>(cursor[i + 1]))) {
+            values.back() += static_cast<char>(std::stoi(cursor.substr(i, 2), nullptr, 16));
+            ++i;
+        } else {
+            throw ErrorResponse(400, "protocol", "invalid-value", "Invalid cursor");
+        }
+    }
+
+    try {
+        if (schema.nodeType() == libyang::NodeType::Leaflist && values.size() == 1) {
+            return leaflistKeyPredicate(values.front());
+        } else if (schema.nodeType() == libyang::NodeType::List && schema.asList().keys().size() == values.size()) {
+            return listKeyPredicate(schema.asList().keys(), values);
+        }
+    } catch (const std::invalid_argument&) {
+    }
+    throw ErrorResponse(400, "protocol", "invalid-value", "Invalid cursor");
+}
+
+/** @short The query string of the next page, i.e., the current one which starts elsewhere */
+std::string nextPageQuery(const std::string& rawQuery, const std::string& start)
+{
+    std::vector<std::string> params;
+    boost::split(params, rawQuery, boost::is_any_of("&"));
+    std::erase_if(params, [](const auto& param) { return param.empty() || param.starts_with("cursor=") || param.starts_with("offset="); });
+    params.emplace_back(start);
+    return boost::algorithm::join(params, "&");
+}
+
+/** @short One page of a list or a leaf-list, and the query string of the next page if there is one
+ *
+ * Only the entries of the page are retrieved from sysrepo, plus one more which tells whether there is a next page.
+ * A cursor refers to the last entry which the client has seen, so unlike the offset, it is not affected by entries
+ * added or removed in the meantime. Lists without keys can be paged only by the offset. The two cannot be combined,
+ * see validateQueryParameters().
+ *
+ * The entries are always in the order of the list, even when paging backwards.
+ *
+ * Only the size of the response is bounded by the page, not the cost of producing it. Sysrepo loads the whole
+ * datastore content of the module, the operational callbacks provide the whole list, and the entries are then picked
+ * by an XPath over their position() which walks the siblings around the page. A page of a big list therefore still
+ * costs time proportional to the size of the list, just without printing and sending all of it.
+ */
+std::pair<std::optional<libyang::DataNode>, std::optional<std::string>> fetchListPage(sysrepo::Session& sess, const RestconfRequest& restconfRequest, const std::string& rawQuery, const std::chrono::milliseconds timeout, const std::optional<std::string>& urlPrefix)
+{
+    const auto& params = restconfRequest.queryParams;
+    const auto& base = restconfRequest.path;
+
+    if (params.contains("sort-by")) {
+        // libyang keeps the entries of system-ordered lists sorted by their keys, so there is no way of printing them in a different order
+        throw ErrorResponse(501, "application", "operation-not-supported", "Sorting of list entries is not supported");
+    }
+
+    std::optional<uint64_t> limit;
+    if (auto it = params.find("limit"); it != params.end() && std::holds_alternative<unsigned int>(it->second)) {
+        limit = std::get<unsigned int>(it->second);
+    }
+    uint64_t offset = 0;
+    if (auto it = params.find("offset"); it != params.end()) {
+        offset = std::get<unsigned int>(it->second);
+    }
+    const auto direction = params.find("direction");
+    const bool backwards = direction != params.end() && std::holds_alternative<queryParams::direction::Backwards>(direction->second);
+
+    const auto schema = sess.getContext().findPath(base);
+    const bool keyless = schema.nodeType() == libyang::NodeType::List && schema.asList().keys().empty();
+    // the last segment of the path is never followed by any predicate, and it is qualified whenever necessary
+    const auto step = base.substr(base.rfind('/') + 1);
+
+    std::optional<std::string> cursorPath;
+    std::vector<std::string> selections;
+    if (auto it = params.find("cursor"); it != params.end()) {
+        // there is no offset here, validateQueryParameters() does not allow it together with a cursor
+        if (keyless) {
+            throw ErrorResponse(400, "protocol", "invalid-value", "List '" + schema.path() + "' has no keys, so it can be paged only by an offset");
+        }
+        cursorPath = base + cursorPredicate(schema, std::get<std::string>(it->second));
+        // the entry at the cursor is a part of the result, so that its removal can be told apart from the end of the list
+        selections = {
+            *cursorPath,
+            *cursorPath + (backwards ? "/preceding-sibling::" : "/following-sibling::") + step + (limit ? "[position() <= " + std::to_string(*limit + 1) + "]" : ""),
+        };
+    } else if (backwards) {
+        selections = {base + "[position() <= last() - " + std::to_string(offset) + (limit ? " and position() > last() - " + std::to_string(offset + *limit + 1) : "") + "]"};
+    } else {
+        selections = {base + "[position() > " + std::to_string(offset) + (limit ? " and position() <= " + std::to_string(offset + *limit + 1) : "") + "]"};
+    }
+
+    auto xpath = boost::algorithm::join(selections, " | ");
+    if (auto it = params.find("fields"); it != params.end()) {
+        // the fields are checked against the whole list, and then they are picked from each selection of its entries
+        const auto fields = fieldsToXPath(sess.getContext(), base, std::get<queryParams::fields::Expr>(it->second));
+        std::vector<std::string> paths;
+        for (const auto& selection : selections) {
+            paths.emplace_back(boost::algorithm::replace_all_copy(fields, base + "/", selection + "/"));
+            // the keys make sure that each entry is present even when none of the fields are
+            if (!keyless) {
+                for (const auto& key : schema.asList().keys()) {
+                    paths.emplace_back(selection + "/" + std::string{key.name()});
+                }
+            }
+        }
+        xpath = boost::algorithm::join(paths, " | ");
+    }
+
+    auto data = sess.getData(xpath, sysrepoMaxDepth(restconfRequest), sysrepoGetOptions(restconfRequest), timeout);
+
+    std::vector<libyang::DataNode> entries;
+    if (data) {
+        for (const auto& entry : data->findXPath(base)) {
+            entries.emplace_back(entry);
+        }
+    }
+
+    std::vector<libyang::DataNode> excess;
+    if (cursorPath) {
+        std::optional<std::string> pathAtCursor;
+        if (auto atCursor = data ? std::optional{data->findXPath(*cursorPath)} : std::nullopt; atCursor && atCursor->size() == 1) {
+            pathAtCursor = atCursor->begin()->path();
+        }
+        auto it = std::find_if(entries.begin(), entries.end(), [&pathAtCursor](const auto& entry) { return entry.path() == pathAtCursor; });
+        if (it == entries.end()) {
+            throw ErrorResponse(400, "protocol", "invalid-value", "The list entry at the cursor does not exist");
+        }
+        excess.emplace_back(*it);
+        entries.erase(it);
+    } else if (entries.empty() && offset > 0) {
+        throw ErrorResponse(400, "protocol", "invalid-value", "Offset is out of range");
+    }
+
+    std::optional<std::string> next;
+    if (limit && entries.size() > *limit) {
+        if (backwards) {
+            excess.emplace_back(entries.front());
+            entries.erase(entries.begin());
+        } else {
+            excess.emplace_back(entries.back());
+            entries.pop_back();
+        }
+        const auto& last = backwards ? entries.front() : entries.back();
+        next = nextPageQuery(rawQuery, keyless ? "offset=" + std::to_string(offset + *limit) : "cursor=" + asCursor(last));
+    }
+
+    for (auto& node : excess) {
+        node.unlink();
+    }
+    if (entries.empty()) {
+        return {std::nullopt, std::nullopt};
+    }
+
+    // the first node of the result might have been one of the unlinked entries
+    data = entries.front();
+    while (data->parent()) {
+        data = *data->parent();
+    }
+    data = data->firstSibling();
+
+    limitSublists(restconfRequest, entries);
+    data = replaceYangLibraryLocations(urlPrefix, yangSchemaRoot, *data);
+    data = replaceStreamLocations(urlPrefix, *data);
+    return {data, next};
+}
+
+libyang::PrintFlags libyangPrintFlags(const libyang::DataNode& data, const RestconfRequest& restconfRequest)
+{
+    std::optional<queryParams::QueryParamValue> withDefaults;
+    if (auto it = restconfRequest.queryParams.find("with-defaults"); it != restconfRequest.queryParams.end()) {
+        withDefaults = it->second;
+    }
+    return libyangPrintFlags(data, restconfRequest.path, withDefaults);
+}
+
+void processGetData(std::shared_ptr<RequestContext> requestCtx, WorkerPool* serializers, DatastoreMirror* mirror, std::optional<ResponseSink> sink, nghttp2::asio_http2::header_map headers)
+{
+    const auto& restconfRequest = requestCtx->restconfRequest;
+    const auto urlPrefix = http::parseUrlPrefix(requestCtx->req.headers);
+
+    std::optional<libyang::DataNode> data;
+    if (isListPagination(restconfRequest.queryParams)) {
+        std::optional<std::string> next;
+        std::tie(data, next) = fetchListPage(*requestCtx->sess, restconfRequest, requestCtx->req.uri.raw_query, requestCtx->timeout(), urlPrefix);
+        if (next) {
+            // a reference which consists of just the query string is resolved against the URI of this request
+            headers.emplace("link", nghttp2::asio_http2::header_value{"<?" + *next + ">; rel=\"next\"", false});
+        }
+    } else {
+        data = fetchData(*requestCtx->sess, restconfRequest, requestCtx->timeout(), mirror, urlPrefix);
+    }
+
+    if (data) {
+        // the client might have given up while the data were being collected, and serialization is expensive
+        requestCtx->checkCancelled();
+        requestCtx->res.write_head(200, headers);
+
+        // The tree is split into pieces (see TreePrinter) which are printed in parallel by the serializers, and the result
+        // is sent piece by piece.
+        // Without the serializers, everything is printed right here, before the HTTP event loop gets to send any of it.
+        ParallelTreePrinter::Submit submit = [](std::function<void()> task) { task(); };
+        auto window = std::numeric_limits<std::size_t>::max();
+        if (serializers) {
+            // the serializers' queue is not limited, so this cannot fail
+            submit = [serializers](std::function<void()> task) { (void)serializers->post(std::move(task)); };
+            window = serializers->threads() * 2;
+        }
+        // The printer takes over the tree, so no other wrapper of its nodes stays in this thread once the response has
+        // been handed over to the HTTP event loop.
+        const auto flags = requestCtx->outputFlags(libyangPrintFlags(*data, restconfRequest));
+        auto printer = std::make_shared<ParallelTreePrinter>(
+            TreePrinter{std::move(*data), requestCtx->dataFormat.response, flags},
+            submit,
+            [res = requestCtx->res]() { res.resume(); },
+            window);
+        data.reset();
+        printer->start();
+
+        // A body which is shared with identical requests or cached is collected right here, so that it is ready for them
+        // no matter how fast this request's own client reads. One which turns out to be too big is streamed as usual.
+        std::string prefix;
+        if (sink) {
+            std::string chunk;
+            while (printer->wait(chunk) == ParallelTreePrinter::Status::Ready) {
+                prefix += chunk;
+                if (prefix.size() > sink->maxSize) {
+                    sink.reset();
+                    break;
+                }
+            }
+            if (sink) {
+                sink->store(std::string{prefix});
+                requestCtx->res.end(std::move(prefix));
+                return;
+            }
+        }
+        requestCtx->res.end(streamedResponse(requestCtx->req.peer, std::move(printer), std::move(prefix)));
+    } else {
+        throw ErrorResponse(404, "application", "invalid-value", "No data from sysrepo.");
+    }
+}
+
+void processDelete(std::shared_ptr<RequestContext> requestCtx)
+{
+    auto ctx = requestCtx->sess->getContext();
+    // a missing target is reported as 404 anyway, so there is nothing to do about "If-Match: *"
+    auto locks = lockForEdit(*requestCtx, false);
+
+    try {
+        auto [edit, deletedNode] = ctx.newPath2(requestCtx->restconfRequest.path, std::nullopt, libyang::CreationOptions::Opaque);
+
+        validateInputMetaAttributes(ctx, *edit);
+
+        // If the node could be created, it will not be opaque. However, setting meta attributes
+        // to opaque and standard nodes is a different process.
+        if (deletedNode->isOpaque()) {
+            deletedNode->newAttrOpaqueJSON("ietf-netconf", "operation", "delete");
+        } else {
+            auto netconf = ctx.getModuleLatest("ietf-netconf");
+            deletedNode->newMeta(*netconf, "operation", "delete");
+        }
+
+        applyEdit(*requestCtx, *edit);
+    } catch (const sysrepo::ErrorWithCode& e) {
+        if (e.code() == sysrepo::ErrorCode::Unauthorized) {
+            throw ErrorResponse(403, "application", "access-denied", "Access denied.", requestCtx->restconfRequest.path);
+        } else if (e.code() == sysrepo::ErrorCode::NotFound) {
+            /* The RFC is not clear at all on the error-tag.
+             * See https://mailarchive.ietf.org/arch/msg/netconf/XcF9r3ek3LvZ4DjF-7_B8kxuiwA/
+             * Also, if we replace 403 with 404 in order not to reveal if the node does not exist or
+             * if the user is not authorized then we should return the error tag invalid-value.
+             * This clashes with the data-missing tag below and we reveal it anyway :(
+             */
+            throw ErrorResponse(404, "application", "data-missing", "Data is missing.", requestCtx->restconfRequest.path);
+        }
+
+        throw;
+    }
+
+    requestCtx->res.write_head(204, {CORS});
+    requestCtx->res.end();
+}
+
+/** @short Open additional sysrepo connections, besides the one which was passed to us */
+std::vector<sysrepo::Connection> openConnections(sysrepo::Connection conn, const std::size_t count)
+{
+    std::vector<sysrepo::Connection> connections{conn};
+    while (connections.size() < count) {
+        connections.emplace_back();
+    }
+    return connections;
+}
+
+/** @short Run the blocking part of the request processing in the worker pool, or reject the request if the pool is saturated */
+void offload(WorkerPool& workers, const std::shared_ptr<RequestContext>& requestCtx, std::function<void()> task)
+{
+    auto checked = [requestCtx, task = std::move(task)]() {
+        // the client might have given up while the request was waiting in the queue
+        if (requestCtx->res.closed()) {
+            spdlog::debug("{}: Client has gone away, request abandoned", requestCtx->req.peer);
+            return;
+        }
+        task();
+    };
+
+    if (!workers.post(std::move(checked))) {
+        rejectWithError(requestCtx->sess->getContext(), requestCtx->dataFormat.response, requestCtx->req, requestCtx->res, 503, "application", "resource-denied", "Too many requests are being processed, try again later.", std::nullopt);
+    }
+}
+
+/** @short Set up the processing of a request once its whole payload has arrived
+ *
+ * This happens in a callback of the HTTP stream, not in the request handler, so the errors have to be reported here.
+ */
+void startWithPayload(const libyang::Context& ctx, const RequestInfo& requestInfo, const http::DeferredResponse& res, const DataFormat& dataFormat, const std::function<void()>& start)
+{
+    try {
+        start();
+    } catch (const ErrorResponse& e) {
+        rejectWithError(ctx, dataFormat.response, requestInfo, res, e.code, e.errorType, e.errorTag, e.errorMessage, e.errorPath, e.errorInfo);
+    } catch (const sysrepo::ErrorWithCode& e) {
+        spdlog::error("Sysrepo exception: {}", e.what());
+        rejectWithError(ctx, dataFormat.response, requestInfo, res, 500, "application", "operation-failed", "Internal server error due to sysrepo exception.", std::nullopt);
+    }
+}
+
+/** @short A read which can share its response with identical reads */
+struct CoalescedRead {
+    RequestCoalescer::Key key;
+    AdmissionControl::RequestClass requestClass;
+    std::function<void(AdmissionControl::Ticket&&, std::optional<ResponseSink>)> start; ///< Process the request in a worker
+    std::function<void(std::string&&)> store; ///< Where to put the response for the ResponseCache, if anywhere
+    std::optional<ResponseSink> cacheSink;
+    std::function<void(const std::string&)> respond; ///< Send a response body which some other request has obtained
+    std::function<void(const ErrorResponse&)> reject;
+};
+
+/** @short Process the read as the leader of its identical reads, or wait for the response of their current leader
+ *
+ * When the leader gives up without a response or an error to share, each of its waiters has to be admitted once again.
+ * They then join the coalescer anew, so that just one of them becomes the next leader and the others wait for that one.
+ */
+void coalesceRead(RequestCoalescer& coalescer, AdmissionControl& admission, const std::shared_ptr<const CoalescedRead>& read, AdmissionControl::Ticket&& ticket)
+{
+    // waiting requests do not occupy any worker, so they give up their admission ticket right away
+    auto waiter = [&coalescer, &admission, read](const RequestCoalescer::Outcome& outcome) {
+        if (outcome.body) {
+            read->respond(*outcome.body);
+            return;
+        }
+        if (outcome.error) {
+            read->reject(*outcome.error);
+            return;
+        }
+        try {
+            auto ticket = admission.admit(read->requestClass);
+            if (!ticket) {
+                throw ErrorResponse(503, "application", "resource-denied", "Too many similar requests are being processed, try again later.");
+            }
+            coalesceRead(coalescer, admission, read, std::move(*ticket));
+        } catch (const ErrorResponse& e) {
+            read->reject(e);
+        } catch (const std::exception& e) {
+            spdlog::error("Cannot process a coalesced request: {}", e.what());
+            read->reject(ErrorResponse(500, "application", "operation-failed", "Internal server error"));
+        }
+    };
+
+    if (auto leader = coalescer.join(read->key, waiter)) {
+        read->start(std::move(ticket), ResponseSink{
+            [leader, store = read->store](std::string&& body) {
+                if (store) {
+                    store(std::string{body});
+                }
+                leader->finish(std::move(body));
+            },
+            std::max(RequestCoalescer::maxBodySize, read->cacheSink ? read->cacheSink->maxSize : 0),
+            [leader](const ErrorResponse& e) { leader->fail(e); }});
+    } else {
+        spdlog::debug("Waiting for an identical request which is in progress");
+    }
 }
 }
 
@@ -897,16 +1925,82 @@ void Server::stop()
 
 void Server::join()
 {
-    /* FIXME: nghttp2-asio is calling io.run() wrapped in std::async.
-     * In case the handler function throws, the exception is not propagated to the main thread *until* someone calls server.join() which calls future.get() on all io.run() wrappers.
-     * Thankfully, we have only one thread, so we can just call join() right away. Underlying future.get() blocks until io.run() finishes, either gracefully or upon uncaught exception.
-     *
-     * !!! Will not work server uses multiple threads !!!
+    /* nghttp2-asio runs each io_context in its own std::async wrapper and its join() collects these futures one by one.
+     * An exception which escapes from one of the threads would therefore only be seen after all the preceding threads
+     * have finished, i.e., possibly never. That's why the request handlers are wrapped in handle() which records
+     * the first failure and stops the whole server. All the threads then exit and we can rethrow here.
      */
 
     // main thread waits here
     server->join();
     joined = true;
+
+    std::lock_guard lock{m_errorMutex};
+    if (m_error) {
+        std::rethrow_exception(m_error);
+    }
+}
+
+/** @short Register a HTTP handler and make sure that any exception thrown from it shuts the server down */
+void Server::handle(const std::string& pattern, Handler handler)
+{
+    server->handle(pattern, [this, pattern, handler = std::move(handler)](const auto& req, const auto& res) {
+        try {
+            handler(req, res);
+        } catch (...) {
+            spdlog::critical("{}: Unhandled exception in the handler for {}", http::peer_from_request(req), pattern);
+            failed(std::current_exception());
+        }
+    });
+}
+
+void Server::failed(std::exception_ptr error)
+{
+    {
+        std::lock_guard lock{m_errorMutex};
+        if (m_error) {
+            return;
+        }
+        m_error = error;
+    }
+
+    stop();
+}
+
+/** @short Replace a stale cached response with a fresh one in the background */
+void Server::refreshCachedResponse(const ResponseCache::Key& key, const RestconfRequest& restconfRequest, const std::string& nacmUser, const std::chrono::milliseconds timeout, std::function<void(std::string&&)> store)
+{
+    auto task = [this, key, restconfRequest, nacmUser, timeout, store = std::move(store)]() {
+        try {
+            auto sess = m_sessions.checkout(key.datastore, nacmUser);
+            if (auto data = fetchData(*sess, restconfRequest, timeout, m_mirror.get(), key.urlPrefix)) {
+                auto flags = withCompactOutput(compactOutput(restconfRequest, m_outputOptions.compact), libyangPrintFlags(*data, restconfRequest));
+                store(*data->printStr(key.format, flags | libyang::PrintFlags::Siblings));
+                return;
+            }
+        } catch (const std::exception& e) {
+            spdlog::warn("Cannot refresh a cached response for {}: {}", key.path, e.what());
+        }
+        m_responseCache->drop(key);
+    };
+
+    if (!m_workers.post(std::move(task))) {
+        m_responseCache->drop(key);
+    }
+}
+
+/** @short Authenticate the request, either via the peer credentials of a local client, or via the usual HTTP means */
+std::string Server::authorize(const nghttp2::asio_http2::server::request& req) const
+{
+    for (const auto& [relay, peerCredentialsAsNacmUser] : m_extraSockets) {
+        if (!peerCredentialsAsNacmUser) {
+            continue;
+        }
+        if (auto credentials = relay->peer(req.remote_endpoint())) {
+            return auth::authorizeLocalUser(nacm, credentials->uid);
+        }
+    }
+    return auth::authorizeRequest(nacm, req);
 }
 
 std::vector<std::shared_ptr<boost::asio::io_context>> Server::io_services() const
@@ -914,20 +2008,33 @@ std::vector<std::shared_ptr<boost::asio::io_context>> Server::io_services() cons
     return server->io_services();
 }
 
-Server::Server(
-    sysrepo::Connection conn,
-    const std::string& address,
-    const std::string& port,
-    const std::chrono::milliseconds timeout,
-    const std::chrono::seconds keepAlivePingInterval,
-    const std::chrono::seconds subNotifInactivityTimeout)
+Server::Server(sysrepo::Connection conn, const std::string& address, const std::string& port, const ServerOptions& options)
     : m_monitoringSession(conn.sessionStart(sysrepo::Datastore::Operational))
     , nacm(conn)
+    // there cannot be more requests using a session at once than there are threads which process them
+    , m_sessions(openConnections(conn, options.connections), options.threads + options.workerThreads)
+    , m_moduleChanges(options.cache.datastoreMirror || options.cache.responseCacheSize || options.cache.entityTags ? std::make_unique<ModuleChanges>(conn) : nullptr)
+    , m_mirror(options.cache.datastoreMirror ? std::make_unique<DatastoreMirror>(*m_moduleChanges, options.cache.mirrorMaxEntries) : nullptr)
+    , m_responseCache(options.cache.responseCacheSize ? std::make_unique<ResponseCache>(*m_moduleChanges, options.cache.responseCacheSize) : nullptr)
+    , m_coalescer(options.cache.coalesceReads ? std::make_unique<RequestCoalescer>() : nullptr)
+    , m_changeJournal(options.cache.changeJournalSize ? std::make_unique<ChangeJournal>(conn, options.cache.changeJournalSize) : nullptr)
+    , m_entityTags(options.cache.entityTags)
+    , m_outputOptions(options.output)
+    , m_admission(admissionLimits(options.workerThreads))
     , server{std::make_unique<nghttp2::asio_http2::server::http2>()}
-    , m_dynamicSubscriptions(netconfStreamRoot, *server, subNotifInactivityTimeout)
+    , m_dynamicSubscriptions(netconfStreamRoot, *server, options.subNotifInactivityTimeout, options.instanceId)
     , dwdmEvents{std::make_unique<sr::OpticalEvents>(conn.sessionStart())}
+    // each response keeps a bounded number of its pieces in the serializers' queue, and the responses are already limited by the admission control
+    , m_serializers(options.serializerThreads ? std::make_unique<WorkerPool>(options.serializerThreads, std::numeric_limits<std::size_t>::max(), [](std::exception_ptr) {
+        spdlog::critical("Unhandled exception in a serializer thread");
+    }) : nullptr)
+    , m_workers(options.workerThreads, options.workerThreads * maxPendingRequestsPerWorker, [this](std::exception_ptr error) {
+        spdlog::critical("Unhandled exception in a worker thread");
+        failed(error);
+    })
 {
-    server->num_threads(1); // we only use one thread for the server, so we can call join() right away
+    // each thread runs its own io_context, and new connections are distributed among these in a round-robin manner
+    server->num_threads(options.threads);
     server->read_timeout(boost::posix_time::seconds{60}); // terminate connection after 60 seconds of inactivity (this is explicitly setting the default value)
 
     for (const auto& [module, version, features] : {
@@ -938,9 +2045,13 @@ Server::Server(
              {"ietf-yang-patch", "2017-02-22", {}},
              {"ietf-subscribed-notifications", "2019-09-09", {"encode-xml", "encode-json", "xpath", "subtree", "replay"}},
              {"ietf-restconf-subscribed-notifications", "2019-11-17", {}},
-             {"rousette", "2026-04-20", {}},
+             {"rousette", "2026-10-15", {}},
          }) {
         if (auto mod = m_monitoringSession.getContext().getModuleImplemented(module)) {
+            // newer revisions of a module are backward compatible, and the revision dates compare just like strings
+            if (mod->revision().value_or("") < version) {
+                throw std::runtime_error("Module "s + module + "@" + version + " is implemented in sysrepo in an older revision " + mod->revision().value_or("(none)"));
+            }
             for (const auto& feature : features) {
                 if (!mod->featureEnabled(feature)) {
                     throw std::runtime_error("Module "s + module + "@" + version + " does not implement feature " + feature);
@@ -957,27 +2068,65 @@ Server::Server(
     m_monitoringSession.setItem("/ietf-restconf-monitoring:restconf-state/capabilities/capability[3]", "urn:ietf:params:restconf:capability:with-defaults:1.0");
     m_monitoringSession.setItem("/ietf-restconf-monitoring:restconf-state/capabilities/capability[4]", "urn:ietf:params:restconf:capability:filter:1.0");
     m_monitoringSession.setItem("/ietf-restconf-monitoring:restconf-state/capabilities/capability[5]", "urn:ietf:params:restconf:capability:fields:1.0");
+    m_monitoringSession.setItem("/ietf-restconf-monitoring:restconf-state/capabilities/capability[6]", "urn:cesnet:params:restconf:capability:data-filter:1.0");
     m_monitoringSession.applyChanges();
 
-    m_monitoringOperSub = m_monitoringSession.onOperGet(
-        "ietf-restconf-monitoring", [](auto session, auto, auto, auto, auto, auto, auto& parent) {
-            notificationStreamList(session, parent, netconfStreamRoot);
-            return sysrepo::ErrorCode::Ok;
-        },
-        "/ietf-restconf-monitoring:restconf-state/streams/stream");
+    // all server processes provide the very same list, and sysrepo wouldn't accept duplicate providers anyway
+    if (options.instanceId.value_or(0) == 0) {
+        m_monitoringOperSub = m_monitoringSession.onOperGet(
+            "ietf-restconf-monitoring", [](auto session, auto, auto, auto, auto, auto, auto& parent) {
+                notificationStreamList(session, parent, netconfStreamRoot);
+                return sysrepo::ErrorCode::Ok;
+            },
+            "/ietf-restconf-monitoring:restconf-state/streams/stream");
+    }
+
+    if (m_responseCache) {
+        m_responseCachePolicySub = conn.sessionStart(sysrepo::Datastore::Running).onModuleChange(
+            "rousette", [this](auto session, auto, auto, auto, auto, auto) {
+                std::map<std::string, std::chrono::milliseconds> policies;
+                if (auto data = session.getData("/rousette:operational-cache")) {
+                    for (const auto& policy : data->findXPath("/rousette:operational-cache/policy")) {
+                        policies[policy.findPath("path")->asTerm().valueStr()] = std::chrono::milliseconds{std::get<uint32_t>(policy.findPath("ttl")->asTerm().value())};
+                    }
+                }
+                spdlog::debug("Operational data are cached for {} paths", policies.size());
+                m_responseCache->setTimeToLive(policies);
+                return sysrepo::ErrorCode::Ok;
+            },
+            "/rousette:operational-cache",
+            0,
+            sysrepo::SubscribeOptions::Enabled | sysrepo::SubscribeOptions::DoneOnly | sysrepo::SubscribeOptions::Passive);
+
+        const auto processPath = "/rousette:response-cache/process[id='" + std::to_string(options.instanceId.value_or(0)) + "']";
+        m_responseCacheStatsSub = m_monitoringSession.onOperGet(
+            "rousette", [this, processPath](auto session, auto, auto, auto, auto, auto, auto& parent) {
+                const auto stats = m_responseCache->stats();
+                if (!parent) {
+                    parent = session.getContext().newPath(processPath + "/hits", std::to_string(stats.hits));
+                } else {
+                    parent->newPath(processPath + "/hits", std::to_string(stats.hits));
+                }
+                parent->newPath(processPath + "/misses", std::to_string(stats.misses));
+                parent->newPath(processPath + "/entries", std::to_string(stats.entries));
+                parent->newPath(processPath + "/bytes", std::to_string(stats.bytes));
+                return sysrepo::ErrorCode::Ok;
+            },
+            processPath);
+    }
 
     dwdmEvents->change.connect([this](const std::string& content) {
         opticsChange(as_restconf_push_update(content, std::chrono::system_clock::now()));
     });
 
-    server->handle("/", [](const auto& req, const auto& res) {
+    handle("/", [](const auto& req, const auto& res) {
         logRequest(req);
 
         res.write_head(404, {TEXT_PLAIN, CORS});
         res.end();
     });
 
-    server->handle("/.well-known/host-meta", [](const auto& req, const auto& res) {
+    handle("/.well-known/host-meta", [](const auto& req, const auto& res) {
         logRequest(req);
 
         res.write_head(
@@ -989,13 +2138,13 @@ Server::Server(
         res.end("<XRD xmlns='http://docs.oasis-open.org/ns/xri/xrd-1.0'><Link rel='restconf' href='"s + restconfRoot + "'/></XRD>"s);
     });
 
-    server->handle("/telemetry/optics", [this, keepAlivePingInterval](const auto& req, const auto& res) {
+    handle("/telemetry/optics", [this, keepAlivePingInterval = options.keepAlivePingInterval](const auto& req, const auto& res) {
         logRequest(req);
 
-        http::EventStream::create(req, res, shutdownRequested, opticsChange, keepAlivePingInterval, as_restconf_push_update(dwdmEvents->currentData(), std::chrono::system_clock::now()));
+        http::EventStream::create(req, res, shutdownRequested, opticsChange, keepAlivePingInterval, m_outputOptions.compression, as_restconf_push_update(dwdmEvents->currentData(), std::chrono::system_clock::now()));
     });
 
-    server->handle(netconfStreamRoot, [this, conn, keepAlivePingInterval](const auto& req, const auto& res) mutable {
+    handle(netconfStreamRoot, [this, keepAlivePingInterval = options.keepAlivePingInterval](const auto& req, const auto& res) {
         logRequest(req);
 
         std::optional<std::string> xpathFilter;
@@ -1009,18 +2158,17 @@ Server::Server(
         }
 
         try {
-            auto sess = conn.sessionStart();
-            authorizeRequest(nacm, sess, req);
+            auto nacmUser = authorize(req);
 
             auto streamRequest = asRestconfStreamRequest(req.method(), req.uri().path, req.uri().raw_query);
 
             if (auto *request = std::get_if<SubscribedStreamRequest>(&streamRequest)) {
-                if (auto sub = m_dynamicSubscriptions.getSubscriptionForUser(request->uuid, sess.getNacmUser())) {
+                if (auto sub = m_dynamicSubscriptions.getSubscriptionForUser(request->uuid, nacmUser)) {
                     if (!sub->isReadyToAcceptClient()) {
                         throw ErrorResponse(409, "application", "resource-denied", "There is already another GET request on this subscription.");
                     }
 
-                    DynamicSubscriptionHttpStream::create(req, res, shutdownRequested, keepAlivePingInterval, sub);
+                    DynamicSubscriptionHttpStream::create(req, res, shutdownRequested, keepAlivePingInterval, m_outputOptions.compression, sub);
                 } else {
                     throw ErrorResponse(404, "application", "invalid-value", "Subscription not found.");
                 }
@@ -1039,12 +2187,14 @@ Server::Server(
                     stopTime = libyang::fromYangTimeFormat<std::chrono::system_clock>(std::get<std::string>(it->second));
                 }
 
+                // the session owns the notification subscription, so it cannot be shared with other requests
                 NotificationStream::create(
                     req,
                     res,
                     shutdownRequested,
                     keepAlivePingInterval,
-                    sess,
+                    m_outputOptions.compression,
+                    m_sessions.start(sysrepo::Datastore::Running, nacmUser),
                     request->encoding,
                     xpathFilter,
                     startTime,
@@ -1070,7 +2220,7 @@ Server::Server(
         }
     });
 
-    server->handle(yangSchemaRoot, [this, conn /* intentional copy */](const auto& req, const auto& res) mutable {
+    handle(yangSchemaRoot, [this](const auto& req, const auto& res) {
         logRequest(req);
 
         if (req.method() == "OPTIONS" || (req.method() != "GET" && req.method() != "HEAD")) {
@@ -1080,17 +2230,18 @@ Server::Server(
         }
 
         try {
-            auto sess = conn.sessionStart(sysrepo::Datastore::Operational);
-            authorizeRequest(nacm, sess, req);
+            auto sess = m_sessions.checkout(sysrepo::Datastore::Operational, authorize(req));
 
-            if (auto mod = asYangModule(sess.getContext(), req.uri().path); mod && hasAccessToYangSchema(sess, *mod)) {
-                res.write_head(
+            if (auto mod = asYangModule(sess->getContext(), req.uri().path); mod && hasAccessToYangSchema(*sess, *mod)) {
+                const http::DeferredResponse deferredRes{res};
+                negotiateContentCoding(req.header(), deferredRes, m_outputOptions);
+                deferredRes.write_head(
                     200,
                     {
                         contentType("application/yang"),
                         CORS,
                     });
-                res.end(std::visit([](auto&& arg) { return arg.printStr(libyang::SchemaOutputFormat::Yang); }, *mod));
+                deferredRes.end(std::visit([](auto&& arg) { return arg.printStr(libyang::SchemaOutputFormat::Yang); }, *mod));
                 return;
             } else {
                 res.write_head(404, {TEXT_PLAIN, CORS});
@@ -1114,73 +2265,124 @@ Server::Server(
         }
     });
 
-    server->handle(restconfRoot,
-        [conn /* intentionally by value, otherwise conn gets destroyed when the ctor returns */, this, timeout](const auto& req, const auto& res) mutable {
+    handle(restconfRoot,
+        [this, timeout = options.timeout, maxTimeouts = options.maxTimeouts](const auto& req, const auto& res) {
             logRequest(req);
 
-            auto sess = conn.sessionStart(sysrepo::Datastore::Operational);
+            const RequestInfo requestInfo{req};
+            const http::DeferredResponse deferredRes{res};
+            negotiateContentCoding(req.header(), deferredRes, m_outputOptions);
             DataFormat dataFormat;
             // default for "early exceptions" when the MIME type detection fails
             dataFormat.response = libyang::DataFormat::JSON;
 
             try {
                 dataFormat = chooseDataEncoding(req.header());
-                authorizeRequest(nacm, sess, req);
+                auto nacmUser = authorize(req);
 
-                auto restconfRequest = asRestconfRequest(sess.getContext(), req.method(), req.uri().raw_path, req.uri().raw_query);
+                auto restconfRequest = asRestconfRequest(m_sessions.context(), req.method(), req.uri().raw_path, req.uri().raw_query);
+                const auto compact = compactOutput(restconfRequest, m_outputOptions.compact);
+
+                // requests which can be answered cheaply (not modified, cached, API metadata) do not need any admission
+                const auto requestClass = AdmissionControl::classify(m_sessions.context(), restconfRequest);
+                auto admit = [this, requestClass]() {
+                    auto ticket = m_admission.admit(requestClass);
+                    if (!ticket) {
+                        throw ErrorResponse(503, "application", "resource-denied", "Too many similar requests are being processed, try again later.");
+                    }
+                    return std::move(*ticket);
+                };
+                const auto deadline = requestDeadline(requestInfo, maxTimeoutFor(maxTimeouts, restconfRequest.type));
 
                 switch (restconfRequest.type) {
                 case RestconfRequest::Type::RestconfRoot:
                 case RestconfRequest::Type::YangLibraryVersion:
                 case RestconfRequest::Type::ListRPC:
-                    res.write_head(200, {contentType(dataFormat.response), CORS});
-                    res.end(*apiResource(sess.getContext(), restconfRequest.type, dataFormat.response)
-                                 .printStr(dataFormat.response, libyang::PrintFlags::Siblings | libyang::PrintFlags::EmptyContainers));
+                    deferredRes.write_head(200, {contentType(dataFormat.response), CORS});
+                    deferredRes.end(*apiResource(m_sessions.context(), restconfRequest.type, dataFormat.response)
+                                         .printStr(dataFormat.response, withCompactOutput(compact, libyang::PrintFlags::Siblings | libyang::PrintFlags::EmptyContainers)));
                     break;
 
                 case RestconfRequest::Type::GetData: {
-                    sess.switchDatastore(restconfRequest.datastore.value_or(sysrepo::Datastore::Operational));
-
-                    int maxDepth = 0; /* unbounded depth is the RFC default, which in sysrepo terms is 0 */
-                    if (auto it = restconfRequest.queryParams.find("depth"); it != restconfRequest.queryParams.end() && std::holds_alternative<unsigned int>(it->second)) {
-                        maxDepth = std::get<unsigned int>(it->second);
+                    const auto datastore = restconfRequest.datastore.value_or(sysrepo::Datastore::Operational);
+                    const ResponseCache::Key key{datastore, restconfRequest.path, req.uri().raw_query, dataFormat.response, nacm.accessProfile(nacmUser), http::parseUrlPrefix(req.header())};
+                    nghttp2::asio_http2::header_map headers{contentType(dataFormat.response), CORS};
+                    if (m_entityTags) {
+                        auto current = validators(*m_moduleChanges, key);
+                        if (current && notModified(requestInfo, *current)) {
+                            nghttp2::asio_http2::header_map notModifiedHeaders{CORS};
+                            addValidators(notModifiedHeaders, current);
+                            deferredRes.write_head(304, notModifiedHeaders);
+                            deferredRes.end();
+                            break;
+                        }
+                        addValidators(headers, current);
                     }
 
-                    std::optional<queryParams::QueryParamValue> withDefaults;
-                    if (auto it = restconfRequest.queryParams.find("with-defaults"); it != restconfRequest.queryParams.end()) {
-                        withDefaults = it->second;
-                    }
+                    // both the cache and the coalescer keep just the body, but a page of a list might come with a Link header as well
+                    const bool paginated = isListPagination(restconfRequest.queryParams);
 
-                    sysrepo::GetOptions getOptions = sysrepo::GetOptions::Default; /* default get options: return all nodes */
-                    if (auto it = restconfRequest.queryParams.find("content"); it != restconfRequest.queryParams.end()) {
-                        if(std::holds_alternative<queryParams::content::OnlyNonConfigNodes>(it->second)) {
-                            getOptions = sysrepo::GetOptions::OperNoConfig;
-                        } else if(std::holds_alternative<queryParams::content::OnlyConfigNodes>(it->second)) {
-                            getOptions = sysrepo::GetOptions::OperNoState;
+                    std::function<void(std::string&&)> store;
+                    if (m_responseCache && !paginated) {
+                        if (auto revision = m_responseCache->revision(key)) {
+                            store = [cache = m_responseCache.get(), key, revision = *revision](std::string&& body) { cache->put(key, revision, std::move(body)); };
+                        } else if (auto ttl = datastore == sysrepo::Datastore::Operational ? m_responseCache->timeToLive(restconfRequest.path) : std::nullopt) {
+                            store = [cache = m_responseCache.get(), key, ttl = *ttl](std::string&& body) { cache->put(key, ttl, std::move(body)); };
                         }
-                    }
 
-                    auto xpath = restconfRequest.path;
-                    if (auto it = restconfRequest.queryParams.find("fields"); it != restconfRequest.queryParams.end()) {
-                        auto fields = std::get<queryParams::fields::Expr>(it->second);
-                        xpath = fieldsToXPath(sess.getContext(), xpath == "/*" ? "" : xpath, fields);
+                        if (store && !noCacheRequested(requestInfo)) {
+                            if (auto cached = m_responseCache->get(key); cached.body) {
+                                spdlog::debug("{}: Response served from the cache", requestInfo.peer);
+                                deferredRes.write_head(200, headers);
+                                deferredRes.end(*cached.body);
+                                if (cached.refresh) {
+                                    refreshCachedResponse(key, restconfRequest, nacmUser, timeout, store);
+                                }
+                                break;
+                            }
+                        }
                     }
 
-                    if (auto data = sess.getData(xpath, maxDepth, getOptions, timeout); data) {
-                        res.write_head(
-                            200,
-                            {
-                                contentType(dataFormat.response),
-                                CORS,
-                            });
-
-                        auto urlPrefix = http::parseUrlPrefix(req.header());
-                        data = replaceYangLibraryLocations(urlPrefix, yangSchemaRoot, *data);
-                        data = replaceStreamLocations(urlPrefix, *data);
-                        res.end(*data->printStr(dataFormat.response, libyangPrintFlags(*data, restconfRequest.path, withDefaults)));
-                    } else {
-                        throw ErrorResponse(404, "application", "invalid-value", "No data from sysrepo.");
+                    auto start = [this, requestInfo, deferredRes, dataFormat, datastore, nacmUser, restconfRequest, timeout, deadline, headers, compact](AdmissionControl::Ticket&& ticket, std::optional<ResponseSink> sink) {
+                        auto sess = m_sessions.checkout(datastore, nacmUser);
+                        auto requestCtx = std::make_shared<RequestContext>(requestInfo, deferredRes, dataFormat, std::move(sess), restconfRequest, std::move(ticket), timeout, deadline);
+                        requestCtx->compact = compact;
+                        offload(m_workers, requestCtx, [this, requestCtx, sink = std::move(sink), headers]() {
+                            // the identical requests which wait for this one are rejected with the very same error
+                            auto reject = [&sink](libyang::Context ctx, const libyang::DataFormat& dataFormat, const RequestInfo& req, const http::DeferredResponse& res, const int code, const std::string errorType, const std::string& errorTag, const std::string& errorMessage, const std::optional<std::string>& errorPath, const std::optional<ErrorResponse::ErrorInfo>& errorInfo) {
+                                if (sink && sink->fail) {
+                                    ErrorResponse e{code, errorType, errorTag, errorMessage, errorPath};
+                                    e.errorInfo = errorInfo;
+                                    sink->fail(e);
+                                }
+                                rejectWithError(ctx, dataFormat, req, res, code, errorType, errorTag, errorMessage, errorPath, errorInfo);
+                            };
+                            WITH_RESTCONF_EXCEPTIONS(processGetData, reject)(requestCtx, m_serializers.get(), m_mirror.get(), sink, headers);
+                        });
+                    };
+                    auto cacheSink = store ? std::optional<ResponseSink>{ResponseSink{store, m_responseCache->maxEntrySize(), nullptr}} : std::nullopt;
+
+                    if (m_coalescer && !paginated) {
+                        auto read = std::make_shared<const CoalescedRead>(CoalescedRead{
+                            .key = key,
+                            .requestClass = requestClass,
+                            .start = start,
+                            .store = store,
+                            .cacheSink = cacheSink,
+                            .respond = [requestInfo, deferredRes, headers](const std::string& body) {
+                                spdlog::debug("{}: Response shared with an identical request", requestInfo.peer);
+                                deferredRes.write_head(200, headers);
+                                deferredRes.end(body);
+                            },
+                            .reject = [this, requestInfo, deferredRes, dataFormat](const ErrorResponse& e) {
+                                rejectWithError(m_sessions.context(), dataFormat.response, requestInfo, deferredRes, e.code, e.errorType, e.errorTag, e.errorMessage, e.errorPath, e.errorInfo);
+                            },
+                        });
+                        coalesceRead(*m_coalescer, m_admission, read, admit());
+                        break;
                     }
+
+                    start(admit(), cacheSink);
                     break;
                 }
 
@@ -1191,86 +2393,89 @@ Server::Server(
                         throw ErrorResponse(405, "application", "operation-not-supported", "Read-only datastore.");
                     }
 
-                    sess.switchDatastore(restconfRequest.datastore.value_or(sysrepo::Datastore::Running));
                     if (!dataFormat.request) {
                         throw ErrorResponse(400, "protocol", "invalid-value", "Content-type header missing.");
                     }
 
-                    auto requestCtx = std::make_shared<RequestContext>(req, res, dataFormat, sess, restconfRequest);
+                    const auto datastore = restconfRequest.datastore.value_or(sysrepo::Datastore::Running);
+                    auto payload = std::make_shared<std::string>();
 
-                    req.on_data([requestCtx, restconfRequest /* intentional copy */, timeout, peer=http::peer_from_request(req)](const uint8_t* data, std::size_t length) {
+                    // neither the admission ticket nor the session are needed while the client is still uploading the data
+                    req.on_data([this, payload, admit, requestInfo, deferredRes, dataFormat, datastore, nacmUser, restconfRequest, timeout, deadline, compact](const uint8_t* data, std::size_t length) {
                         if (length > 0) { // there are still some data to be read
-                            requestCtx->payload.append(reinterpret_cast<const char*>(data), length);
+                            payload->append(reinterpret_cast<const char*>(data), length);
                             return;
                         }
 
-                        spdlog::trace("{}: HTTP payload: {}", peer, requestCtx->payload);
-
-                        if (restconfRequest.type == RestconfRequest::Type::CreateChildren) {
-                            WITH_RESTCONF_EXCEPTIONS(processPost, rejectWithError)(requestCtx, timeout);
-                        } else if (restconfRequest.type == RestconfRequest::Type::MergeData && isYangPatch(requestCtx->req)) {
-                            WITH_RESTCONF_EXCEPTIONS(processYangPatch, rejectWithError)(requestCtx, timeout);
-                        } else {
-                            WITH_RESTCONF_EXCEPTIONS(processPutOrPlainPatch, rejectWithError)(requestCtx, timeout);
-                        }
+                        spdlog::trace("{}: HTTP payload: {}", requestInfo.peer, *payload);
+
+                        startWithPayload(m_sessions.context(), requestInfo, deferredRes, dataFormat, [&]() {
+                            auto ticket = admit();
+                            auto sess = m_sessions.checkout(datastore, nacmUser);
+                            auto requestCtx = std::make_shared<RequestContext>(requestInfo, deferredRes, dataFormat, std::move(sess), restconfRequest, std::move(ticket), timeout, deadline);
+                            requestCtx->compact = compact;
+                            requestCtx->moduleChanges = m_moduleChanges.get();
+                            requestCtx->entityTags = m_entityTags;
+                            requestCtx->payload = std::move(*payload);
+
+                            offload(m_workers, requestCtx, [requestCtx, type = restconfRequest.type]() {
+                                if (type == RestconfRequest::Type::CreateChildren) {
+                                    WITH_RESTCONF_EXCEPTIONS(processPost, rejectWithError)(requestCtx);
+                                } else if (type == RestconfRequest::Type::MergeData && isYangPatch(requestCtx->req)) {
+                                    WITH_RESTCONF_EXCEPTIONS(processYangPatch, rejectWithError)(requestCtx);
+                                } else {
+                                    WITH_RESTCONF_EXCEPTIONS(processPutOrPlainPatch, rejectWithError)(requestCtx);
+                                }
+                            });
+                        });
                     });
                     break;
                 }
 
-                case RestconfRequest::Type::DeleteNode:
+                case RestconfRequest::Type::DeleteNode: {
                     if (restconfRequest.datastore == sysrepo::Datastore::FactoryDefault || restconfRequest.datastore == sysrepo::Datastore::Operational) {
                         throw ErrorResponse(405, "application", "operation-not-supported", "Read-only datastore.");
                     }
 
-                    sess.switchDatastore(restconfRequest.datastore.value_or(sysrepo::Datastore::Running));
-
-                    try {
-                        auto [edit, deletedNode] = sess.getContext().newPath2(restconfRequest.path, std::nullopt, libyang::CreationOptions::Opaque);
-
-                        validateInputMetaAttributes(sess.getContext(), *edit);
-
-                        // If the node could be created, it will not be opaque. However, setting meta attributes
-                        // to opaque and standard nodes is a different process.
-                        if (deletedNode->isOpaque()) {
-                            deletedNode->newAttrOpaqueJSON("ietf-netconf", "operation", "delete");
-                        } else {
-                            auto netconf = sess.getContext().getModuleLatest("ietf-netconf");
-                            deletedNode->newMeta(*netconf, "operation", "delete");
-                        }
-
-                        sess.editBatch(*edit, sysrepo::DefaultOperation::Merge);
-                        sess.applyChanges(timeout);
-                    } catch (const sysrepo::ErrorWithCode& e) {
-                        if (e.code() == sysrepo::ErrorCode::Unauthorized) {
-                            throw ErrorResponse(403, "application", "access-denied", "Access denied.", restconfRequest.path);
-                        } else if (e.code() == sysrepo::ErrorCode::NotFound) {
-                            /* The RFC is not clear at all on the error-tag.
-                             * See https://mailarchive.ietf.org/arch/msg/netconf/XcF9r3ek3LvZ4DjF-7_B8kxuiwA/
-                             * Also, if we replace 403 with 404 in order not to reveal if the node does not exist or
-                             * if the user is not authorized then we should return the error tag invalid-value.
-                             * This clashes with the data-missing tag below and we reveal it anyway :(
-                             */
-                            throw ErrorResponse(404, "application", "data-missing", "Data is missing.", restconfRequest.path);
-                        }
-
-                        throw;
-                    }
-
-                    res.write_head(204, {CORS});
-                    res.end();
+                    const auto datastore = restconfRequest.datastore.value_or(sysrepo::Datastore::Running);
+                    auto ticket = admit();
+                    auto sess = m_sessions.checkout(datastore, nacmUser);
+                    auto requestCtx = std::make_shared<RequestContext>(requestInfo, deferredRes, dataFormat, std::move(sess), restconfRequest, std::move(ticket), timeout, deadline);
+                    requestCtx->compact = compact;
+                    requestCtx->moduleChanges = m_moduleChanges.get();
+                    requestCtx->entityTags = m_entityTags;
+                    offload(m_workers, requestCtx, [requestCtx]() {
+                        WITH_RESTCONF_EXCEPTIONS(processDelete, rejectWithError)(requestCtx);
+                    });
                     break;
+                }
 
                 case RestconfRequest::Type::Execute:
                 case RestconfRequest::Type::ExecuteInternal: {
-                    auto requestCtx = std::make_shared<RequestContext>(req, res, dataFormat, sess, restconfRequest);
+                    auto payload = std::make_shared<std::string>();
 
-                    req.on_data([this, requestCtx, timeout, peer=http::peer_from_request(req)](const uint8_t* data, std::size_t length) {
+                    req.on_data([this, payload, admit, requestInfo, deferredRes, dataFormat, nacmUser, restconfRequest, timeout, deadline, compact](const uint8_t* data, std::size_t length) {
                         if (length > 0) {
-                            requestCtx->payload.append(reinterpret_cast<const char*>(data), length);
-                        } else {
-                            spdlog::trace("{}: HTTP payload: {}", peer, requestCtx->payload);
-                            WITH_RESTCONF_EXCEPTIONS(processActionOrRPC, rejectWithError)(requestCtx, timeout, m_dynamicSubscriptions);
+                            payload->append(reinterpret_cast<const char*>(data), length);
+                            return;
                         }
+
+                        spdlog::trace("{}: HTTP payload: {}", requestInfo.peer, *payload);
+
+                        startWithPayload(m_sessions.context(), requestInfo, deferredRes, dataFormat, [&]() {
+                            auto ticket = admit();
+                            // establish-subscription ties the subscription to the session, so these get a session of their own
+                            auto sess = restconfRequest.type == RestconfRequest::Type::Execute
+                                ? m_sessions.checkout(sysrepo::Datastore::Operational, nacmUser)
+                                : SessionPool::Lease{m_sessions.start(sysrepo::Datastore::Operational, nacmUser)};
+                            auto requestCtx = std::make_shared<RequestContext>(requestInfo, deferredRes, dataFormat, std::move(sess), restconfRequest, std::move(ticket), timeout, deadline);
+                            requestCtx->compact = compact;
+                            requestCtx->payload = std::move(*payload);
+
+                            offload(m_workers, requestCtx, [this, requestCtx]() {
+                                WITH_RESTCONF_EXCEPTIONS(processActionOrRPC, rejectWithError)(requestCtx, m_dynamicSubscriptions, m_changeJournal.get());
+                            });
+                        });
                     });
                     break;
                 }
@@ -1279,25 +2484,25 @@ Server::Server(
                     nghttp2::asio_http2::header_map headers{CORS};
 
                     /* Just try to call this function with all possible HTTP methods and return those which do not fail */
-                    if (auto optionsHeaders = allowedHttpMethodsForUri(sess.getContext(), req.uri().path); !optionsHeaders.empty()) {
+                    if (auto optionsHeaders = allowedHttpMethodsForUri(m_sessions.context(), req.uri().path); !optionsHeaders.empty()) {
                         headers.merge(httpOptionsHeaders(optionsHeaders));
-                        res.write_head(200, headers);
+                        deferredRes.write_head(200, headers);
                     } else {
-                        res.write_head(404, headers);
+                        deferredRes.write_head(404, headers);
                     }
-                    res.end();
+                    deferredRes.end();
                     break;
                 }
                 }
             } catch (const auth::Error& e) {
-                processAuthError(req, res, e, [sess, dataFormat, &req, &res]() {
-                    rejectWithError(sess.getContext(), dataFormat.response, req, res, 401, "protocol", "access-denied", "Access denied.", std::nullopt);
+                processAuthError(req, res, e, [this, dataFormat, requestInfo, deferredRes]() {
+                    rejectWithError(m_sessions.context(), dataFormat.response, requestInfo, deferredRes, 401, "protocol", "access-denied", "Access denied.", std::nullopt);
                 });
             } catch (const ErrorResponse& e) {
-                rejectWithError(sess.getContext(), dataFormat.response, req, res, e.code, e.errorType, e.errorTag, e.errorMessage, e.errorPath, e.errorInfo);
+                rejectWithError(m_sessions.context(), dataFormat.response, requestInfo, deferredRes, e.code, e.errorType, e.errorTag, e.errorMessage, e.errorPath, e.errorInfo);
             } catch (const sysrepo::ErrorWithCode& e) {
                 spdlog::error("Sysrepo exception: {}", e.what());
-                rejectWithError(sess.getContext(), dataFormat.response, req, res, 500, "application", "operation-failed", "Internal server error due to sysrepo exception.", std::nullopt);
+                rejectWithError(m_sessions.context(), dataFormat.response, requestInfo, deferredRes, 500, "application", "operation-failed", "Internal server error due to sysrepo exception.", std::nullopt);
             }
         });
 
@@ -1305,6 +2510,21 @@ Server::Server(
     if (server->listen_and_serve(ec, address, port, true)) {
         throw std::runtime_error{"Server error: " + ec.message()};
     }
-    spdlog::debug("Listening at {} {}", address, port);
+
+    if (!options.extraSockets.empty()) {
+        // connecting to a wildcard address ends up on the loopback
+        const boost::asio::ip::tcp::endpoint tcpEndpoint{boost::asio::ip::make_address(address), static_cast<unsigned short>(server->ports().front())};
+        for (const auto& extraSocket : options.extraSockets) {
+            auto& io = *server->io_services().front();
+            if (auto path = std::get_if<std::string>(&extraSocket.socket)) {
+                m_extraSockets.emplace_back(std::make_unique<http::SocketRelay>(io, *path, extraSocket.mode, tcpEndpoint), extraSocket.peerCredentialsAsNacmUser);
+                spdlog::debug("Listening at {}{}", *path, extraSocket.peerCredentialsAsNacmUser ? " (peer credentials are trusted)" : "");
+            } else {
+                m_extraSockets.emplace_back(std::make_unique<http::SocketRelay>(io, std::get<int>(extraSocket.socket), tcpEndpoint), extraSocket.peerCredentialsAsNacmUser);
+                spdlog::debug("Listening at inherited fd {}", std::get<int>(extraSocket.socket));
+            }
+        }
+    }
+    spdlog::debug("Listening at {} {} ({} threads, {} worker threads, {} sysrepo connections)", address, port, options.threads, options.workerThreads, options.connections);
 }
 }
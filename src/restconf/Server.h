@@ -6,17 +6,32 @@
 */
 
 #pragma once
+#include <sys/types.h>
+#include <variant>
 #include <sysrepo-cpp/Connection.hpp>
 #include <sysrepo-cpp/Subscription.hpp>
 #include "auth/Nacm.h"
 #include "http/EventStream.h"
+#include "restconf/AdmissionControl.h"
+#include "restconf/ChangeJournal.h"
+#include "restconf/DatastoreMirror.h"
 #include "restconf/DynamicSubscriptions.h"
+#include "restconf/ModuleChanges.h"
+#include "restconf/RequestCoalescer.h"
+#include "restconf/ResponseCache.h"
+#include "restconf/SessionPool.h"
+#include "restconf/WorkerPool.h"
 
 namespace nghttp2::asio_http2::server {
 class http2;
+class request;
+class response;
 }
 
 namespace rousette {
+namespace http {
+class SocketRelay;
+}
 namespace sr {
 class OpticalEvents;
 }
@@ -24,17 +39,61 @@ class OpticalEvents;
 /** @short RESTCONF protocol */
 namespace restconf {
 
+struct RestconfRequest;
+
 std::optional<std::string> as_subtree_path(const std::string& path);
 
+/** @short An additional listening socket */
+struct ListeningSocket {
+    std::variant<std::string, int> socket; ///< Either a path where a new UNIX socket is created, or a file descriptor of an already listening socket
+    mode_t mode = 0660; ///< Permissions of a newly created socket file, i.e., who can connect
+    bool peerCredentialsAsNacmUser = false; ///< For UNIX sockets, use the connecting process' user name as the NACM user and skip any further authentication
+};
+
+/** @short Upper bounds of how long can requests of a given kind take; zero means no bound */
+struct MaxTimeouts {
+    std::chrono::milliseconds read{0};
+    std::chrono::milliseconds edit{0};
+    std::chrono::milliseconds rpc{0};
+};
+
+/** @short Data which rousette may keep around instead of asking sysrepo each time */
+struct CacheOptions {
+    bool datastoreMirror = false; ///< Serve reads of the running and startup datastores from an in-memory copy
+    std::size_t mirrorMaxEntries = 1024; ///< How many (datastore, module, NACM user) copies can the mirror hold
+    std::size_t responseCacheSize = 0; ///< Total size of cached responses to reads of the configuration datastores in bytes, zero disables the cache
+    bool coalesceReads = false; ///< Identical reads which arrive while one is being processed share its response
+    bool entityTags = false; ///< Responses with configuration data carry ETag and Last-Modified, and conditional requests are supported
+    std::size_t changeJournalSize = 0; ///< How many recent edits of the configuration datastores are kept for rousette:changes-since, zero disables the journal
+};
+
+/** @short How are the response bodies encoded */
+struct OutputOptions {
+    bool compact = false; ///< Print data without any indentation, unless the client asks for `pretty=true`
+    bool compression = true; ///< Compress responses and event streams with a content coding which the client accepts
+    std::size_t compressionThreshold = 1024; ///< Responses smaller than this many bytes are not compressed
+};
+
+/** @short Everything about the server which can be tuned */
+struct ServerOptions {
+    std::chrono::milliseconds timeout{0}; ///< Default timeout of sysrepo operations, zero means sysrepo's own default
+    std::chrono::seconds keepAlivePingInterval{55}; ///< How often are the keep-alive pings sent to the event streams
+    std::chrono::seconds subNotifInactivityTimeout{60}; ///< Dynamic subscriptions without any receiver are terminated after this long
+    std::size_t threads = 1; ///< HTTP event loops, each in a thread of its own
+    std::size_t workerThreads = 4; ///< Threads which perform the blocking sysrepo operations
+    std::size_t connections = 1; ///< The sysrepo connections which the sessions are spread across
+    std::optional<uint8_t> instanceId; ///< Number of this server process when several of them share the listening port
+    std::vector<ListeningSocket> extraSockets;
+    MaxTimeouts maxTimeouts;
+    std::size_t serializerThreads = 4; ///< Threads which print big responses in parallel, zero prints them in the worker threads
+    CacheOptions cache;
+    OutputOptions output;
+};
+
 /** @short A RESTCONF-ish server */
 class Server {
 public:
-    explicit Server(sysrepo::Connection conn,
-                    const std::string& address,
-                    const std::string& port,
-                    const std::chrono::milliseconds timeout = std::chrono::milliseconds{0},
-                    const std::chrono::seconds keepAlivePingInterval = std::chrono::seconds{55},
-                    const std::chrono::seconds subNotifInactivityTimeout = std::chrono::seconds{60});
+    explicit Server(sysrepo::Connection conn, const std::string& address, const std::string& port, const ServerOptions& options = {});
     ~Server();
     void join();
     void stop();
@@ -44,13 +103,35 @@ private:
     sysrepo::Session m_monitoringSession;
     std::optional<sysrepo::Subscription> m_monitoringOperSub;
     auth::Nacm nacm;
+    SessionPool m_sessions;
+    std::unique_ptr<ModuleChanges> m_moduleChanges; ///< Only set when something needs to know about changes of the configuration
+    std::unique_ptr<DatastoreMirror> m_mirror; ///< Only set when the configuration datastores are mirrored
+    std::unique_ptr<ResponseCache> m_responseCache;
+    std::optional<sysrepo::Subscription> m_responseCacheStatsSub;
+    std::optional<sysrepo::Subscription> m_responseCachePolicySub;
+    std::unique_ptr<RequestCoalescer> m_coalescer;
+    std::unique_ptr<ChangeJournal> m_changeJournal; ///< Only set when clients can ask for recent changes of the configuration
+    bool m_entityTags;
+    OutputOptions m_outputOptions;
+    AdmissionControl m_admission;
     std::unique_ptr<nghttp2::asio_http2::server::http2> server;
+    std::vector<std::pair<std::unique_ptr<http::SocketRelay>, bool /* peerCredentialsAsNacmUser */>> m_extraSockets;
     DynamicSubscriptions m_dynamicSubscriptions;
     std::unique_ptr<sr::OpticalEvents> dwdmEvents;
     using JsonDiffSignal = boost::signals2::signal<void(const std::string& json)>;
     JsonDiffSignal opticsChange;
     bool joined = false; // true if the server has been joined, join twice is an error
     boost::signals2::signal<void()> shutdownRequested;
+    std::mutex m_errorMutex;
+    std::exception_ptr m_error; ///< The first exception which escaped from a request handler
+    std::unique_ptr<WorkerPool> m_serializers; ///< Big responses are serialized in parallel here, if set
+    WorkerPool m_workers; ///< Blocking sysrepo operations run here, outside of the HTTP event loop
+
+    using Handler = std::function<void(const nghttp2::asio_http2::server::request&, const nghttp2::asio_http2::server::response&)>;
+    void handle(const std::string& pattern, Handler handler);
+    void failed(std::exception_ptr error);
+    std::string authorize(const nghttp2::asio_http2::server::request& req) const;
+    void refreshCachedResponse(const ResponseCache::Key& key, const RestconfRequest& restconfRequest, const std::string& nacmUser, const std::chrono::milliseconds timeout, std::function<void(std::string&&)> store);
 };
 }
 }
@@ -0,0 +1,118 @@
+/*
+ * Copyright (C) 2026 CESNET, https://photonics.cesnet.cz/
+ *
+ * Written by Jan Kundrát <jan.kundrat@cesnet.cz>
+ *
+*/
+
+#include <spdlog/spdlog.h>
+#include <sysrepo-cpp/utils/exception.hpp>
+#include "restconf/SessionPool.h"
+
+namespace rousette::restconf {
+
+SessionPool::SessionPool(std::vector<sysrepo::Connection> connections, const std::size_t maxIdle)
+    : m_state(std::make_shared<State>(std::move(connections), maxIdle, 0))
+    , m_contextSession(m_state->connections.at(0).sessionStart())
+{
+}
+
+/** @short Get a session from the pool, or start a new one if there's no idle session for this datastore and user */
+SessionPool::Lease SessionPool::checkout(const sysrepo::Datastore datastore, const std::string& user)
+{
+    Key key{datastore, user};
+
+    {
+        std::lock_guard lock{m_state->mutex};
+        if (auto it = m_state->idle.find(key); it != m_state->idle.end() && !it->second.empty()) {
+            auto session = std::move(it->second.back());
+            it->second.pop_back();
+            return Lease{std::move(session), m_state, std::move(key)};
+        }
+    }
+
+    return Lease{start(datastore, user), m_state, std::move(key)};
+}
+
+/** @short Start a new session which does not belong to the pool
+ *
+ * This is useful for long-lived sessions, e.g., those which own a subscription.
+ */
+sysrepo::Session SessionPool::start(const sysrepo::Datastore datastore, const std::string& user)
+{
+    auto& conn = m_state->connections[m_state->nextConnection++ % m_state->connections.size()];
+    auto session = conn.sessionStart(datastore);
+    session.setNacmUser(user);
+    return session;
+}
+
+/** @short The libyang context, for requests which do not need a session at all */
+libyang::Context SessionPool::context() const
+{
+    return m_contextSession.getContext();
+}
+
+SessionPool::Lease::Lease(sysrepo::Session session)
+    : m_session(std::move(session))
+    , m_key{m_session->activeDatastore(), {}}
+{
+}
+
+SessionPool::Lease::Lease(sysrepo::Session session, std::weak_ptr<State> pool, Key key)
+    : m_session(std::move(session))
+    , m_pool(std::move(pool))
+    , m_key(std::move(key))
+{
+}
+
+SessionPool::Lease::Lease(Lease&& other) noexcept
+    : m_session(std::move(other.m_session))
+    , m_pool(std::move(other.m_pool))
+    , m_key(std::move(other.m_key))
+{
+    other.m_session.reset();
+    other.m_pool.reset();
+}
+
+SessionPool::Lease::~Lease()
+{
+    auto pool = m_pool.lock();
+    if (!m_session || !pool) {
+        return;
+    }
+
+    try {
+        // make sure that nothing leaks into the next request
+        m_session->discardChanges();
+        m_session->switchDatastore(m_key.datastore);
+    } catch (const sysrepo::Error& e) {
+        spdlog::warn("Dropping a pooled session: {}", e.what());
+        return;
+    }
+
+    std::lock_guard lock{pool->mutex};
+    if (auto& sessions = pool->idle[m_key]; sessions.size() < pool->maxIdle) {
+        sessions.emplace_back(std::move(*m_session));
+    }
+}
+
+sysrepo::Session& SessionPool::Lease::operator*()
+{
+    return *m_session;
+}
+
+const sysrepo::Session& SessionPool::Lease::operator*() const
+{
+    return *m_session;
+}
+
+sysrepo::Session* SessionPool::Lease::operator->()
+{
+    return &*m_session;
+}
+
+const sysrepo::Session* SessionPool::Lease::operator->() const
+{
+    return &*m_session;
+}
+}
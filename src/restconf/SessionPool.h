@@ -0,0 +1,81 @@
+/*
+ * Copyright (C) 2026 CESNET, https://photonics.cesnet.cz/
+ *
+ * Written by Jan Kundrát <jan.kundrat@cesnet.cz>
+ *
+*/
+
+#pragma once
+
+#include <atomic>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <sysrepo-cpp/Connection.hpp>
+#include <sysrepo-cpp/Session.hpp>
+#include <vector>
+
+namespace rousette::restconf {
+
+/** @short A pool of sysrepo sessions, keyed by the datastore and the NACM user
+ *
+ * Starting a session and setting its NACM user on each and every request is not free. Sessions are therefore created
+ * lazily when a request actually needs one, and returned to the pool when the request is done with them. At most
+ * `maxIdle` idle sessions are kept for each (datastore, user) pair.
+ *
+ * New sessions are spread among all connections in a round-robin manner, so that requests which run in parallel do
+ * not contend for the locks of a single sysrepo connection.
+ */
+class SessionPool {
+    struct Key {
+        sysrepo::Datastore datastore;
+        std::string user;
+
+        auto operator<=>(const Key&) const = default;
+    };
+
+    struct State {
+        std::vector<sysrepo::Connection> connections;
+        std::size_t maxIdle;
+        std::atomic<std::size_t> nextConnection;
+        std::mutex mutex;
+        std::map<Key, std::vector<sysrepo::Session>> idle;
+    };
+
+public:
+    /** @short A session which is returned to the pool once this object goes away */
+    class Lease {
+    public:
+        explicit Lease(sysrepo::Session session);
+        ~Lease();
+        Lease(Lease&& other) noexcept;
+        Lease(const Lease&) = delete;
+        Lease& operator=(const Lease&) = delete;
+        Lease& operator=(Lease&&) = delete;
+
+        sysrepo::Session& operator*();
+        const sysrepo::Session& operator*() const;
+        sysrepo::Session* operator->();
+        const sysrepo::Session* operator->() const;
+
+    private:
+        friend class SessionPool;
+        Lease(sysrepo::Session session, std::weak_ptr<State> pool, Key key);
+
+        std::optional<sysrepo::Session> m_session;
+        std::weak_ptr<State> m_pool; ///< Empty if this session does not belong to the pool
+        Key m_key;
+    };
+
+    SessionPool(std::vector<sysrepo::Connection> connections, const std::size_t maxIdle);
+
+    Lease checkout(const sysrepo::Datastore datastore, const std::string& user);
+    sysrepo::Session start(const sysrepo::Datastore datastore, const std::string& user);
+    libyang::Context context() const;
+
+private:
+    std::shared_ptr<State> m_state;
+    sysrepo::Session m_contextSession; ///< Only used for accessing the libyang context
+};
+}
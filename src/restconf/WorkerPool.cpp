@@ -0,0 +1,61 @@
+/*
+ * Copyright (C) 2026 CESNET, https://photonics.cesnet.cz/
+ *
+ * Written by Jan Kundrát <jan.kundrat@cesnet.cz>
+ *
+*/
+
+#include <boost/asio/post.hpp>
+#include <spdlog/spdlog.h>
+#include "restconf/WorkerPool.h"
+
+namespace rousette::restconf {
+
+WorkerPool::WorkerPool(const std::size_t threads, const std::size_t maxPending, const ErrorHandler& onError)
+    : m_pool(threads)
+    , m_threads(threads)
+    , m_maxPending(maxPending)
+    , m_pending(0)
+    , m_onError(onError)
+{
+}
+
+WorkerPool::~WorkerPool()
+{
+    join();
+}
+
+/** @short Wait until all queued tasks are finished */
+void WorkerPool::join()
+{
+    m_pool.join();
+}
+
+/** @short Enqueue a task for execution
+ *
+ * @return false if the pool is saturated and the task was not accepted
+ */
+bool WorkerPool::post(std::function<void()> task)
+{
+    if (++m_pending > m_maxPending) {
+        --m_pending;
+        spdlog::warn("Worker pool is saturated ({} pending tasks)", m_maxPending);
+        return false;
+    }
+
+    boost::asio::post(m_pool, [this, task = std::move(task)]() {
+        try {
+            task();
+        } catch (...) {
+            m_onError(std::current_exception());
+        }
+        --m_pending;
+    });
+    return true;
+}
+
+std::size_t WorkerPool::threads() const
+{
+    return m_threads;
+}
+}
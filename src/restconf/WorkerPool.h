@@ -0,0 +1,41 @@
+/*
+ * Copyright (C) 2026 CESNET, https://photonics.cesnet.cz/
+ *
+ * Written by Jan Kundrát <jan.kundrat@cesnet.cz>
+ *
+*/
+
+#pragma once
+
+#include <atomic>
+#include <boost/asio/thread_pool.hpp>
+#include <functional>
+
+namespace rousette::restconf {
+
+/** @short A bounded pool of threads for running the blocking parts of request processing
+ *
+ * Sysrepo calls might block for a long time (operational data callbacks, commits waiting for locks, RPCs), so they
+ * are executed here instead of in the HTTP event loop. The number of tasks which are either running or waiting in
+ * the queue is limited; once the limit is reached, new tasks are rejected so that the caller can tell the client to
+ * come back later.
+ * */
+class WorkerPool {
+public:
+    using ErrorHandler = std::function<void(std::exception_ptr)>;
+
+    WorkerPool(const std::size_t threads, const std::size_t maxPending, const ErrorHandler& onError);
+    ~WorkerPool();
+
+    [[nodiscard]] bool post(std::function<void()> task);
+    void join();
+    std::size_t threads() const;
+
+private:
+    boost::asio::thread_pool m_pool;
+    const std::size_t m_threads;
+    const std::size_t m_maxPending;
+    std::atomic<std::size_t> m_pending; ///< Number of tasks which are running or waiting in the queue
+    ErrorHandler m_onError; ///< Invoked with any exception that escapes from a task
+};
+}
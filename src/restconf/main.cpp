@@ -14,11 +14,18 @@
 #include <boost/asio.hpp>
 #ifdef HAVE_SYSTEMD
    #include <spdlog/sinks/systemd_sink.h>
+   #include <systemd/sd-daemon.h>
 #endif
 #include <spdlog/sinks/syslog_sink.h>
 #include <spdlog/sinks/ansicolor_sink.h>
+#include <sys/prctl.h>
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <sys/wait.h>
+#include <csignal>
+#include <map>
+#include <system_error>
+#include <unistd.h>
 #include <docopt.h>
 #include <spdlog/spdlog.h>
 #include <sysrepo-cpp/Session.hpp>
@@ -27,11 +34,32 @@
 static const char usage[] =
   R"(Rousette - RESTCONF server
 Usage:
-  rousette [--syslog] [--timeout <SECONDS>] [--help]
+  rousette [--syslog] [--timeout <SECONDS>] [--max-read-timeout <SECONDS>] [--max-edit-timeout <SECONDS>] [--max-rpc-timeout <SECONDS>] [--threads <N>] [--workers <N>] [--serializers <N>] [--connections <N>] [--processes <N>] [--unix-socket <PATH>]... [--unix-socket-mode <MODE>] [--trust-peer-credentials] [--mirror-config] [--response-cache <MB>] [--coalesce-reads] [--entity-tags] [--change-journal <EDITS>] [--pretty] [--no-compression] [--compress-min <BYTES>] [--help]
 Options:
   -h --help                         Show this screen.
   -t --timeout <SECONDS>            Change default timeout in sysrepo (if not set, use sysrepo internal).
+  --max-read-timeout <SECONDS>      Upper bound of the deadline of GET requests, including those set by the client.
+  --max-edit-timeout <SECONDS>      Upper bound of the deadline of requests which change data.
+  --max-rpc-timeout <SECONDS>       Upper bound of the deadline of RPCs and actions.
+  -j --threads <N>                  Number of threads serving HTTP connections [default: 1].
+  -w --workers <N>                  Number of threads for blocking sysrepo operations [default: 4].
+  -s --serializers <N>              Number of threads for serializing big responses in parallel, 0 to serialize in the workers [default: 4].
+  -c --connections <N>              Number of sysrepo connections to spread the sessions over [default: 1].
+  -p --processes <N>                Number of server processes; process K listens on port 10080+K [default: 1].
+  -u --unix-socket <PATH>           Also accept connections at a UNIX socket; process K uses PATH.K with --processes.
+  --unix-socket-mode <MODE>         Permissions (octal) of the UNIX sockets [default: 0660].
+  --trust-peer-credentials          Clients connecting via UNIX sockets act as their local user without any authentication.
+  --mirror-config                   Serve reads of the running and startup datastores from memory.
+  --response-cache <MB>             Cache responses to reads of the running and startup datastores, 0 to disable [default: 0].
+  --coalesce-reads                  Identical concurrent reads share a single response.
+  --entity-tags                     Send ETag and Last-Modified with configuration data, and support conditional requests.
+  --change-journal <EDITS>          Remember this many recent edits of the configuration for rousette:changes-since [default: 0].
+  --pretty                          Indent the data in responses unless the client asks for "pretty=false".
+  --no-compression                  Never compress responses and event streams, even when the client supports that.
+  --compress-min <BYTES>            Responses smaller than this are sent uncompressed [default: 1024].
   --syslog                          Log to syslog.
+
+When started via systemd's socket activation, the inherited sockets are used instead of port 10080.
 )";
 #ifdef HAVE_SYSTEMD
 
@@ -70,8 +98,130 @@ public:
               /* spdlog::level::off        */ LOG_ALERT};
     }
 };
+
+/** @short Keep pinging systemd's watchdog from within the event loop, so that a stuck loop gets noticed */
+void startWatchdog(boost::asio::steady_timer& timer, const std::chrono::microseconds interval)
+{
+    sd_notify(0, "WATCHDOG=1");
+    timer.expires_after(interval);
+    timer.async_wait([&timer, interval](const boost::system::error_code& ec) {
+        if (!ec) {
+            startWatchdog(timer, interval);
+        }
+    });
+}
 }
 #endif
+
+namespace {
+volatile std::sig_atomic_t supervisorTerminating = 0;
+
+/** @short Fork the worker processes, and keep restarting those which crash
+ *
+ * This function only returns in the worker processes, and the return value is the worker's index. The supervisor
+ * process exits once it is asked to terminate and all the workers are gone.
+ *
+ * This must be called before any threads are started.
+ */
+uint8_t superviseWorkers(const unsigned count)
+{
+    std::map<pid_t, uint8_t> workers;
+    const auto supervisorPid = ::getpid();
+
+    // The signals are only delivered while sigsuspend() waits for them, so none of them can slip in between a check
+    // of the supervisorTerminating flag (or of the workers' state) and the wait.
+    sigset_t supervisorSignals, originalMask;
+    ::sigemptyset(&supervisorSignals);
+    ::sigaddset(&supervisorSignals, SIGTERM);
+    ::sigaddset(&supervisorSignals, SIGINT);
+    ::sigaddset(&supervisorSignals, SIGCHLD);
+    ::sigprocmask(SIG_BLOCK, &supervisorSignals, &originalMask);
+
+    auto spawn = [&](uint8_t index) {
+        auto pid = ::fork();
+        if (pid < 0) {
+            throw std::system_error{errno, std::system_category(), "fork"};
+        } else if (pid == 0) {
+            // the worker shouldn't outlive its supervisor
+            ::prctl(PR_SET_PDEATHSIG, SIGTERM);
+            if (::getppid() != supervisorPid) {
+                std::exit(1);
+            }
+            std::signal(SIGTERM, SIG_DFL);
+            std::signal(SIGINT, SIG_DFL);
+            std::signal(SIGCHLD, SIG_DFL);
+            ::sigprocmask(SIG_SETMASK, &originalMask, nullptr);
+            return true;
+        }
+        spdlog::info("Started worker process #{} (PID {})", index, pid);
+        workers[pid] = index;
+        return false;
+    };
+
+    struct sigaction sa{};
+    sa.sa_handler = [](int) { supervisorTerminating = 1; };
+    ::sigaction(SIGTERM, &sa, nullptr);
+    ::sigaction(SIGINT, &sa, nullptr);
+    // an ignored SIGCHLD would not wake up sigsuspend()
+    sa.sa_handler = [](int) {};
+    ::sigaction(SIGCHLD, &sa, nullptr);
+
+    for (unsigned i = 0; i < count; ++i) {
+        if (spawn(i)) {
+            return i;
+        }
+    }
+
+    bool killed = false;
+    while (!workers.empty()) {
+        if (supervisorTerminating && !killed) {
+            for (const auto& worker : workers) {
+                ::kill(worker.first, SIGTERM);
+            }
+            killed = true;
+        }
+
+        int status;
+        auto pid = ::waitpid(-1, &status, WNOHANG);
+        if (pid < 0) {
+            throw std::system_error{errno, std::system_category(), "waitpid"};
+        }
+        if (pid == 0) {
+            ::sigsuspend(&originalMask);
+            continue;
+        }
+
+        auto index = workers.at(pid);
+        workers.erase(pid);
+        if (supervisorTerminating) {
+            continue;
+        }
+
+        if (WIFSIGNALED(status)) {
+            spdlog::error("Worker process #{} (PID {}) killed by signal {}", index, pid, WTERMSIG(status));
+        } else {
+            spdlog::error("Worker process #{} (PID {}) exited with status {}", index, pid, WEXITSTATUS(status));
+        }
+
+        // don't spin if the worker cannot start at all, but do not restart it when asked to terminate in the meantime
+        sigset_t terminationSignals;
+        ::sigemptyset(&terminationSignals);
+        ::sigaddset(&terminationSignals, SIGTERM);
+        ::sigaddset(&terminationSignals, SIGINT);
+        const timespec restartDelay{.tv_sec = 1, .tv_nsec = 0};
+        if (::sigtimedwait(&terminationSignals, nullptr, &restartDelay) > 0) {
+            supervisorTerminating = 1;
+            continue;
+        }
+        if (spawn(index)) {
+            return index;
+        }
+    }
+
+    std::exit(0);
+}
+}
+
 int main(int argc, char* argv [])
 {
     auto args = docopt::docopt(usage, {argv + 1, argv + argc}, true,""/* version */, true);
@@ -80,6 +230,36 @@ int main(int argc, char* argv [])
     if (args["--timeout"]) {
         timeout = std::chrono::milliseconds{args["--timeout"].asLong() * 1000};
     }
+    rousette::restconf::MaxTimeouts maxTimeouts;
+    for (const auto& [option, maxTimeout] : {
+             std::pair{"--max-read-timeout", &maxTimeouts.read},
+             {"--max-edit-timeout", &maxTimeouts.edit},
+             {"--max-rpc-timeout", &maxTimeouts.rpc},
+         }) {
+        if (args[option]) {
+            *maxTimeout = std::chrono::milliseconds{args[option].asLong() * 1000};
+        }
+    }
+    const auto threads = args["--threads"].asLong();
+    if (threads < 1) {
+        throw std::invalid_argument("The number of threads must be positive");
+    }
+    const auto workers = args["--workers"].asLong();
+    if (workers < 1) {
+        throw std::invalid_argument("The number of worker threads must be positive");
+    }
+    const auto serializers = args["--serializers"].asLong();
+    if (serializers < 0) {
+        throw std::invalid_argument("The number of serializer threads must not be negative");
+    }
+    const auto connections = args["--connections"].asLong();
+    if (connections < 1) {
+        throw std::invalid_argument("The number of sysrepo connections must be positive");
+    }
+    const auto processes = args["--processes"].asLong();
+    if (processes < 1 || processes > 256) {
+        throw std::invalid_argument("The number of server processes must be between 1 and 256");
+    }
     if (args["--syslog"].asBool()) {
         auto syslog_sink = std::make_shared<spdlog::sinks::syslog_sink_mt>("rousette", LOG_PID, LOG_USER, true);
         auto logger = std::make_shared<spdlog::logger>("rousette", syslog_sink);
@@ -107,13 +287,95 @@ int main(int argc, char* argv [])
     // schema access is required
     sysrepo::setGlobalContextOptions(sysrepo::ContextFlags::LibYangPrivParsed | sysrepo::ContextFlags::NoPrinted, sysrepo::GlobalContextEffect::Immediate);
 
+    std::vector<rousette::restconf::ListeningSocket> extraSockets;
+    auto port = 10080;
+#ifdef HAVE_SYSTEMD
+    // The inherited sockets are shared by all server processes. The environment has to be cleared so that
+    // the worker processes do not try to take them over once again.
+    if (auto fds = sd_listen_fds(true); fds < 0) {
+        throw std::system_error{-fds, std::system_category(), "sd_listen_fds"};
+    } else if (fds > 0) {
+        for (int fd = SD_LISTEN_FDS_START; fd < SD_LISTEN_FDS_START + fds; ++fd) {
+            extraSockets.push_back({.socket = fd, .peerCredentialsAsNacmUser = args["--trust-peer-credentials"].asBool()});
+        }
+        // only the relays connect to the server's own listener, see http::SocketRelay
+        port = 0;
+    }
+#endif
+
+    std::optional<uint8_t> instanceId;
+    if (processes > 1) {
+        // each process has its own state (e.g., the dynamic subscriptions), so a reverse proxy has to route
+        // the requests, see README.md
+        instanceId = superviseWorkers(processes);
+        if (port) {
+            port += *instanceId;
+        }
+    }
+
+    for (const auto& path : args["--unix-socket"].asStringList()) {
+        extraSockets.push_back({
+            .socket = instanceId ? path + "." + std::to_string(*instanceId) : path,
+            .mode = static_cast<mode_t>(std::stoul(args["--unix-socket-mode"].asString(), nullptr, 8)),
+            .peerCredentialsAsNacmUser = args["--trust-peer-credentials"].asBool(),
+        });
+    }
+
+    rousette::restconf::CacheOptions cacheOptions;
+    cacheOptions.datastoreMirror = args["--mirror-config"].asBool();
+    cacheOptions.coalesceReads = args["--coalesce-reads"].asBool();
+    cacheOptions.entityTags = args["--entity-tags"].asBool();
+    if (const auto size = args["--response-cache"].asLong(); size < 0) {
+        throw std::invalid_argument("The size of the response cache must not be negative");
+    } else {
+        cacheOptions.responseCacheSize = static_cast<std::size_t>(size) * 1024 * 1024;
+    }
+    if (const auto edits = args["--change-journal"].asLong(); edits < 0) {
+        throw std::invalid_argument("The size of the change journal must not be negative");
+    } else {
+        cacheOptions.changeJournalSize = static_cast<std::size_t>(edits);
+    }
+
+    rousette::restconf::OutputOptions outputOptions;
+    outputOptions.compact = !args["--pretty"].asBool();
+    outputOptions.compression = !args["--no-compression"].asBool();
+    if (const auto size = args["--compress-min"].asLong(); size < 0) {
+        throw std::invalid_argument("The compression threshold must not be negative");
+    } else {
+        outputOptions.compressionThreshold = static_cast<std::size_t>(size);
+    }
+
     auto conn = sysrepo::Connection{};
-    auto server = rousette::restconf::Server{conn, "::1", "10080", timeout};
+    auto server = rousette::restconf::Server{conn, "::1", std::to_string(port), {
+        .timeout = timeout,
+        .threads = static_cast<std::size_t>(threads),
+        .workerThreads = static_cast<std::size_t>(workers),
+        .connections = static_cast<std::size_t>(connections),
+        .instanceId = instanceId,
+        .extraSockets = extraSockets,
+        .maxTimeouts = maxTimeouts,
+        .serializerThreads = static_cast<std::size_t>(serializers),
+        .cache = cacheOptions,
+        .output = outputOptions,
+    }};
+
+    // the constructor has checked the YANG modules, published the capabilities and it is listening already
+    boost::asio::steady_timer watchdog(*server.io_services()[0]);
+#ifdef HAVE_SYSTEMD
+    sd_notify(0, "READY=1");
+    if (uint64_t usec; sd_watchdog_enabled(false, &usec) > 0) {
+        startWatchdog(watchdog, std::chrono::microseconds{usec / 2});
+    }
+#endif
 
     // allow graceful shutdown
     boost::asio::signal_set signals(*server.io_services()[0], SIGTERM, SIGINT);
     signals.async_wait([&](const boost::system::error_code& ec, int) {
         if (!ec) {
+#ifdef HAVE_SYSTEMD
+            sd_notify(0, "STOPPING=1");
+#endif
+            watchdog.cancel();
             server.stop();
         }
     });
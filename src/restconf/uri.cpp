@@ -4,13 +4,18 @@
  * Written by Tomáš Pecka <tomas.pecka@cesnet.cz>
  */
 
+#include <algorithm>
+#include <boost/algorithm/string/classification.hpp>
 #include <boost/algorithm/string/join.hpp>
+#include <boost/algorithm/string/split.hpp>
+#include <boost/algorithm/string/trim.hpp>
 #include <boost/fusion/adapted/struct/adapt_struct.hpp>
 #include <boost/fusion/include/std_pair.hpp>
 #include <boost/spirit/home/x3/support/ast/variant.hpp>
 #include <boost/spirit/home/x3/support/utility/error_reporting.hpp>
 #include <boost/uuid/nil_generator.hpp>
 #include <boost/uuid/string_generator.hpp>
+#include <cctype>
 #include <experimental/iterator>
 #include <libyang-cpp/Enum.hpp>
 #include <map>
@@ -118,6 +123,11 @@ auto validDepthValues = [](auto& ctx) {
     _pass(ctx) = _attr(ctx) > 0 && _attr(ctx) < 65536;
 };
 
+auto positiveValues = [](auto& ctx) {
+    _val(ctx) = _attr(ctx);
+    _pass(ctx) = _attr(ctx) > 0;
+};
+
 struct withDefaultsTable : x3::symbols<queryParams::QueryParamValue> {
     withDefaultsTable()
     {
@@ -150,6 +160,24 @@ struct insertTable: x3::symbols<queryParams::QueryParamValue> {
     }
 } const insertTable_;
 
+struct prettyTable : x3::symbols<queryParams::QueryParamValue> {
+    prettyTable()
+    {
+        add
+            ("true", queryParams::pretty::Enabled{})
+            ("false", queryParams::pretty::Disabled{});
+    }
+} const prettyTable_;
+
+struct directionTable : x3::symbols<queryParams::QueryParamValue> {
+    directionTable()
+    {
+        add
+            ("forwards", queryParams::direction::Forwards{})
+            ("backwards", queryParams::direction::Backwards{});
+    }
+} const directionTable_;
+
 /* This grammar is implemented a little bit differently than the RFC states. The ABNF from RFC is:
  *
  *     fields-expr = path "(" fields-expr ")" / path ";" fields-expr / path
@@ -193,6 +221,12 @@ const auto depthParam = x3::rule<class depthParam, queryParams::QueryParamValue>
 const auto insertParam = x3::rule<class insertParam, queryParams::QueryParamValue>{"'first', 'last', 'after' or 'before'"} = insertTable_;
 const auto contentParam = x3::rule<class insertParam, queryParams::QueryParamValue>{"'all', 'nonconfig' or 'config'"} = contentTable_;
 const auto withDefaultsParam = x3::rule<class withDefaultsParam, queryParams::QueryParamValue>{"'trim', 'explicit', 'report-all' or 'report-all-tagged'"} = withDefaultsTable_;
+const auto prettyParam = x3::rule<class prettyParam, queryParams::QueryParamValue>{"'true' or 'false'"} = prettyTable_;
+const auto limitParam = x3::rule<class limitParam, queryParams::QueryParamValue>{"a positive number or 'unbounded'"} = x3::uint_[positiveValues] | (x3::string("unbounded") > x3::attr(queryParams::UnboundedLimit{}));
+const auto offsetParam = x3::rule<class offsetParam, queryParams::QueryParamValue>{"a number"} = x3::uint_;
+const auto cursorParam = x3::rule<class cursorParam, std::string>{"cursor"} = +(x3::alnum | x3::char_('-') | x3::char_('_'));
+const auto directionParam = x3::rule<class directionParam, queryParams::QueryParamValue>{"'forwards' or 'backwards'"} = directionTable_;
+const auto sortByParam = x3::rule<class sortByParam, std::string>{"node identifier"} = x3::raw[apiIdentifier % '/'];
 const auto queryParamPair = x3::rule<class queryParamPair, std::pair<std::string, queryParams::QueryParamValue>>{"query parameter"} =
         (x3::string("depth") > "=" > depthParam) |
         (x3::string("with-defaults") > "=" > withDefaultsParam) |
@@ -202,6 +236,13 @@ const auto queryParamPair = x3::rule<class queryParamPair, std::pair<std::string
         (x3::string("filter") > "=" > filter) |
         (x3::string("start-time") > "=" > dateAndTime) |
         (x3::string("stop-time") > "=" > dateAndTime) |
+        (x3::string("pretty") > "=" > prettyParam) |
+        (x3::string("limit") > "=" > limitParam) |
+        (x3::string("offset") > "=" > offsetParam) |
+        (x3::string("cursor") > "=" > cursorParam) |
+        (x3::string("direction") > "=" > directionParam) |
+        (x3::string("sort-by") > "=" > sortByParam) |
+        (x3::string("sublist-limit") > "=" > limitParam) |
         (x3::string("fields") > "=" > fieldsExpr);
 
 const auto queryParamEmpty = x3::rule<class queryParamEmpty, queryParams::QueryParams>{"empty"} = &x3::eoi > x3::attr(queryParams::QueryParams{});
@@ -470,7 +511,7 @@ void validateQueryParameters(const std::multimap<std::string, queryParams::Query
         }
     }
 
-    for (const auto& param : {"depth", "with-defaults", "content", "fields"}) {
+    for (const auto& param : {"depth", "with-defaults", "content", "fields", "filter", "limit", "offset", "cursor", "direction", "sort-by", "sublist-limit"}) {
         if (auto it = params.find(param); it != params.end() && httpMethod != "GET" && httpMethod != "HEAD") {
             throw ErrorResponse(400, "protocol", "invalid-value", "Query parameter '"s + param + "' can be used only with GET and HEAD methods");
         }
@@ -482,7 +523,7 @@ void validateQueryParameters(const std::multimap<std::string, queryParams::Query
         }
     }
 
-    for (const auto& param : {"filter", "start-time", "stop-time"}) {
+    for (const auto& param : {"start-time", "stop-time"}) {
         if (auto it = params.find(param); it != params.end()) {
             throw ErrorResponse(400, "protocol", "invalid-value", "Query parameter '"s + param + "' can be used only with streams");
         }
@@ -498,6 +539,18 @@ void validateQueryParameters(const std::multimap<std::string, queryParams::Query
             throw ErrorResponse(400, "protocol", "invalid-value", "Query parameter 'point' must always come with parameter 'insert' set to 'before' or 'after'");
         }
     }
+
+    if (params.contains("offset") && params.contains("cursor")) {
+        throw ErrorResponse(400, "protocol", "invalid-value", "Query parameters 'offset' and 'cursor' cannot be used together");
+    }
+
+    if (params.contains("filter") && params.contains("fields")) {
+        throw ErrorResponse(400, "protocol", "invalid-value", "Query parameters 'filter' and 'fields' cannot be used together");
+    }
+
+    if (params.contains("filter") && isListPagination(params)) {
+        throw ErrorResponse(400, "protocol", "invalid-value", "Query parameter 'filter' cannot be used with list pagination");
+    }
 }
 
 void validateQueryParametersForStream(const std::multimap<std::string, queryParams::QueryParamValue>& params_)
@@ -579,6 +632,221 @@ SchemaNodeAndPath asLibyangPath(const libyang::Context& ctx, const std::vector<P
     }
     return {res, currentNode};
 }
+
+namespace {
+/** @brief Splits the XPath at those occurrences of the @p separator which are not within a predicate, parentheses or a string */
+std::vector<std::string> splitXPath(const std::string& xpath, const char separator)
+{
+    std::vector<std::string> parts{""};
+    int depth = 0;
+    std::optional<char> quote;
+    for (const auto c : xpath) {
+        if (quote) {
+            if (c == *quote) {
+                quote.reset();
+            }
+        } else if (c == '\'' || c == '"') {
+            quote = c;
+        } else if (c == '[' || c == '(') {
+            ++depth;
+        } else if (c == ']' || c == ')') {
+            --depth;
+        } else if (c == separator && depth == 0) {
+            parts.emplace_back();
+            continue;
+        }
+        parts.back() += c;
+    }
+    return parts;
+}
+
+/** @brief Splits a location step which consists of just a node name and predicates into these two parts */
+std::optional<std::pair<std::string, std::string>> splitNameTest(const std::string& step)
+{
+    const auto name = step.substr(0, step.find('['));
+    const auto colon = name.find(':');
+    auto isIdentifier = [](const std::string& str) {
+        return !str.empty() && (std::isalpha(str[0]) || str[0] == '_') && std::all_of(str.begin(), str.end(), [](const char c) {
+            return std::isalnum(c) || c == '_' || c == '-' || c == '.';
+        });
+    };
+    if (colon == std::string::npos ? !isIdentifier(name) : !isIdentifier(name.substr(0, colon)) || !isIdentifier(name.substr(colon + 1))) {
+        return std::nullopt;
+    }
+
+    // whatever follows the name has to be enclosed in the brackets of a predicate
+    const auto predicates = step.substr(name.size());
+    int depth = 0;
+    std::optional<char> quote;
+    for (const auto c : predicates) {
+        if (quote) {
+            if (c == *quote) {
+                quote.reset();
+            }
+        } else if (depth == 0 && c != '[') {
+            return std::nullopt;
+        } else if (c == '\'' || c == '"') {
+            quote = c;
+        } else if (c == '[') {
+            ++depth;
+        } else if (c == ']') {
+            --depth;
+        }
+    }
+    if (depth != 0 || quote) {
+        return std::nullopt;
+    }
+    return std::pair{name, predicates};
+}
+
+/** @brief The node name including the module which it inherits from its parent */
+std::string qualifiedName(const std::string& name, std::string& module)
+{
+    if (auto colon = name.find(':'); colon != std::string::npos) {
+        module = name.substr(0, colon);
+        return name;
+    }
+    return module + ":" + name;
+}
+
+/** @brief The path of the filter merged into the path of the target, if the filter is just a path through the target */
+std::optional<std::string> mergeIntoTarget(const std::vector<std::string>& targetSteps, const std::string& filter)
+{
+    auto steps = splitXPath(filter, '/');
+    steps.erase(steps.begin()); // before the leading slash
+    if (steps.size() < targetSteps.size()) {
+        return std::nullopt;
+    }
+
+    std::string xpath;
+    std::string targetModule;
+    std::string filterModule;
+    for (std::size_t i = 0; i < steps.size(); ++i) {
+        const auto step = boost::algorithm::trim_copy(steps[i]);
+        auto nameTest = splitNameTest(step);
+        if (!nameTest) {
+            return std::nullopt;
+        }
+        if (i >= targetSteps.size()) {
+            xpath += "/" + step;
+            continue;
+        }
+        auto targetNameTest = splitNameTest(targetSteps[i]);
+        if (!targetNameTest || qualifiedName(nameTest->first, filterModule) != qualifiedName(targetNameTest->first, targetModule)) {
+            return std::nullopt;
+        }
+        // The filter's predicates come first so that any position() within them still counts all siblings. The
+        // target's predicates only compare the keys, so their order does not matter.
+        xpath += "/" + targetNameTest->first + nameTest->second + targetNameTest->second;
+    }
+    return xpath;
+}
+
+/** @brief Is this a relative path which consists of just node names and predicates, i.e., without any other axes? */
+bool isPlainRelativePath(const std::string& path)
+{
+    const auto steps = splitXPath(path, '/');
+    return std::all_of(steps.begin(), steps.end(), [](const auto& step) { return splitNameTest(boost::algorithm::trim_copy(step)).has_value(); });
+}
+
+/** @brief The filter with each of its relative paths evaluated from the target */
+std::vector<std::string> absoluteFilter(const std::string& target, const std::string& filter)
+{
+    std::vector<std::string> paths;
+    for (auto& path : splitXPath(filter, '|')) {
+        boost::algorithm::trim(path);
+        paths.emplace_back(path.starts_with('/') ? path : (target == "/*" ? "" : target) + "/" + path);
+    }
+    return paths;
+}
+}
+
+/** @brief Checks that the XPath of the filter query parameter is valid and that it refers to some schema nodes */
+void validateFilter(const libyang::Context& ctx, const std::string& xpath)
+{
+    try {
+        if (ctx.findXPath(xpath).empty()) {
+            throw ErrorResponse(400, "protocol", "invalid-value", "Query parameter 'filter' does not select any data nodes");
+        }
+    } catch (const libyang::Error& e) {
+        throw ErrorResponse(400, "protocol", "invalid-value", "Query parameter 'filter' is not a valid XPath: "s + e.what());
+    }
+}
+
+/** @brief Checks that the sort-by node identifier refers to a leaf of the list entry, and not to anything in a nested list */
+void validateSortBy(const libyang::SchemaNode& list, const std::string& nodeIdentifier)
+{
+    std::vector<std::string> segments;
+    boost::split(segments, nodeIdentifier, boost::is_any_of("/"));
+
+    auto currentNode = list;
+    for (const auto& segment : segments) {
+        auto colon = segment.find(':');
+        auto ident = colon == std::string::npos ? ApiIdentifier{segment} : ApiIdentifier{segment.substr(0, colon), segment.substr(colon + 1)};
+        auto child = findChildSchemaNode(currentNode, ident);
+        if (!child) {
+            throw ErrorResponse(400, "protocol", "invalid-value", "Query parameter 'sort-by': node '" + ident.name() + "' is not a child of '" + currentNode.path() + "'");
+        }
+        if (child->nodeType() == libyang::NodeType::List || child->nodeType() == libyang::NodeType::Leaflist) {
+            throw ErrorResponse(400, "protocol", "invalid-value", "Query parameter 'sort-by': '" + child->path() + "' is a list or a leaf-list");
+        }
+        currentNode = *child;
+    }
+
+    if (currentNode.nodeType() != libyang::NodeType::Leaf) {
+        throw ErrorResponse(400, "protocol", "invalid-value", "Query parameter 'sort-by': '" + currentNode.path() + "' is not a leaf");
+    }
+}
+
+/** @brief Translates the URI of a paginated GET request into a libyang path to the list or leaf-list
+ *
+ * Unlike all other data resources, the target of the list pagination is the whole list or leaf-list, i.e., the last
+ * segment of the URI comes without any keys.
+ */
+std::string asListPagePath(const libyang::Context& ctx, const std::string& httpMethod, const impl::URIPath& uri, const queryParams::QueryParams& queryParameters)
+{
+    if (uri.segments.empty() || (uri.prefix.resourceType != impl::URIPrefix::Type::BasicRestconfData && uri.prefix.resourceType != impl::URIPrefix::Type::NMDADatastore)) {
+        throw ErrorResponse(400, "protocol", "invalid-value", "List pagination requires a list or a leaf-list as the target");
+    }
+
+    const auto& lastSegment = uri.segments.back();
+    auto [parentLyPath, schemaNodeParent] = asLibyangPath(ctx, uri.segments.begin(), uri.segments.end() - 1);
+
+    std::optional<libyang::SchemaNode> schemaNode;
+    if (schemaNodeParent) {
+        if (!(schemaNode = findChildSchemaNode(*schemaNodeParent, lastSegment.apiIdent))) {
+            throw ErrorResponse(400, "application", "operation-failed", "Node '" + lastSegment.apiIdent.name() + "' is not a child of '" + schemaNodeParent->path() + "'");
+        }
+    } else {
+        try {
+            schemaNode = ctx.findPath("/" + lastSegment.apiIdent.name());
+        } catch (const libyang::Error& e) {
+            throw ErrorResponse(400, "application", "operation-failed", e.what());
+        }
+    }
+
+    if ((schemaNode->nodeType() != libyang::NodeType::List && schemaNode->nodeType() != libyang::NodeType::Leaflist) || !lastSegment.keys.empty()) {
+        throw ErrorResponse(400, "protocol", "invalid-value", "List pagination requires a list or a leaf-list as the target");
+    }
+    validateMethodForNode(httpMethod, uri.prefix, schemaNode);
+
+    if (auto it = queryParameters.find("sort-by"); it != queryParameters.end()) {
+        if (schemaNode->nodeType() != libyang::NodeType::List) {
+            throw ErrorResponse(400, "protocol", "invalid-value", "Query parameter 'sort-by' can be used only with lists");
+        }
+        validateSortBy(*schemaNode, std::get<std::string>(it->second));
+    }
+
+    return parentLyPath + "/" + maybeQualified(*schemaNode);
+}
+}
+
+/** @brief Does the request ask for just a part of a list or a leaf-list? */
+bool isListPagination(const queryParams::QueryParams& queryParams)
+{
+    return std::any_of(queryParams.begin(), queryParams.end(), [](const auto& param) {
+        return param.first == "limit" || param.first == "offset" || param.first == "cursor" || param.first == "direction" || param.first == "sort-by";
+    });
 }
 
 /** @brief Returns a schema node corresponding to the parsed RESTCONF URI */
@@ -600,6 +868,8 @@ constexpr bool isInternalRPCPath(const std::string& schemaPath)
         "/ietf-subscribed-notifications:modify-subscription",
         "/ietf-subscribed-notifications:delete-subscription",
         "/ietf-subscribed-notifications:kill-subscription",
+        "/rousette:changes-since",
+        "/rousette:bulk-read",
     };
 
     return std::find(arr.begin(), arr.end(), schemaPath) != arr.end();
@@ -623,6 +893,10 @@ RestconfRequest asRestconfRequest(const libyang::Context& ctx, const std::string
     auto queryParameters = impl::parseQueryParams(uriQueryString, uriPath.size() + 1 /* '?' */);
     validateQueryParameters(queryParameters, httpMethod);
 
+    if ((httpMethod == "GET" || httpMethod == "HEAD") && isListPagination(queryParameters)) {
+        return {RestconfRequest::Type::GetData, uri.prefix.datastore, asListPagePath(ctx, httpMethod, uri, queryParameters), queryParameters};
+    }
+
     auto [lyPath, schemaNode] = asLibyangPath(ctx, uri.segments.begin(), uri.segments.end());
     validateMethodForNode(httpMethod, uri.prefix, schemaNode);
 
@@ -640,6 +914,10 @@ RestconfRequest asRestconfRequest(const libyang::Context& ctx, const std::string
     } else if ((httpMethod == "GET" || httpMethod == "HEAD")) {
         type = RestconfRequest::Type::GetData;
         path = uri.segments.empty() ? "/*" : path;
+
+        if (auto it = queryParameters.find("filter"); it != queryParameters.end()) {
+            validateFilter(ctx, boost::algorithm::join(absoluteFilter(path, std::get<std::string>(it->second)), " | "));
+        }
     } else if (httpMethod == "PUT") {
         type = RestconfRequest::Type::CreateOrReplaceThisNode;
     } else if (httpMethod == "DELETE" && schemaNode) {
@@ -813,6 +1091,47 @@ std::string fieldsToXPath(const libyang::Context& ctx, const std::string& prefix
     return boost::algorithm::join(paths, " | ");
 }
 
+/** @brief Translates the filter query parameter into an XPath of the nodes which it selects within the target
+ *
+ * A relative filter is evaluated from the target. When the filter is a plain path which leads through the target,
+ * the target's predicates are added to it, so that only the target's subtree is searched.
+ *
+ * Other filters (e.g., those which use axes or functions outside of the predicates) select nodes anywhere in the
+ * datastore, and each of them is checked against the target. XPath 1.0 has no intersection, so the node is kept when
+ * one of its ancestors (or the node itself) is a member of the target node set, i.e., when adding it to that set does
+ * not make the set any bigger. This works no matter how many nodes the target matches, but it takes time which grows
+ * with the number of the selected nodes times the number of the target nodes.
+ */
+std::string filterToXPath(const std::string& target, const std::string& filter)
+{
+    if (target == "/*") {
+        return boost::algorithm::join(absoluteFilter(target, filter), " | ");
+    }
+
+    auto targetSteps = splitXPath(target, '/');
+    targetSteps.erase(targetSteps.begin());
+    std::vector<std::string> paths;
+    bool withinTarget = true;
+    for (auto& path : splitXPath(filter, '|')) {
+        boost::algorithm::trim(path);
+        if (!path.starts_with('/')) {
+            withinTarget = withinTarget && isPlainRelativePath(path);
+            paths.emplace_back(target + "/" + path);
+        } else if (auto merged = mergeIntoTarget(targetSteps, path)) {
+            paths.emplace_back(*merged);
+        } else {
+            withinTarget = false;
+            paths.emplace_back(path);
+        }
+    }
+
+    const auto xpath = boost::algorithm::join(paths, " | ");
+    if (withinTarget) {
+        return xpath;
+    }
+    return "(" + xpath + ")[ancestor-or-self::node()[count(. | " + target + ") = count(" + target + ")]]";
+}
+
 std::string uriJoin(const std::string& a, const std::string& b)
 {
     if (a.ends_with('/') && b.starts_with("/")) {
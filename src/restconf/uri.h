@@ -58,6 +58,9 @@ namespace queryParams {
 struct UnboundedDepth {
     bool operator==(const UnboundedDepth&) const = default;
 };
+struct UnboundedLimit {
+    bool operator==(const UnboundedLimit&) const = default;
+};
 
 namespace withDefaults {
 struct Trim {
@@ -103,6 +106,24 @@ struct After {
 using PointParsed = std::vector<PathSegment>;
 }
 
+namespace pretty {
+struct Enabled {
+    bool operator==(const Enabled&) const = default;
+};
+struct Disabled {
+    bool operator==(const Disabled&) const = default;
+};
+}
+
+namespace direction {
+struct Forwards {
+    bool operator==(const Forwards&) const = default;
+};
+struct Backwards {
+    bool operator==(const Backwards&) const = default;
+};
+}
+
 namespace fields {
 struct ParenExpr;
 struct SemiExpr;
@@ -170,7 +191,12 @@ using QueryParamValue = std::variant<
     insert::Before,
     insert::After,
     insert::PointParsed,
-    fields::Expr>;
+    fields::Expr,
+    pretty::Enabled,
+    pretty::Disabled,
+    UnboundedLimit,
+    direction::Forwards,
+    direction::Backwards>;
 using QueryParams = std::multimap<std::string, QueryParamValue>;
 }
 
@@ -224,6 +250,8 @@ std::optional<std::variant<libyang::Module, libyang::SubmoduleParsed>> asYangMod
 RestconfStreamRequest asRestconfStreamRequest(const std::string& httpMethod, const std::string& uriPath, const std::string& uriQueryString);
 std::set<std::string> allowedHttpMethodsForUri(const libyang::Context& ctx, const std::string& uriPath);
 
+bool isListPagination(const queryParams::QueryParams& queryParams);
 std::string fieldsToXPath(const libyang::Context& ctx, const std::string& prefix, const queryParams::fields::Expr& expr);
+std::string filterToXPath(const std::string& target, const std::string& filter);
 std::string uriJoin(const std::string& a, const std::string& b);
 }
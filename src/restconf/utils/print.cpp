@@ -0,0 +1,707 @@
+/*
+ * Copyright (C) 2026 CESNET, https://photonics.cesnet.cz/
+ *
+ * Written by Jan Kundrát <jan.kundrat@cesnet.cz>
+ *
+*/
+
+#include <algorithm>
+#include <iterator>
+#include <libyang-cpp/Module.hpp>
+#include <libyang-cpp/SchemaNode.hpp>
+#include <stdexcept>
+#include "restconf/utils/print.h"
+
+using namespace std::string_literals;
+
+namespace rousette::restconf {
+
+namespace {
+[[noreturn]] void malformed()
+{
+    throw std::runtime_error{"Cannot split the printed data"};
+}
+
+bool isListOrLeafList(const libyang::DataNode& node)
+{
+    if (node.isOpaque()) {
+        return false;
+    }
+    const auto type = node.schema().nodeType();
+    return type == libyang::NodeType::List || type == libyang::NodeType::Leaflist;
+}
+
+bool isKey(const libyang::DataNode& node)
+{
+    return !node.isOpaque() && node.schema().nodeType() == libyang::NodeType::Leaf && node.schema().asLeaf().isKey();
+}
+
+bool hasMeta(const libyang::DataNode& node)
+{
+    auto meta = node.meta();
+    return meta.begin() != meta.end();
+}
+
+/** @short Group the nodes as libyang prints them in JSON, i.e., all instances of a list or a leaf-list go together
+ *
+ * The opaque nodes, which come last, are kept together as well.
+ */
+std::vector<std::vector<libyang::DataNode>> members(const std::vector<libyang::DataNode>& nodes)
+{
+    std::vector<std::vector<libyang::DataNode>> res;
+    std::optional<std::string> previous; ///< schema path of the previous node if it can have more instances
+    for (const auto& node : nodes) {
+        std::optional<std::string> current;
+        if (node.isOpaque()) {
+            current = "";
+        } else if (isListOrLeafList(node)) {
+            current = node.schema().path();
+        }
+        if (current && current == previous) {
+            res.back().emplace_back(node);
+        } else {
+            res.push_back({node});
+        }
+        previous = std::move(current);
+    }
+    return res;
+}
+
+bool isSpace(const char c)
+{
+    return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+}
+
+void skipSpace(const std::string& text, std::size_t& pos)
+{
+    while (pos < text.size() && isSpace(text[pos])) {
+        ++pos;
+    }
+}
+
+/** @short Skip @p c (and the whitespace in front of it) if it comes next */
+bool consume(const std::string& text, std::size_t& pos, const char c)
+{
+    skipSpace(text, pos);
+    if (pos < text.size() && text[pos] == c) {
+        ++pos;
+        return true;
+    }
+    return false;
+}
+
+void expect(const std::string& text, std::size_t& pos, const char c)
+{
+    if (!consume(text, pos, c)) {
+        malformed();
+    }
+}
+
+/** @short Is there nothing but the end of the enclosing JSON object or XML element? */
+bool atEnd(const std::string& text, std::size_t pos)
+{
+    skipSpace(text, pos);
+    return pos >= text.size() || text[pos] == '}' || text[pos] == ']' || text.compare(pos, 2, "</") == 0;
+}
+
+/** @short Strip @p closing brackets or closing tags, and the whitespace around them, from the end of the text */
+std::size_t stripClosing(const std::string& text, const std::size_t start, std::size_t closing, const bool xml)
+{
+    auto end = text.size();
+    for (; closing > 0; --closing) {
+        while (end > start && isSpace(text[end - 1])) {
+            --end;
+        }
+        if (end == start) {
+            malformed();
+        }
+        if (!xml) {
+            if (text[end - 1] != '}' && text[end - 1] != ']') {
+                malformed();
+            }
+            --end;
+            continue;
+        }
+        auto tag = text.rfind('<', end - 1);
+        if (text[end - 1] != '>' || tag == std::string::npos || tag < start || text.compare(tag, 2, "</") != 0) {
+            malformed();
+        }
+        end = tag;
+    }
+    // the pieces of a formatted XML document end with a newline, JSON members do not
+    while (end > start && (text[end - 1] == ' ' || (!xml && isSpace(text[end - 1])))) {
+        --end;
+    }
+    return end;
+}
+
+void skipJsonValue(const std::string& text, std::size_t& pos)
+{
+    skipSpace(text, pos);
+    if (pos >= text.size()) {
+        malformed();
+    }
+    if (text[pos] == '"') {
+        for (++pos; pos < text.size() && text[pos] != '"'; ++pos) {
+            if (text[pos] == '\\') {
+                ++pos;
+            }
+        }
+        if (pos >= text.size()) {
+            malformed();
+        }
+        ++pos;
+    } else if (text[pos] == '{' || text[pos] == '[') {
+        const auto closing = text[pos] == '{' ? '}' : ']';
+        ++pos;
+        if (consume(text, pos, closing)) {
+            return;
+        }
+        do {
+            if (closing == '}') {
+                skipJsonValue(text, pos);
+                expect(text, pos, ':');
+            }
+            skipJsonValue(text, pos);
+        } while (consume(text, pos, ','));
+        expect(text, pos, closing);
+    } else {
+        while (pos < text.size() && !isSpace(text[pos]) && text[pos] != ',' && text[pos] != '}' && text[pos] != ']') {
+            ++pos;
+        }
+    }
+}
+
+/** @short Skip a member of a JSON object along with the comma which separates it from the next one */
+void skipJsonMember(const std::string& text, std::size_t& pos)
+{
+    skipJsonValue(text, pos);
+    expect(text, pos, ':');
+    skipJsonValue(text, pos);
+    consume(text, pos, ',');
+}
+
+/** @short Skip a tag, and tell whether it is an opening tag of an element with some content */
+bool skipXmlTag(const std::string& text, std::size_t& pos)
+{
+    skipSpace(text, pos);
+    if (pos >= text.size() || text[pos] != '<') {
+        malformed();
+    }
+    char quote = 0;
+    for (++pos; pos < text.size(); ++pos) {
+        if (quote) {
+            if (text[pos] == quote) {
+                quote = 0;
+            }
+        } else if (text[pos] == '"' || text[pos] == '\'') {
+            quote = text[pos];
+        } else if (text[pos] == '>') {
+            ++pos;
+            return text[pos - 2] != '/';
+        }
+    }
+    malformed();
+}
+
+void skipXmlElement(const std::string& text, std::size_t& pos)
+{
+    // text never contains a "<", that is always escaped
+    std::size_t depth = 0;
+    do {
+        skipSpace(text, pos);
+        if (text.compare(pos, 2, "</") == 0) {
+            if (depth == 0) {
+                malformed();
+            }
+            skipXmlTag(text, pos);
+            --depth;
+        } else if (skipXmlTag(text, pos)) {
+            ++depth;
+        }
+        if (depth > 0 && (pos = text.find('<', pos)) == std::string::npos) {
+            malformed();
+        }
+    } while (depth > 0);
+}
+}
+
+/** @short Split the tree into pieces, creating all the wrappers of the tree's nodes which the printer is going to need */
+TreePrinter::TreePrinter(libyang::DataNode&& tree, const libyang::DataFormat format, const libyang::PrintFlags flags, const std::size_t entriesPerPiece)
+    : m_tree(std::move(tree))
+    , m_format(format)
+    , m_flags(flags)
+    , m_formatted((flags | libyang::PrintFlags::Shrink) != flags)
+    , m_entriesPerPiece(std::max<std::size_t>(1, entriesPerPiece))
+    , m_levels(1)
+{
+    std::vector<libyang::DataNode> siblings;
+    for (const auto& node : m_tree.firstSibling().siblings()) {
+        siblings.emplace_back(node);
+    }
+    Plan plan;
+    planChildren(plan, siblings, std::nullopt, 0, m_format == libyang::DataFormat::JSON ? 1 : 0);
+    m_steps = std::move(plan.steps);
+    m_pieces = std::move(plan.pieces);
+}
+
+void TreePrinter::Plan::add(Piece&& piece)
+{
+    steps.push_back({Step::Kind::Piece, {}});
+    pieces.emplace_back(std::move(piece));
+}
+
+void TreePrinter::Plan::add(const Step::Kind kind, std::string text)
+{
+    steps.push_back({kind, std::move(text)});
+}
+
+void TreePrinter::Plan::append(Plan&& other)
+{
+    std::move(other.steps.begin(), other.steps.end(), std::back_inserter(steps));
+    std::move(other.pieces.begin(), other.pieces.end(), std::back_inserter(pieces));
+}
+
+/** @short Plan the printing of the @p nodes, which are children of the @p parent, and tell whether some of them were split
+ *
+ * The @p level is the indentation of the nodes. The @p levels refer to the split nodes from the top level down to the
+ * parent.
+ */
+bool TreePrinter::planChildren(Plan& plan, const std::vector<libyang::DataNode>& nodes, const std::optional<libyang::DataNode>& parent, const std::size_t levels, const std::size_t level)
+{
+    bool split = false;
+    std::vector<libyang::DataNode> pending; ///< complete members which are printed by libyang, all at once
+    std::size_t pendingKeys = 0;
+    auto flush = [&]() {
+        if (!pending.empty()) {
+            plan.add(Piece{parent, levels, std::move(pending), false, pendingKeys});
+            pending.clear();
+            pendingKeys = 0;
+        }
+    };
+
+    for (auto& member : members(nodes)) {
+        const auto& first = member.front();
+        const auto type = first.isOpaque() ? std::nullopt : std::optional{first.schema().nodeType()};
+        Plan inner;
+        bool memberSplit = false;
+        if (isListOrLeafList(first) && member.size() > m_entriesPerPiece
+            // in JSON, the metadata of leaf-list entries are printed after all of these entries
+            && (type == libyang::NodeType::List || std::none_of(member.begin(), member.end(), hasMeta))) {
+            Plan entries;
+            for (std::size_t i = 0; i < member.size(); i += m_entriesPerPiece) {
+                const auto end = member.begin() + std::min(i + m_entriesPerPiece, member.size());
+                entries.add(Piece{parent, levels, std::vector<libyang::DataNode>(member.begin() + i, end), true, 0});
+            }
+            planList(inner, std::move(entries), first, parent, level);
+            memberSplit = true;
+        } else if (type == libyang::NodeType::Container) {
+            memberSplit = planNode(inner, first, parent, levels, level);
+        } else if (type == libyang::NodeType::List) {
+            Plan entries;
+            std::vector<libyang::DataNode> unsplit;
+            auto flushEntries = [&]() {
+                if (!unsplit.empty()) {
+                    entries.add(Piece{parent, levels, std::move(unsplit), true, 0});
+                    unsplit.clear();
+                }
+            };
+            for (const auto& entry : member) {
+                Plan nested;
+                if (planNode(nested, entry, parent, levels, m_format == libyang::DataFormat::JSON ? level + 1 : level)) {
+                    flushEntries();
+                    entries.append(std::move(nested));
+                    memberSplit = true;
+                } else {
+                    unsplit.emplace_back(entry);
+                }
+            }
+            flushEntries();
+            if (memberSplit) {
+                planList(inner, std::move(entries), first, parent, level);
+            }
+        }
+
+        if (memberSplit) {
+            flush();
+            plan.append(std::move(inner));
+            split = true;
+            continue;
+        }
+        if (isKey(first)) {
+            ++pendingKeys;
+        }
+        std::move(member.begin(), member.end(), std::back_inserter(pending));
+        if (!parent) {
+            // each top-level sibling is a piece of its own
+            flush();
+        }
+    }
+    flush();
+    return split;
+}
+
+/** @short Plan the printing of a container or a list entry if there is something to split inside */
+bool TreePrinter::planNode(Plan& plan, const libyang::DataNode& node, const std::optional<libyang::DataNode>& parent, const std::size_t levels, const std::size_t level)
+{
+    if (node.isOpaque() || hasMeta(node)) {
+        // libyang prints the metadata of a container or a list entry as the first member
+        return false;
+    }
+
+    const auto schema = node.schema();
+    const bool listEntry = schema.nodeType() == libyang::NodeType::List;
+    auto nested = m_levels[levels];
+    nested.push_back({listEntry, listEntry ? schema.asList().keys().size() : 0});
+    m_levels.emplace_back(std::move(nested));
+
+    std::vector<libyang::DataNode> children;
+    for (const auto& child : node.immediateChildren()) {
+        children.emplace_back(child);
+    }
+    Plan inner;
+    if (!planChildren(inner, children, node, m_levels.size() - 1, level + 1)) {
+        return false;
+    }
+
+    const std::string name{schema.name()};
+    if (m_format == libyang::DataFormat::JSON) {
+        plan.add(Step::Kind::Open, indent(level) + (listEntry ? "" : jsonName(node, parent)) + "{");
+        plan.append(std::move(inner));
+        plan.add(Step::Kind::Close, (m_formatted ? "\n" : "") + indent(level) + "}");
+    } else {
+        const auto module = schema.module();
+        std::string xmlns;
+        if (!parent || parent->schema().module().name() != module.name()) {
+            xmlns = " xmlns=\"" + std::string{module.ns()} + "\"";
+        }
+        plan.add(Step::Kind::Open, indent(level) + "<" + name + xmlns + ">" + (m_formatted ? "\n" : ""));
+        plan.append(std::move(inner));
+        plan.add(Step::Kind::Close, indent(level) + "</" + name + ">" + (m_formatted ? "\n" : ""));
+    }
+    return true;
+}
+
+/** @short Plan the printing of a list or a leaf-list whose @p entries have been planned already */
+void TreePrinter::planList(Plan& plan, Plan&& entries, const libyang::DataNode& first, const std::optional<libyang::DataNode>& parent, const std::size_t level)
+{
+    if (m_format == libyang::DataFormat::JSON) {
+        plan.add(Step::Kind::Open, indent(level) + jsonName(first, parent) + "[");
+        plan.append(std::move(entries));
+        plan.add(Step::Kind::Close, (m_formatted ? "\n" : "") + indent(level) + "]");
+    } else {
+        plan.append(std::move(entries));
+    }
+}
+
+std::string TreePrinter::indent(const std::size_t level) const
+{
+    return m_formatted ? std::string(2 * level, ' ') : std::string{};
+}
+
+/** @short The member name, which is qualified by the module name at the top level and wherever the module changes */
+std::string TreePrinter::jsonName(const libyang::DataNode& node, const std::optional<libyang::DataNode>& parent) const
+{
+    const auto schema = node.schema();
+    const std::string module{schema.module().name()};
+    const bool qualified = !parent || std::string{parent->schema().module().name()} != module;
+    return "\"" + (qualified ? module + ":" : "") + std::string{schema.name()} + (m_formatted ? "\": " : "\":");
+}
+
+std::size_t TreePrinter::pieces() const
+{
+    return m_pieces.size();
+}
+
+/** @short Serialize one piece of the tree on its own
+ *
+ * Printing only reads the tree, and no wrappers of the tree's nodes are created or destroyed here, so several pieces
+ * can be printed at once from different threads. The printer must stay alive and unmodified for that time, though.
+ */
+std::string TreePrinter::printPiece(const std::size_t index) const
+{
+    const auto& piece = m_pieces[index];
+    if (!piece.parent && !piece.entries && piece.nodes.size() == 1) {
+        return cut(piece, piece.nodes.front().printStr(m_format, m_flags).value_or(""));
+    }
+
+    // Anything else has to be printed along with the enclosing nodes, and libyang only prints complete subtrees, so
+    // this works on a copy. The copy is a separate tree which is only ever seen by this thread.
+    constexpr auto options = libyang::DuplicationOptions::Recursive | libyang::DuplicationOptions::WithFlags;
+    std::optional<libyang::DataNode> copy;
+    if (piece.parent) {
+        // list keys are always copied along with their list entry
+        copy = piece.parent->duplicate(libyang::DuplicationOptions::WithParents | libyang::DuplicationOptions::WithFlags);
+        for (auto it = piece.nodes.begin() + piece.keys; it != piece.nodes.end(); ++it) {
+            copy->insertChild(it->duplicate(options));
+        }
+        while (auto parent = copy->parent()) {
+            copy = *parent;
+        }
+    } else {
+        for (const auto& node : piece.nodes) {
+            auto dup = node.duplicate(options);
+            copy = copy ? copy->insertSibling(dup) : dup;
+        }
+    }
+    return cut(piece, copy->printStr(m_format, m_flags | libyang::PrintFlags::Siblings).value_or(""));
+}
+
+/** @short Extract the piece's own text from a document which has been printed along with the enclosing nodes */
+std::string TreePrinter::cut(const Piece& piece, const std::string& text) const
+{
+    const auto& levels = m_levels[piece.levels];
+    std::size_t pos = 0;
+    std::size_t closing = 0;
+    std::size_t keys = 0; ///< the keys which come before the next node on the way down
+
+    if (m_format == libyang::DataFormat::JSON) {
+        if (atEnd(text, pos)) {
+            return {};
+        }
+        expect(text, pos, '{');
+        ++closing;
+        for (const auto& level : levels) {
+            for (std::size_t i = 0; i < keys; ++i) {
+                skipJsonMember(text, pos);
+            }
+            if (atEnd(text, pos)) {
+                return {};
+            }
+            skipJsonValue(text, pos);
+            expect(text, pos, ':');
+            if (level.listEntry) {
+                expect(text, pos, '[');
+                ++closing;
+            }
+            expect(text, pos, '{');
+            ++closing;
+            keys = level.keys;
+        }
+        for (std::size_t i = piece.keys; i < keys; ++i) {
+            skipJsonMember(text, pos);
+        }
+        if (atEnd(text, pos)) {
+            return {};
+        }
+        if (piece.entries) {
+            skipJsonValue(text, pos);
+            expect(text, pos, ':');
+            expect(text, pos, '[');
+            ++closing;
+        }
+    } else {
+        for (const auto& level : levels) {
+            for (std::size_t i = 0; i < keys; ++i) {
+                skipXmlElement(text, pos);
+            }
+            if (atEnd(text, pos) || !skipXmlTag(text, pos)) {
+                return {};
+            }
+            ++closing;
+            keys = level.keys;
+        }
+        for (std::size_t i = piece.keys; i < keys; ++i) {
+            skipXmlElement(text, pos);
+        }
+        if (atEnd(text, pos)) {
+            return {};
+        }
+    }
+
+    // the piece starts with the indentation of its first line
+    if (m_formatted && pos < text.size() && text[pos] == '\n') {
+        ++pos;
+    }
+    const auto end = stripClosing(text, pos, closing, m_format != libyang::DataFormat::JSON);
+    return text.substr(pos, end - pos);
+}
+
+/** @short What separates another member of the innermost JSON object or array from the previous one */
+std::string TreePrinter::beginMember()
+{
+    if (m_format != libyang::DataFormat::JSON) {
+        return {};
+    }
+    const auto newline = m_formatted ? "\n"s : ""s;
+    if (m_open.empty()) {
+        // the top-level object is only opened once there is something to put in there
+        m_open.push_back(true);
+        return "{" + newline;
+    } else if (m_open.back()) {
+        return "," + newline;
+    }
+    m_open.back() = true;
+    return newline;
+}
+
+/** @short Write out the enclosing nodes up to the next piece */
+std::string TreePrinter::writeSteps()
+{
+    std::string chunk;
+    for (; m_nextStep < m_steps.size() && m_steps[m_nextStep].kind != Step::Kind::Piece; ++m_nextStep) {
+        const auto& step = m_steps[m_nextStep];
+        if (step.kind == Step::Kind::Open) {
+            chunk += beginMember() + step.text;
+            m_open.push_back(false);
+        } else {
+            m_open.pop_back();
+            chunk += step.text;
+        }
+    }
+    return chunk;
+}
+
+/** @short Turn the printed pieces into the output chunks, this has to be called for all the pieces in order */
+std::string TreePrinter::splice(const std::string& piece)
+{
+    auto chunk = writeSteps();
+    ++m_nextStep;
+    if (!piece.empty()) {
+        chunk += beginMember() + piece;
+    }
+    return chunk;
+}
+
+/** @short The final chunk, once all the pieces have been spliced */
+std::string TreePrinter::finish()
+{
+    auto chunk = writeSteps();
+    if (m_format != libyang::DataFormat::JSON) {
+        return chunk;
+    } else if (m_open.empty()) {
+        // nothing was printed, let libyang decide how an empty tree looks like
+        return m_tree.printStr(m_format, m_flags | libyang::PrintFlags::Siblings).value_or("");
+    } else {
+        return chunk + (m_formatted ? "\n}\n" : "}");
+    }
+}
+
+ParallelTreePrinter::ParallelTreePrinter(TreePrinter&& printer, Submit submit, std::function<void()> wakeUp, const std::size_t window)
+    : m_printer(std::move(printer))
+    , m_shared(std::make_shared<Shared>())
+    , m_submit(std::move(submit))
+    , m_window(std::max<std::size_t>(1, window))
+{
+    m_shared->printer = &m_printer;
+    m_shared->wakeUp = std::move(wakeUp);
+    m_shared->printed.resize(m_printer.pieces());
+}
+
+ParallelTreePrinter::~ParallelTreePrinter()
+{
+    std::unique_lock lock{m_shared->mutex};
+    m_shared->cancelled = true;
+    m_shared->idle.wait(lock, [this] { return m_shared->running == 0; });
+}
+
+/** @short Submit the printing of the first pieces, before anybody asks for them */
+void ParallelTreePrinter::start()
+{
+    std::unique_lock lock{m_shared->mutex};
+    submitMore(lock);
+}
+
+/** @short Provide the next chunk if it has been printed already
+ *
+ * Exceptions from printing of any piece are rethrown from here.
+ */
+ParallelTreePrinter::Status ParallelTreePrinter::next(std::string& chunk)
+{
+    return take(chunk, false);
+}
+
+/** @short Provide the next chunk, blocking until it has been printed
+ *
+ * This never reports Status::Pending. Exceptions from printing of any piece are rethrown from here.
+ */
+ParallelTreePrinter::Status ParallelTreePrinter::wait(std::string& chunk)
+{
+    return take(chunk, true);
+}
+
+ParallelTreePrinter::Status ParallelTreePrinter::take(std::string& chunk, const bool block)
+{
+    std::unique_lock lock{m_shared->mutex};
+
+    while (true) {
+        if (m_shared->error) {
+            std::rethrow_exception(m_shared->error);
+        }
+
+        if (m_finished) {
+            return Status::Finished;
+        }
+
+        if (m_shared->nextToSplice == m_shared->printed.size()) {
+            m_finished = true;
+            chunk = m_printer.finish();
+            return chunk.empty() ? Status::Finished : Status::Ready;
+        }
+
+        submitMore(lock);
+
+        auto& printed = m_shared->printed[m_shared->nextToSplice];
+        if (!printed && block) {
+            m_shared->printedOne.wait(lock, [&printed] { return printed.has_value(); });
+            continue; // that piece might have failed
+        } else if (!printed) {
+            m_shared->waiting = true;
+            return Status::Pending;
+        }
+
+        auto piece = std::move(*printed);
+        printed.reset();
+        ++m_shared->nextToSplice;
+        chunk = m_printer.splice(piece);
+        if (!chunk.empty()) {
+            return Status::Ready;
+        }
+    }
+}
+
+/** @short Keep up to m_window pieces either being printed or waiting for the consumer */
+void ParallelTreePrinter::submitMore(std::unique_lock<std::mutex>& lock)
+{
+    while (m_nextToSubmit < m_shared->printed.size() && m_nextToSubmit - m_shared->nextToSplice < m_window) {
+        auto index = m_nextToSubmit++;
+        auto task = [shared = m_shared, index]() {
+            {
+                std::lock_guard lock{shared->mutex};
+                if (shared->cancelled) {
+                    return; // the client has gone away, and the tree might be gone as well
+                }
+                ++shared->running;
+            }
+
+            std::string piece;
+            std::exception_ptr error;
+            try {
+                piece = shared->printer->printPiece(index);
+            } catch (...) {
+                error = std::current_exception();
+            }
+
+            std::lock_guard lock{shared->mutex};
+            --shared->running;
+            shared->printed[index] = std::move(piece);
+            if (error && !shared->error) {
+                shared->error = error;
+            }
+            if (shared->cancelled) {
+                shared->idle.notify_all();
+            } else if (shared->waiting && index == shared->nextToSplice) {
+                shared->waiting = false;
+                shared->wakeUp();
+            } else {
+                shared->printedOne.notify_all();
+            }
+        };
+
+        // the task might run right away, and it needs the lock
+        lock.unlock();
+        m_submit(task);
+        lock.lock();
+    }
+}
+}
@@ -0,0 +1,159 @@
+/*
+ * Copyright (C) 2026 CESNET, https://photonics.cesnet.cz/
+ *
+ * Written by Jan Kundrát <jan.kundrat@cesnet.cz>
+ *
+*/
+
+#pragma once
+
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <libyang-cpp/DataNode.hpp>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace rousette::restconf {
+
+/** @short Serializes a data tree piecewise, down to the entries of big lists
+ *
+ * Concatenating all the chunks yields exactly the same text as DataNode::printStr() with PrintFlags::Siblings, but
+ * there is no need to hold the complete text in memory. Each top-level sibling is a piece of its own. Lists and
+ * leaf-lists with more than @p entriesPerPiece instances are split into pieces of up to that many entries, no matter
+ * how deep they are. The containers and list entries which enclose them are written out by the printer itself, and
+ * everything else is printed by libyang.
+ *
+ * The printer takes over the tree, and all the libyang-cpp wrappers of the tree's nodes which it ever needs are created
+ * by the constructor. Their bookkeeping is not thread-safe, so the caller must not keep any other wrapper of that tree
+ * around. The individual pieces can then be printed concurrently via printPiece(), but they have to be passed to
+ * splice() in order, followed by finish().
+ * */
+class TreePrinter {
+public:
+    TreePrinter(libyang::DataNode&& tree, const libyang::DataFormat format, const libyang::PrintFlags flags, const std::size_t entriesPerPiece = 256);
+
+    std::size_t pieces() const;
+    std::string printPiece(const std::size_t index) const;
+    std::string splice(const std::string& piece);
+    std::string finish();
+
+private:
+    /** @short One of the split containers or list entries which enclose a piece, as seen from the top level */
+    struct Level {
+        bool listEntry;
+        std::size_t keys; ///< The list keys, which are printed before anything else
+    };
+
+    /** @short Some children of a split node (or some top-level siblings) which are printed by libyang at once */
+    struct Piece {
+        std::optional<libyang::DataNode> parent; ///< The split node, nullopt at the top level
+        std::size_t levels; ///< Index into m_levels, describing the split nodes down to the parent
+        std::vector<libyang::DataNode> nodes; ///< Complete members of the parent (see members()), or entries of one list
+        bool entries;
+        std::size_t keys; ///< The parent's keys which are among the nodes
+    };
+
+    /** @short Something to write out between the pieces, or a piece itself */
+    struct Step {
+        enum class Kind {
+            Open,
+            Close,
+            Piece,
+        };
+        Kind kind;
+        std::string text;
+    };
+
+    struct Plan {
+        std::vector<Step> steps;
+        std::vector<Piece> pieces;
+
+        void add(Piece&& piece);
+        void add(Step::Kind kind, std::string text);
+        void append(Plan&& other);
+    };
+
+    libyang::DataNode m_tree;
+    libyang::DataFormat m_format;
+    libyang::PrintFlags m_flags; ///< How to print a single sibling, i.e., without PrintFlags::Siblings
+    bool m_formatted;
+    std::size_t m_entriesPerPiece;
+    std::vector<std::vector<Level>> m_levels;
+    std::vector<Step> m_steps;
+    std::vector<Piece> m_pieces;
+    std::size_t m_nextStep = 0;
+    std::vector<bool> m_open; ///< For each open JSON object or array, whether it has some members already
+
+    bool planChildren(Plan& plan, const std::vector<libyang::DataNode>& nodes, const std::optional<libyang::DataNode>& parent, const std::size_t levels, const std::size_t level);
+    bool planNode(Plan& plan, const libyang::DataNode& node, const std::optional<libyang::DataNode>& parent, const std::size_t levels, const std::size_t level);
+    void planList(Plan& plan, Plan&& entries, const libyang::DataNode& first, const std::optional<libyang::DataNode>& parent, const std::size_t level);
+    std::string indent(const std::size_t level) const;
+    std::string jsonName(const libyang::DataNode& node, const std::optional<libyang::DataNode>& parent) const;
+    std::string cut(const Piece& piece, const std::string& text) const;
+    std::string beginMember();
+    std::string writeSteps();
+};
+
+/** @short Prints the pieces of a TreePrinter in parallel, keeping a bounded number of them in memory
+ *
+ * Each piece is printed by a task which is submitted through the provided function; next() never prints anything on
+ * its own, so its caller (the HTTP event loop) just copies the printed text. Up to @p window pieces are either being
+ * printed or waiting for the consumer, so the memory use is bounded by that many pieces. Once next() has reported that
+ * nothing is ready, the wake-up function is invoked as soon as the next chunk becomes available. A consumer which is not
+ * driven by an event loop can use wait() instead, which blocks until the next chunk has been printed.
+ *
+ * The tasks never own the tree. The destructor waits for the tasks which are printing right now, and the ones which
+ * have not started yet will not touch the tree at all, so the tree and all its wrappers are destroyed by whoever drops
+ * the printer, and never while a task still reads them.
+ * */
+class ParallelTreePrinter {
+public:
+    /** @short Run the task eventually, in some other thread than the one which calls next() */
+    using Submit = std::function<void(std::function<void()>)>;
+
+    ParallelTreePrinter(TreePrinter&& printer, Submit submit, std::function<void()> wakeUp, const std::size_t window);
+    ~ParallelTreePrinter();
+    ParallelTreePrinter(const ParallelTreePrinter&) = delete;
+    ParallelTreePrinter& operator=(const ParallelTreePrinter&) = delete;
+
+    void start();
+
+    enum class Status {
+        Ready,
+        Pending,
+        Finished,
+    };
+    Status next(std::string& chunk);
+    Status wait(std::string& chunk);
+
+private:
+    /** @short Everything that the tasks share with the printer; this outlives the printer if some task is still queued */
+    struct Shared {
+        std::mutex mutex;
+        std::condition_variable idle;
+        std::condition_variable printedOne; ///< Some task has finished, for the consumers which block in wait()
+        const TreePrinter* printer; ///< Only valid until cancelled is set
+        std::function<void()> wakeUp;
+        std::vector<std::optional<std::string>> printed; ///< Results of the submitted tasks, indexed by piece
+        std::size_t nextToSplice = 0;
+        std::size_t running = 0; ///< Tasks which are printing right now
+        bool cancelled = false;
+        bool waiting = false; ///< The consumer has been told that nothing is ready
+        std::exception_ptr error; ///< The first failure of a printing task
+    };
+
+    TreePrinter m_printer;
+    std::shared_ptr<Shared> m_shared;
+    Submit m_submit;
+    const std::size_t m_window;
+    std::size_t m_nextToSubmit = 0;
+    bool m_finished = false;
+
+    Status take(std::string& chunk, const bool block);
+    void submitMore(std::unique_lock<std::mutex>& lock);
+};
+}
@@ -6,6 +6,8 @@
 */
 
 #include <algorithm>
+#include <boost/algorithm/string/join.hpp>
+#include <cctype>
 #include <libyang-cpp/Context.hpp>
 #include <libyang-cpp/DataNode.hpp>
 #include <libyang-cpp/SchemaNode.hpp>
@@ -83,6 +85,88 @@ bool isKeyNode(const libyang::DataNode& maybeList, const libyang::DataNode& node
     return false;
 }
 
+namespace {
+/** @brief Percent-encodes everything but the unreserved characters of RFC 3986 */
+std::string percentEncode(const std::string& str)
+{
+    static const auto hex = "0123456789ABCDEF";
+    std::string res;
+    for (const unsigned char c : str) {
+        if (std::isalnum(c) || c == '-' || c == '.' || c == '_' || c == '~') {
+            res += c;
+        } else {
+            res += '%';
+            res += hex[c >> 4];
+            res += hex[c & 0x0f];
+        }
+    }
+    return res;
+}
+}
+
+/** @brief Data resource identifier of the node, i.e., its path in the RESTCONF URI format (RFC 8040, section 3.5.3) */
+std::string asRestconfPath(const libyang::DataNode& node)
+{
+    std::string segment;
+    auto parent = node.parent();
+    if (!parent || parent->schema().module().name() != node.schema().module().name()) {
+        segment = node.schema().module().name() + ':';
+    }
+    segment += node.schema().name();
+
+    if (node.schema().nodeType() == libyang::NodeType::List) {
+        std::vector<std::string> keyValues;
+        for (const auto& key : node.schema().asList().keys()) {
+            keyValues.emplace_back(percentEncode(node.findPath(key.name())->asTerm().valueStr()));
+        }
+        segment += '=' + boost::algorithm::join(keyValues, ",");
+    } else if (node.schema().nodeType() == libyang::NodeType::Leaflist) {
+        segment += '=' + percentEncode(node.asTerm().valueStr());
+    }
+
+    return (parent ? asRestconfPath(*parent) : std::string{}) + '/' + segment;
+}
+
+/** @brief Copies the nodes which match the XPath into a single new tree, along with their parents, the same way as sysrepo's getData() returns them
+ *
+ * @return The first top-level node of the copy, or nullopt if nothing matches
+ */
+std::optional<libyang::DataNode> copyWithParents(const libyang::DataNode& tree, const std::string& xpath)
+{
+    std::optional<libyang::DataNode> res;
+    for (const auto& match : tree.findXPath(xpath)) {
+        // the copy is a chain of nodes from the top-level one down to the match, the keys of list entries aside
+        std::vector<libyang::DataNode> chain{match.duplicate(libyang::DuplicationOptions::WithParents | libyang::DuplicationOptions::Recursive)};
+        while (chain.back().parent()) {
+            chain.emplace_back(*chain.back().parent());
+        }
+        std::reverse(chain.begin(), chain.end());
+
+        if (!res) {
+            res = chain.front();
+            continue;
+        }
+
+        // attach the copy below the deepest node which the result has already; entries of keyless lists cannot be told apart
+        std::optional<libyang::DataNode> parent;
+        for (auto& node : chain) {
+            const bool keyless = node.schema().nodeType() == libyang::NodeType::List && node.schema().asList().keys().empty();
+            if (auto existing = keyless ? std::nullopt : res->findPath(node.path())) {
+                parent = existing;
+                continue;
+            }
+
+            node.unlink();
+            if (parent) {
+                parent->insertChild(node);
+            } else {
+                res = res->insertSibling(node);
+            }
+            break;
+        }
+    }
+    return res;
+}
 
 /** @brief Wraps a notification data tree with RESTCONF notification envelope. */
 std::string as_restconf_notification(const libyang::Context& ctx, libyang::DataFormat dataFormat, libyang::DataNode notification, const sysrepo::NotificationTimeStamp& time)
@@ -6,6 +6,7 @@
 */
 
 #include <chrono>
+#include <optional>
 #include <sysrepo-cpp/Subscription.hpp>
 
 namespace libyang {
@@ -22,5 +23,7 @@ std::string listKeyPredicate(const std::vector<libyang::Leaf>& listKeyLeafs, con
 std::string leaflistKeyPredicate(const std::string& keyValue);
 bool isUserOrderedList(const libyang::DataNode& node);
 bool isKeyNode(const libyang::DataNode& maybeList, const libyang::DataNode& node);
+std::string asRestconfPath(const libyang::DataNode& node);
+std::optional<libyang::DataNode> copyWithParents(const libyang::DataNode& tree, const std::string& xpath);
 std::string as_restconf_notification(const libyang::Context& ctx, libyang::DataFormat dataFormat, libyang::DataNode notification, const sysrepo::NotificationTimeStamp& time);
 }
@@ -48,6 +48,19 @@ const ng::header_map xmlHeaders{
     {"content-type", {"application/yang-data+xml", false}},
 };
 
+/* Bodies which are big enough to be compressed for a client which accepts that */
+const ng::header_map jsonVaryHeaders{
+    {"access-control-allow-origin", {"*", false}},
+    {"content-type", {"application/yang-data+json", false}},
+    {"vary", {"accept-encoding", false}},
+};
+
+const ng::header_map xmlVaryHeaders{
+    {"access-control-allow-origin", {"*", false}},
+    {"content-type", {"application/yang-data+xml", false}},
+    {"vary", {"accept-encoding", false}},
+};
+
 const ng::header_map noContentTypeHeaders{
     {"access-control-allow-origin", {"*", false}},
 };
@@ -57,6 +70,12 @@ const ng::header_map yangHeaders{
     {"content-type", {"application/yang", false}},
 };
 
+const ng::header_map yangVaryHeaders{
+    {"access-control-allow-origin", {"*", false}},
+    {"content-type", {"application/yang", false}},
+    {"vary", {"accept-encoding", false}},
+};
+
 const ng::header_map plaintextHeaders{
     {"access-control-allow-origin", {"*", false}},
     {"content-type", {"text/plain", false}},
@@ -65,6 +84,7 @@ const ng::header_map plaintextHeaders{
 const ng::header_map eventStreamHeaders{
     {"access-control-allow-origin", {"*", false}},
     {"content-type", {"text/event-stream", false}},
+    {"vary", {"accept-encoding", false}},
 };
 
 #define ACCESS_CONTROL_ALLOW_ORIGIN {"access-control-allow-origin", "*"}
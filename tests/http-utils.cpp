@@ -6,7 +6,18 @@
  */
 
 #include "trompeloeil_doctest.h"
+#include <array>
+#include <boost/asio/local/stream_protocol.hpp>
+#include <boost/asio/read.hpp>
+#include <boost/asio/write.hpp>
 #include <experimental/iterator>
+#include <filesystem>
+#include <thread>
+#include <unistd.h>
+#include <zlib.h>
+#include <zstd.h>
+#include "http/Compression.h"
+#include "http/SocketRelay.h"
 #include "http/utils.hpp"
 #include "tests/pretty_printers.h"
 
@@ -23,6 +34,40 @@ struct StringMaker<rousette::http::ProtoAndHost> {
 };
 }
 
+namespace {
+std::string decompress(const rousette::http::ContentCoding coding, const std::string& data)
+{
+    std::string res;
+    std::array<char, 4096> buf;
+    if (coding == rousette::http::ContentCoding::Zstd) {
+        auto ctx = ZSTD_createDCtx();
+        ZSTD_inBuffer in{data.data(), data.size(), 0};
+        while (in.pos < in.size) {
+            ZSTD_outBuffer out{buf.data(), buf.size(), 0};
+            REQUIRE(!ZSTD_isError(ZSTD_decompressStream(ctx, &out, &in)));
+            res.append(buf.data(), out.pos);
+        }
+        ZSTD_freeDCtx(ctx);
+        return res;
+    }
+
+    z_stream stream{};
+    REQUIRE(inflateInit2(&stream, 15 + 32 /* detect zlib or gzip */) == Z_OK);
+    stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.data()));
+    stream.avail_in = data.size();
+    int ret;
+    do {
+        stream.next_out = reinterpret_cast<Bytef*>(buf.data());
+        stream.avail_out = buf.size();
+        ret = inflate(&stream, Z_NO_FLUSH);
+        REQUIRE((ret == Z_OK || ret == Z_STREAM_END || ret == Z_BUF_ERROR));
+        res.append(buf.data(), buf.size() - stream.avail_out);
+    } while (ret == Z_OK && (stream.avail_in || !stream.avail_out));
+    inflateEnd(&stream);
+    return res;
+}
+}
+
 TEST_CASE("Accept header")
 {
     for (const auto& [input, expected] : {
@@ -87,3 +132,112 @@ TEST_CASE("Get Host from forwarded")
     REQUIRE(rousette::http::parseForwardedHeader("host=proto=https") == ProtoAndHost{});
     REQUIRE(rousette::http::parseForwardedHeader("") == ProtoAndHost{});
 }
+
+TEST_CASE("HTTP dates")
+{
+    using namespace std::chrono_literals;
+    const auto time = std::chrono::system_clock::time_point{784111777s};
+    REQUIRE(rousette::http::formatHttpDate(time) == "Sun, 06 Nov 1994 08:49:37 GMT");
+    REQUIRE(rousette::http::formatHttpDate(time + 999ms) == "Sun, 06 Nov 1994 08:49:37 GMT");
+    REQUIRE(rousette::http::parseHttpDate("Sun, 06 Nov 1994 08:49:37 GMT") == time);
+    REQUIRE(rousette::http::parseHttpDate("Sunday, 06-Nov-94 08:49:37 GMT") == std::nullopt);
+    REQUIRE(rousette::http::parseHttpDate("") == std::nullopt);
+}
+
+TEST_CASE("Entity tag lists")
+{
+    using rousette::http::entityTagListContains;
+    REQUIRE(rousette::http::parseEntityTagList(R"("xyz" ,W/"abc",, "")") == std::vector<std::string>{R"("xyz")", R"(W/"abc")", R"("")"});
+    REQUIRE(rousette::http::parseEntityTagList("") == std::vector<std::string>{});
+    REQUIRE(entityTagListContains(R"("abc")", R"("abc")", false));
+    REQUIRE(entityTagListContains(R"("xyz", "abc")", R"("abc")", false));
+    REQUIRE(entityTagListContains(R"("xyz",W/"abc")", R"("abc")", true));
+    REQUIRE(!entityTagListContains(R"("xyz",W/"abc")", R"("abc")", false));
+    REQUIRE(!entityTagListContains(R"("abcd")", R"("abc")", true));
+    REQUIRE(!entityTagListContains("*", R"("abc")", true));
+    REQUIRE(!entityTagListContains("", R"("abc")", true));
+}
+
+TEST_CASE("Content coding negotiation")
+{
+    using rousette::http::chooseContentCoding;
+    using rousette::http::ContentCoding;
+    REQUIRE(chooseContentCoding("") == ContentCoding::Identity);
+    REQUIRE(chooseContentCoding("identity") == ContentCoding::Identity);
+    REQUIRE(chooseContentCoding("br") == ContentCoding::Identity);
+    REQUIRE(chooseContentCoding("gzip") == ContentCoding::Gzip);
+    REQUIRE(chooseContentCoding("x-gzip") == ContentCoding::Gzip);
+    REQUIRE(chooseContentCoding("gzip, deflate, br, zstd") == ContentCoding::Zstd);
+    REQUIRE(chooseContentCoding("deflate, GZIP") == ContentCoding::Gzip);
+    REQUIRE(chooseContentCoding("gzip;q=0.5, deflate") == ContentCoding::Deflate);
+    REQUIRE(chooseContentCoding("gzip;q=0, deflate;q=0") == ContentCoding::Identity);
+    REQUIRE(chooseContentCoding("*") == ContentCoding::Zstd);
+    REQUIRE(chooseContentCoding("*;q=0.1, zstd;q=0") == ContentCoding::Gzip);
+    REQUIRE(chooseContentCoding("zstd;q=bogus, deflate") == ContentCoding::Deflate);
+}
+
+TEST_CASE("Compression")
+{
+    using rousette::http::ContentCoding;
+    std::string data;
+    for (int i = 0; i < 20000; ++i) {
+        data += "{\"name\": \"eth" + std::to_string(i) + "\"},";
+    }
+
+    for (const auto coding : {ContentCoding::Gzip, ContentCoding::Deflate, ContentCoding::Zstd}) {
+        CAPTURE(*rousette::http::contentCodingName(coding));
+        rousette::http::Compressor compressor{coding};
+
+        // everything which has been fed so far is available after a flush
+        auto compressed = compressor.compress(std::string_view{data}.substr(0, 1000));
+        compressed += compressor.flush();
+        REQUIRE(decompress(coding, compressed) == data.substr(0, 1000));
+
+        compressed += compressor.compress(std::string_view{data}.substr(1000));
+        compressed += compressor.finish();
+        REQUIRE(compressed.size() < data.size() / 4);
+        REQUIRE(decompress(coding, compressed) == data);
+    }
+
+    REQUIRE_THROWS_AS(rousette::http::Compressor{ContentCoding::Identity}, std::logic_error);
+}
+
+TEST_CASE("Peer credentials of UNIX socket clients")
+{
+    boost::asio::io_context io;
+    boost::asio::ip::tcp::acceptor server{io, boost::asio::ip::tcp::endpoint{boost::asio::ip::make_address("::1"), 0}};
+    const auto path = (std::filesystem::temp_directory_path() / ("rousette-relay-" + std::to_string(::getpid()) + ".sock")).string();
+    rousette::http::SocketRelay relay{io, path, 0600, server.local_endpoint()};
+    auto work = boost::asio::make_work_guard(io);
+    std::thread loop{[&io]() { io.run(); }};
+
+    // the credentials are known before the server gets to see any data
+    boost::asio::local::stream_protocol::socket local{io};
+    local.connect(boost::asio::local::stream_protocol::endpoint{path});
+    auto relayed = server.accept();
+    boost::asio::write(local, boost::asio::buffer("x", 1));
+    std::array<char, 1> received;
+    boost::asio::read(relayed, boost::asio::buffer(received));
+    auto credentials = relay.peer(relayed.remote_endpoint());
+    REQUIRE(credentials);
+    REQUIRE(credentials->uid == ::getuid());
+    REQUIRE(credentials->pid == ::getpid());
+
+    // nothing is known about the clients which connect to the server directly
+    boost::asio::ip::tcp::socket remote{io};
+    remote.connect(server.local_endpoint());
+    auto direct = server.accept();
+    REQUIRE(!relay.peer(direct.remote_endpoint()));
+
+    // the credentials are forgotten once the client goes away, so that the TCP port cannot be reused to impersonate it
+    const auto endpoint = relayed.remote_endpoint();
+    local.close();
+    for (int i = 0; i < 100 && relay.peer(endpoint); ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds{10});
+    }
+    REQUIRE(!relay.peer(endpoint));
+
+    work.reset();
+    io.stop();
+    loop.join();
+}
@@ -157,6 +157,11 @@ struct StringMaker<rousette::restconf::queryParams::QueryParamValue> {
             [](const rousette::restconf::queryParams::insert::Last&) -> std::string { return "Last{}"; },
             [](const rousette::restconf::queryParams::insert::Before&) -> std::string { return "Before{}"; },
             [](const rousette::restconf::queryParams::insert::After&) -> std::string { return "After{}"; },
+            [](const rousette::restconf::queryParams::pretty::Enabled&) -> std::string { return "Pretty{}"; },
+            [](const rousette::restconf::queryParams::pretty::Disabled&) -> std::string { return "Compact{}"; },
+            [](const rousette::restconf::queryParams::UnboundedLimit&) -> std::string { return "UnboundedLimit{}"; },
+            [](const rousette::restconf::queryParams::direction::Forwards&) -> std::string { return "Forwards{}"; },
+            [](const rousette::restconf::queryParams::direction::Backwards&) -> std::string { return "Backwards{}"; },
             [](const rousette::restconf::queryParams::insert::PointParsed& p) -> std::string {
                 return ("PointParsed{" + StringMaker<decltype(p)>::convert(p) + "}").c_str();
             },
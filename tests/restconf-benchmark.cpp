@@ -0,0 +1,110 @@
+/*
+ * Copyright (C) 2026 CESNET, https://photonics.cesnet.cz/
+ *
+ * Written by Jan Kundrát <jan.kundrat@cesnet.cz>
+ *
+ */
+
+#include "tests/aux-utils.h"
+#include <cstdlib>
+#include <future>
+#include <thread>
+#include <nghttp2/asio_http2.h>
+#include <spdlog/spdlog.h>
+#include <sysrepo-cpp/utils/utils.hpp>
+#include "restconf/Server.h"
+#include "tests/configure.cmake.h"
+
+/* These are not really tests; they only measure how fast the server is. They take a while, so they are skipped
+ * unless the ROUSETTE_BENCHMARK environment variable is set, e.g.:
+ *
+ *   ROUSETTE_BENCHMARK=1 ctest -R restconf-benchmark --verbose
+ */
+namespace {
+const bool benchmarksDisabled = !std::getenv("ROUSETTE_BENCHMARK");
+constexpr auto CLIENTS = 16;
+constexpr auto REQUESTS_PER_CLIENT = 200;
+}
+
+TEST_CASE("throughput with multiple sysrepo connections" * doctest::skip(benchmarksDisabled))
+{
+    spdlog::set_level(spdlog::level::warn);
+    sysrepo::setGlobalContextOptions(sysrepo::ContextFlags::LibYangPrivParsed | sysrepo::ContextFlags::NoPrinted, sysrepo::GlobalContextEffect::Immediate);
+    auto srConn = sysrepo::Connection{};
+    auto srSess = srConn.sessionStart(sysrepo::Datastore::Running);
+    srSess.sendRPC(srSess.getContext().newPath("/ietf-factory-default:factory-reset"));
+    auto nacmGuard = manageNacm(srSess);
+
+    srSess.switchDatastore(sysrepo::Datastore::Operational);
+    srSess.setItem("/ietf-system:system/hostname", "benchmark");
+    srSess.applyChanges();
+    setupRealNacm(srSess);
+
+    for (std::size_t connections : {1, 2, 4, 8}) {
+        auto server = rousette::restconf::Server{srConn, SERVER_ADDRESS, SERVER_PORT, {.threads = 4, .workerThreads = 8, .connections = connections}};
+
+        const auto start = std::chrono::steady_clock::now();
+        std::vector<std::future<int>> clients;
+        for (int i = 0; i < CLIENTS; ++i) {
+            clients.emplace_back(std::async(std::launch::async, []() {
+                int ok = 0;
+                for (int j = 0; j < REQUESTS_PER_CLIENT; ++j) {
+                    ok += get(RESTCONF_DATA_ROOT "/ietf-system:system/hostname", {}).statusCode == 200;
+                }
+                return ok;
+            }));
+        }
+
+        int ok = 0;
+        for (auto& client : clients) {
+            ok += client.get();
+        }
+        const auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+
+        REQUIRE(ok == CLIENTS * REQUESTS_PER_CLIENT);
+        spdlog::warn("{} sysrepo connections: {} requests in {} ms ({:.0f} requests/s)",
+                     connections, ok, elapsed.count(), ok * 1000.0 / elapsed.count());
+    }
+}
+
+TEST_CASE("parallel serialization of a big datastore" * doctest::skip(benchmarksDisabled))
+{
+    spdlog::set_level(spdlog::level::warn);
+    sysrepo::setGlobalContextOptions(sysrepo::ContextFlags::LibYangPrivParsed | sysrepo::ContextFlags::NoPrinted, sysrepo::GlobalContextEffect::Immediate);
+    auto srConn = sysrepo::Connection{};
+    auto srSess = srConn.sessionStart(sysrepo::Datastore::Running);
+    srSess.sendRPC(srSess.getContext().newPath("/ietf-factory-default:factory-reset"));
+    auto nacmGuard = manageNacm(srSess);
+
+    // a few big top-level subtrees besides the usual ones
+    srSess.switchDatastore(sysrepo::Datastore::Operational);
+    for (int i = 0; i < 20'000; ++i) {
+        const auto name = std::to_string(i);
+        srSess.setItem("/example:channel-plan/channel[name='" + name + "']/lower-frequency", std::to_string(i));
+        srSess.setItem("/example:channel-plan/channel[name='" + name + "']/upper-frequency", std::to_string(i + 1));
+        srSess.setItem("/example:ordered-lists/lst[name='" + name + "']", std::nullopt);
+        srSess.setItem("/example:ordered-lists/ll[.='" + name + "']", std::nullopt);
+        srSess.setItem("/example:ordered-lists/ll2[.='" + name + "']", std::nullopt);
+    }
+    srSess.applyChanges();
+    setupRealNacm(srSess);
+
+    constexpr auto ROUNDS = 10;
+    std::optional<Response> serial;
+    for (std::size_t serializers : {0, 1, 2, 4, 8}) {
+        auto server = rousette::restconf::Server{srConn, SERVER_ADDRESS, SERVER_PORT, {.workerThreads = 1, .serializerThreads = serializers}};
+
+        const auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < ROUNDS; ++i) {
+            auto response = get(RESTCONF_ROOT_DS("operational"), {AUTH_ROOT});
+            if (!serial) {
+                serial = response;
+            }
+            REQUIRE(response == *serial);
+        }
+        const auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+
+        spdlog::warn("{} serializer threads ({} cores): {} bytes, {} ms per request",
+                     serializers, std::thread::hardware_concurrency(), serial->data.size(), elapsed.count() / ROUNDS);
+    }
+}
@@ -72,12 +72,62 @@ TEST_CASE("Event stream tests")
         RUN_LOOP_WITH_EXCEPTIONS;
     }
 
+    SECTION("Compressed stream")
+    {
+        std::string acceptEncoding;
+        std::optional<std::string> contentEncoding;
+        rousette::restconf::OutputOptions outputOptions;
+
+        SECTION("gzip")
+        {
+            acceptEncoding = "gzip";
+            contentEncoding = "gzip";
+        }
+
+        SECTION("zstd")
+        {
+            acceptEncoding = "gzip, zstd";
+            contentEncoding = "zstd";
+        }
+
+        SECTION("compression disabled")
+        {
+            acceptEncoding = "gzip, zstd";
+            outputOptions.compression = false;
+        }
+
+        auto server = std::make_unique<rousette::restconf::Server>(srConn, SERVER_ADDRESS, SERVER_PORT, rousette::restconf::ServerOptions{.output = outputOptions});
+
+        const std::string another(R"({"example:eventA":{"message":"blabla","progress":12}})");
+        EXPECT_NOTIFICATION(notification, seq1);
+        EXPECT_NOTIFICATION(another, seq2);
+
+        PREPARE_LOOP_WITH_EXCEPTIONS;
+        auto notificationThread = std::jthread(wrap_exceptions_and_asio(bg, io, [&]() {
+            auto notifSession = sysrepo::Connection{}.sessionStart();
+            auto ctx = notifSession.getContext();
+
+            WAIT_UNTIL_SSE_CLIENT_REQUESTS;
+            SEND_NOTIFICATION(notification);
+            // each event can be decoded as soon as it arrives, without waiting for the rest of the stream
+            waitForCompletionAndBitMore(seq1);
+            SEND_NOTIFICATION(another);
+            waitForCompletionAndBitMore(seq2);
+            server.reset();
+        }));
+
+        SSEClient client(io, SERVER_ADDRESS, SERVER_PORT, requestSent, netconfWatcher, "/streams/NETCONF/JSON", std::map<std::string, std::string>{AUTH_ROOT, {"accept-encoding", acceptEncoding}});
+
+        RUN_LOOP_WITH_EXCEPTIONS;
+        REQUIRE(client.contentEncoding == contentEncoding);
+    }
+
     SECTION("Keep-alive pings")
     {
         constexpr auto pingInterval = 1s;
 
         RestconfNotificationWatcher netconfWatcher(srConn.sessionStart().getContext());
-        auto server = std::make_unique<rousette::restconf::Server>(srConn, SERVER_ADDRESS, SERVER_PORT, std::chrono::milliseconds{0}, pingInterval);
+        auto server = std::make_unique<rousette::restconf::Server>(srConn, SERVER_ADDRESS, SERVER_PORT, rousette::restconf::ServerOptions{.keepAlivePingInterval = pingInterval});
 
         auto notifSession = sysrepo::Connection{}.sessionStart();
         auto ctx = notifSession.getContext();
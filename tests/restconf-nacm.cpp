@@ -7,11 +7,82 @@
  */
 
 #include "tests/aux-utils.h"
+#include <array>
+#include <boost/asio/local/stream_protocol.hpp>
+#include <filesystem>
 #include <nghttp2/asio_http2.h>
+#include <pwd.h>
 #include <spdlog/spdlog.h>
 #include <sysrepo-cpp/utils/utils.hpp>
+#include <thread>
+#include <unistd.h>
 #include "restconf/Server.h"
 
+namespace {
+/** @short Forwards TCP connections to a UNIX socket, because the HTTP/2 client of nghttp2-asio can only use TCP */
+class UnixSocketForwarder {
+public:
+    UnixSocketForwarder(const std::string& path)
+        : m_acceptor(m_io, boost::asio::ip::tcp::endpoint{boost::asio::ip::make_address(SERVER_ADDRESS), 0})
+        , m_path(path)
+    {
+        accept();
+        m_thread = std::thread{[this]() { m_io.run(); }};
+    }
+
+    ~UnixSocketForwarder()
+    {
+        m_io.stop();
+        m_thread.join();
+    }
+
+    std::string port() const
+    {
+        return std::to_string(m_acceptor.local_endpoint().port());
+    }
+
+private:
+    using Buffer = std::array<char, 16384>;
+
+    void accept()
+    {
+        m_acceptor.async_accept([this](const boost::system::error_code& ec, boost::asio::ip::tcp::socket socket) {
+            if (ec) {
+                return;
+            }
+            auto client = std::make_shared<boost::asio::ip::tcp::socket>(std::move(socket));
+            auto upstream = std::make_shared<boost::asio::local::stream_protocol::socket>(m_io);
+            upstream->connect(boost::asio::local::stream_protocol::endpoint{m_path});
+            pump(client, upstream, std::make_shared<Buffer>());
+            pump(upstream, client, std::make_shared<Buffer>());
+            accept();
+        });
+    }
+
+    template <typename From, typename To>
+    static void pump(std::shared_ptr<From> from, std::shared_ptr<To> to, std::shared_ptr<Buffer> buf)
+    {
+        from->async_read_some(boost::asio::buffer(*buf), [from, to, buf](const boost::system::error_code& ec, std::size_t length) {
+            if (ec) {
+                boost::system::error_code ignored;
+                to->shutdown(boost::asio::socket_base::shutdown_send, ignored);
+                return;
+            }
+            boost::asio::async_write(*to, boost::asio::buffer(*buf, length), [from, to, buf](const boost::system::error_code& ec, std::size_t) {
+                if (!ec) {
+                    pump(from, to, buf);
+                }
+            });
+        });
+    }
+
+    boost::asio::io_context m_io;
+    boost::asio::ip::tcp::acceptor m_acceptor;
+    std::string m_path;
+    std::thread m_thread;
+};
+}
+
 TEST_CASE("NACM")
 {
     spdlog::set_level(spdlog::level::trace);
@@ -359,3 +430,42 @@ TEST_CASE("NACM")
 )"});
     }
 }
+
+TEST_CASE("peer credentials of local clients")
+{
+    spdlog::set_level(spdlog::level::trace);
+    sysrepo::setGlobalContextOptions(sysrepo::ContextFlags::LibYangPrivParsed | sysrepo::ContextFlags::NoPrinted, sysrepo::GlobalContextEffect::Immediate);
+    auto srConn = sysrepo::Connection{};
+    auto srSess = srConn.sessionStart(sysrepo::Datastore::Running);
+    auto nacmGuard = manageNacm(srSess);
+    srSess.sendRPC(srSess.getContext().newPath("/ietf-factory-default:factory-reset"));
+
+    srSess.setItem("/ietf-system:system/hostname", "hostname");
+    srSess.setItem("/ietf-system:system/radius/server[name='a']/udp/address", "1.1.1.1");
+    srSess.setItem("/ietf-system:system/radius/server[name='a']/udp/shared-secret", "shared-secret");
+    srSess.applyChanges();
+    setupRealNacm(srSess);
+
+    // whoever runs this test can read the RADIUS secrets, unlike the anonymous user
+    const auto localUser = std::string{::getpwuid(::getuid())->pw_name};
+    srSess.setItem("/ietf-netconf-acm:nacm/groups/group[name='optics']/user-name[.='" + localUser + "']", "");
+    srSess.applyChanges();
+
+    const auto socketPath = (std::filesystem::temp_directory_path() / ("rousette-nacm-" + std::to_string(::getpid()) + ".sock")).string();
+    auto server = rousette::restconf::Server{srConn, SERVER_ADDRESS, SERVER_PORT, {.extraSockets = {rousette::restconf::ListeningSocket{.socket = socketPath, .mode = 0600, .peerCredentialsAsNacmUser = true}}}};
+    UnixSocketForwarder forwarder{socketPath};
+
+    // no credentials are needed on the UNIX socket, the request is made on behalf of the connecting process' user
+    auto local = clientRequest(SERVER_ADDRESS, forwarder.port(), "GET", RESTCONF_ROOT_DS("running") "/ietf-system:system", "", {});
+    REQUIRE(local.statusCode == 200);
+    REQUIRE(local.data.find("shared-secret") != std::string::npos);
+
+    // the relay connects to the same TCP port which everybody else can use, but those connections are not trusted
+    auto remote = get(RESTCONF_ROOT_DS("running") "/ietf-system:system", {});
+    REQUIRE(remote == Response{200, jsonHeaders, R"({
+  "ietf-system:system": {
+    "hostname": "hostname"
+  }
+}
+)"});
+}
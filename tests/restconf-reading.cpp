@@ -7,24 +7,21 @@
  */
 
 #include "tests/aux-utils.h"
+#include <array>
+#include <future>
 #include <nghttp2/asio_http2.h>
+#include <spdlog/sinks/base_sink.h>
 #include <spdlog/spdlog.h>
-#include <sysrepo-cpp/utils/utils.hpp>
+#include <thread>
+#include <zlib.h>
 #include "restconf/Server.h"
 #include "tests/configure.cmake.h"
 #include "tests/event_watchers.h"
 
 using namespace std::string_literals;
 
-TEST_CASE("reading data")
+TEST_CASE_FIXTURE(SysrepoFixture, "reading data")
 {
-    spdlog::set_level(spdlog::level::trace);
-    sysrepo::setGlobalContextOptions(sysrepo::ContextFlags::LibYangPrivParsed | sysrepo::ContextFlags::NoPrinted, sysrepo::GlobalContextEffect::Immediate);
-    auto srConn = sysrepo::Connection{};
-    auto srSess = srConn.sessionStart(sysrepo::Datastore::Running);
-    srSess.sendRPC(srSess.getContext().newPath("/ietf-factory-default:factory-reset"));
-    auto nacmGuard = manageNacm(srSess);
-
     SUBSCRIBE_MODULE(sub1, srSess, "example");
     SUBSCRIBE_MODULE(sub2, srSess, "ietf-system");
 
@@ -64,7 +61,7 @@ TEST_CASE("reading data")
     DOCTEST_SUBCASE("entire datastore")
     {
         // this relies on a NACM rule for anonymous access that filters out "a lot of stuff"
-        REQUIRE(get(RESTCONF_DATA_ROOT, {}) == Response{200, jsonHeaders, R"({
+        REQUIRE(get(RESTCONF_DATA_ROOT, {}) == Response{200, jsonVaryHeaders, R"({
   "example:top-level-leaf": "moo",
   "example:channel-plan": {},
   "example:tlc": {},
@@ -90,7 +87,8 @@ TEST_CASE("reading data")
         "urn:ietf:params:restconf:capability:depth:1.0",
         "urn:ietf:params:restconf:capability:with-defaults:1.0",
         "urn:ietf:params:restconf:capability:filter:1.0",
-        "urn:ietf:params:restconf:capability:fields:1.0"
+        "urn:ietf:params:restconf:capability:fields:1.0",
+        "urn:cesnet:params:restconf:capability:data-filter:1.0"
       ]
     },
     "streams": {
@@ -119,9 +117,9 @@ TEST_CASE("reading data")
 }
 )"});
 
-        REQUIRE(head(RESTCONF_DATA_ROOT, {}) == Response{200, jsonHeaders, ""});
+        REQUIRE(head(RESTCONF_DATA_ROOT, {}) == Response{200, jsonVaryHeaders, ""});
 
-        REQUIRE(get(RESTCONF_ROOT_DS("operational"), {}) == Response{200, jsonHeaders, R"({
+        REQUIRE(get(RESTCONF_ROOT_DS("operational"), {}) == Response{200, jsonVaryHeaders, R"({
   "example:top-level-leaf": "moo",
   "example:channel-plan": {},
   "example:tlc": {},
@@ -147,7 +145,8 @@ TEST_CASE("reading data")
         "urn:ietf:params:restconf:capability:depth:1.0",
         "urn:ietf:params:restconf:capability:with-defaults:1.0",
         "urn:ietf:params:restconf:capability:filter:1.0",
-        "urn:ietf:params:restconf:capability:fields:1.0"
+        "urn:ietf:params:restconf:capability:fields:1.0",
+        "urn:cesnet:params:restconf:capability:data-filter:1.0"
       ]
     },
     "streams": {
@@ -176,7 +175,7 @@ TEST_CASE("reading data")
 }
 )"});
 
-        REQUIRE(head(RESTCONF_ROOT_DS("operational"), {}) == Response{200, jsonHeaders, ""});
+        REQUIRE(head(RESTCONF_ROOT_DS("operational"), {}) == Response{200, jsonVaryHeaders, ""});
 
         REQUIRE(get(RESTCONF_ROOT_DS("running"), {}) == Response{200, jsonHeaders, R"({
   "example:top-level-leaf": "moo",
@@ -726,7 +725,8 @@ TEST_CASE("reading data")
         "urn:ietf:params:restconf:capability:depth:1.0",
         "urn:ietf:params:restconf:capability:with-defaults:1.0",
         "urn:ietf:params:restconf:capability:filter:1.0",
-        "urn:ietf:params:restconf:capability:fields:1.0"
+        "urn:ietf:params:restconf:capability:fields:1.0",
+        "urn:cesnet:params:restconf:capability:data-filter:1.0"
       ]
     },
     "streams": {
@@ -1150,6 +1150,102 @@ TEST_CASE("reading data")
 )"});
     }
 
+    SECTION("filter query param")
+    {
+        srSess.switchDatastore(sysrepo::Datastore::Running);
+        srSess.setItem("/example:tlc/list[name='a']/choice1", "up");
+        srSess.setItem("/example:tlc/list[name='b']/choice1", "down");
+        srSess.setItem("/example:tlc/list[name='c']/choice1", "down");
+        srSess.applyChanges();
+
+        REQUIRE(get(RESTCONF_DATA_ROOT "/example:tlc?filter=/example:tlc/list[choice1='down']", {}) == Response{200, jsonHeaders, R"({
+  "example:tlc": {
+    "list": [
+      {
+        "name": "b",
+        "choice1": "down"
+      },
+      {
+        "name": "c",
+        "choice1": "down"
+      }
+    ]
+  }
+}
+)"});
+
+        // only the data within the target resource are returned
+        REQUIRE(get(RESTCONF_DATA_ROOT "/example:tlc/list=c?filter=/example:tlc/list[choice1='down']", {}) == Response{200, jsonHeaders, R"({
+  "example:tlc": {
+    "list": [
+      {
+        "name": "c",
+        "choice1": "down"
+      }
+    ]
+  }
+}
+)"});
+        REQUIRE(get(RESTCONF_DATA_ROOT "/example:tlc/list=a?filter=/example:tlc/list[choice1='down']", {}).statusCode == 404);
+
+        // several entries of a nested list are selected within the target, and those of the other entries are not
+        for (const auto& [name, third] : {std::pair{"b", "x"}, {"b", "y"}, {"c", "z"}}) {
+            srSess.setItem("/example:tlc/list[name='" + std::string{name} + "']/nested[first='1'][second='2'][third='" + third + "']/fourth", "f");
+        }
+        srSess.applyChanges();
+        REQUIRE(get(RESTCONF_DATA_ROOT "/example:tlc/list=b?filter=/example:tlc/list/nested[fourth='f']", {}) == Response{200, jsonHeaders, R"({
+  "example:tlc": {
+    "list": [
+      {
+        "name": "b",
+        "nested": [
+          {
+            "first": "1",
+            "second": 2,
+            "third": "x",
+            "fourth": "f"
+          },
+          {
+            "first": "1",
+            "second": 2,
+            "third": "y",
+            "fourth": "f"
+          }
+        ]
+      }
+    ]
+  }
+}
+)"});
+
+        // a relative filter starts at the target
+        REQUIRE(get(RESTCONF_DATA_ROOT "/example:tlc/list=b?filter=nested[fourth='f']", {}) == get(RESTCONF_DATA_ROOT "/example:tlc/list=b?filter=/example:tlc/list/nested[fourth='f']", {}));
+
+        REQUIRE(get(RESTCONF_DATA_ROOT "?filter=/example:tlc/list[choice1='up']/name", {}) == Response{200, jsonHeaders, R"({
+  "example:tlc": {
+    "list": [
+      {
+        "name": "a"
+      }
+    ]
+  }
+}
+)"});
+
+        REQUIRE(get(RESTCONF_DATA_ROOT "/example:tlc?filter=/example:tlc/list&fields=list", {}) == Response{400, jsonHeaders, R"({
+  "ietf-restconf:errors": {
+    "error": [
+      {
+        "error-type": "protocol",
+        "error-tag": "invalid-value",
+        "error-message": "Query parameters 'filter' and 'fields' cannot be used together"
+      }
+    ]
+  }
+}
+)"});
+    }
+
     SECTION("OPTIONS method")
     {
         // RPC node
@@ -1280,3 +1376,884 @@ TEST_CASE("reading data")
 )"});
     }
 }
+
+TEST_CASE_FIXTURE(SysrepoFixture, "reading data with multiple server threads")
+{
+    auto server = rousette::restconf::Server{srConn, SERVER_ADDRESS, SERVER_PORT, {.threads = 4}};
+
+    srSess.switchDatastore(sysrepo::Datastore::Operational);
+    srSess.setItem("/ietf-system:system/clock/timezone-utc-offset", "2");
+    srSess.applyChanges();
+    setupRealNacm(srSess);
+
+    // each client opens its own connection, so these requests are spread across all server threads
+    std::vector<std::future<Response>> responses;
+    for (int i = 0; i < 16; ++i) {
+        responses.emplace_back(std::async(std::launch::async, []() {
+            return get(RESTCONF_DATA_ROOT "/ietf-system:system/clock", {AUTH_DWDM});
+        }));
+    }
+
+    for (auto& response : responses) {
+        REQUIRE(response.get() == Response{200, jsonHeaders, R"({
+  "ietf-system:system": {
+    "clock": {
+      "timezone-utc-offset": 2
+    }
+  }
+}
+)"});
+    }
+}
+
+TEST_CASE_FIXTURE(SysrepoFixture, "slow operational data do not block other requests")
+{
+    // a single HTTP thread, all the blocking happens in the worker pool
+    auto server = rousette::restconf::Server{srConn, SERVER_ADDRESS, SERVER_PORT};
+    setupRealNacm(srSess);
+
+    std::promise<void> callbackEntered;
+    std::promise<void> unblock;
+    auto unblocked = unblock.get_future();
+    auto sub = srSess.onOperGet(
+        "example", [&](auto, auto, auto, auto, auto, auto, auto& parent) {
+            callbackEntered.set_value();
+            unblocked.wait();
+            parent->newPath("nonconfig-node", "slow");
+            return sysrepo::ErrorCode::Ok;
+        },
+        "/example:config-nonconfig/nonconfig-node");
+
+    auto slowResponse = std::async(std::launch::async, []() {
+        return get(RESTCONF_DATA_ROOT "/example:config-nonconfig/nonconfig-node", {AUTH_ROOT});
+    });
+    callbackEntered.get_future().wait();
+
+    // the operational callback is still blocked, yet the server keeps answering
+    REQUIRE(get(RESTCONF_ROOT "/yang-library-version", {}) == Response{200, jsonHeaders, R"({
+  "ietf-restconf:yang-library-version": "2019-01-04"
+}
+)"});
+
+    unblock.set_value();
+    REQUIRE(slowResponse.get() == Response{200, jsonHeaders, R"({
+  "example:config-nonconfig": {
+    "nonconfig-node": "slow"
+  }
+}
+)"});
+}
+
+TEST_CASE_FIXTURE(SysrepoFixture, "admission control sheds excess datastore dumps")
+{
+    srSess.setItem("/ietf-system:system/hostname", "ahoj");
+    srSess.applyChanges();
+
+    // with two workers, only one complete datastore can be read at once
+    auto server = rousette::restconf::Server{srConn, SERVER_ADDRESS, SERVER_PORT, {.workerThreads = 2}};
+    setupRealNacm(srSess);
+
+    std::promise<void> callbackEntered;
+    std::promise<void> unblock;
+    auto unblocked = unblock.get_future().share();
+    std::atomic<bool> blocking = true;
+    auto sub = srSess.onOperGet(
+        "example", [&](auto, auto, auto, auto, auto, auto, auto& parent) {
+            if (blocking.exchange(false)) {
+                callbackEntered.set_value();
+                unblocked.wait();
+            }
+            parent->newPath("nonconfig-node", "slow");
+            return sysrepo::ErrorCode::Ok;
+        },
+        "/example:config-nonconfig/nonconfig-node");
+
+    auto dump = std::async(std::launch::async, []() {
+        return get(RESTCONF_DATA_ROOT, {AUTH_ROOT});
+    });
+    callbackEntered.get_future().wait();
+
+    REQUIRE(get(RESTCONF_DATA_ROOT, {AUTH_ROOT}) == Response{503, ng::header_map{
+        {"access-control-allow-origin", {"*", false}},
+        {"content-type", {"application/yang-data+json", false}},
+        {"retry-after", {"1", false}},
+    }, R"({
+  "ietf-restconf:errors": {
+    "error": [
+      {
+        "error-type": "application",
+        "error-tag": "resource-denied",
+        "error-message": "Too many similar requests are being processed, try again later."
+      }
+    ]
+  }
+}
+)"});
+
+    // cheap requests are still served
+    REQUIRE(get(RESTCONF_ROOT_DS("running") "/ietf-system:system/hostname", {AUTH_ROOT}) == Response{200, jsonHeaders, R"({
+  "ietf-system:system": {
+    "hostname": "ahoj"
+  }
+}
+)"});
+
+    unblock.set_value();
+    REQUIRE(dump.get().statusCode == 200);
+
+    // the slot has been released
+    REQUIRE(get(RESTCONF_DATA_ROOT, {AUTH_ROOT}).statusCode == 200);
+}
+
+TEST_CASE_FIXTURE(SysrepoFixture, "admission control does not hold back answers which are cheap to give")
+{
+    srSess.setItem("/ietf-system:system/hostname", "ahoj");
+    srSess.applyChanges();
+
+    // with two workers, only one complete datastore can be read at once
+    auto server = rousette::restconf::Server{srConn, SERVER_ADDRESS, SERVER_PORT, {.workerThreads = 2, .serializerThreads = 0, .cache = {.entityTags = true}}};
+    setupRealNacm(srSess);
+
+    const auto running = get(RESTCONF_ROOT_DS("running"), {AUTH_ROOT});
+    REQUIRE(running.statusCode == 200);
+    const auto etag = running.headers.find("etag")->second.value;
+
+    std::promise<void> callbackEntered;
+    std::promise<void> unblock;
+    auto unblocked = unblock.get_future().share();
+    auto sub = srSess.onOperGet(
+        "example", [&](auto, auto, auto, auto, auto, auto, auto& parent) {
+            callbackEntered.set_value();
+            unblocked.wait();
+            parent->newPath("nonconfig-node", "slow");
+            return sysrepo::ErrorCode::Ok;
+        },
+        "/example:config-nonconfig/nonconfig-node");
+
+    auto dump = std::async(std::launch::async, []() {
+        return get(RESTCONF_DATA_ROOT, {AUTH_ROOT});
+    });
+    callbackEntered.get_future().wait();
+
+    // the client has the current data already, so there is nothing to process
+    REQUIRE(get(RESTCONF_ROOT_DS("running"), {AUTH_ROOT, {"if-none-match", etag}}).statusCode == 304);
+    REQUIRE(get(RESTCONF_ROOT_DS("running"), {AUTH_ROOT}).statusCode == 503);
+
+    unblock.set_value();
+    REQUIRE(dump.get().statusCode == 200);
+}
+
+TEST_CASE_FIXTURE(SysrepoFixture, "request deadlines")
+{
+    auto server = rousette::restconf::Server{srConn, SERVER_ADDRESS, SERVER_PORT};
+    setupRealNacm(srSess);
+
+    std::promise<void> unblock;
+    auto unblocked = unblock.get_future().share();
+    auto sub = srSess.onOperGet(
+        "example", [&](auto, auto, auto, auto, auto, auto, auto& parent) {
+            unblocked.wait();
+            parent->newPath("nonconfig-node", "slow");
+            return sysrepo::ErrorCode::Ok;
+        },
+        "/example:config-nonconfig/nonconfig-node");
+
+    SECTION("invalid header")
+    {
+        REQUIRE(get(RESTCONF_DATA_ROOT "/example:config-nonconfig/nonconfig-node", {AUTH_ROOT, {"request-timeout", "soon"}}) == Response{400, jsonHeaders, R"({
+  "ietf-restconf:errors": {
+    "error": [
+      {
+        "error-type": "protocol",
+        "error-tag": "invalid-value",
+        "error-message": "Invalid request-timeout header."
+      }
+    ]
+  }
+}
+)"});
+    }
+
+    SECTION("slow provider")
+    {
+        REQUIRE(get(RESTCONF_DATA_ROOT "/example:config-nonconfig/nonconfig-node", {AUTH_ROOT, {"request-timeout", "200"}}) == Response{504, jsonHeaders, R"({
+  "ietf-restconf:errors": {
+    "error": [
+      {
+        "error-type": "application",
+        "error-tag": "operation-failed",
+        "error-message": "Request deadline has expired."
+      }
+    ]
+  }
+}
+)"});
+    }
+
+    unblock.set_value();
+}
+
+TEST_CASE_FIXTURE(SysrepoFixture, "parallel serialization yields the same output")
+{
+    srSess.switchDatastore(sysrepo::Datastore::Operational);
+    srSess.setItem("/ietf-system:system/hostname", "parallel");
+    for (int i = 0; i < 100; ++i) {
+        srSess.setItem("/example:ordered-lists/ll[.='" + std::to_string(i) + "']", std::nullopt);
+    }
+    srSess.applyChanges();
+    setupRealNacm(srSess);
+
+    auto fetch = [this](std::size_t serializerThreads, const std::map<std::string, std::string>& headers) {
+        auto server = rousette::restconf::Server{srConn, SERVER_ADDRESS, SERVER_PORT, {.serializerThreads = serializerThreads}};
+        return get(RESTCONF_ROOT_DS("operational"), headers);
+    };
+
+    auto compare = [&]() {
+        for (const auto& headers : {
+                 std::map<std::string, std::string>{AUTH_ROOT},
+                 std::map<std::string, std::string>{AUTH_ROOT, {"accept", "application/yang-data+xml"}},
+             }) {
+            auto serial = fetch(0, headers);
+            REQUIRE(serial.statusCode == 200);
+            REQUIRE(fetch(4, headers) == serial);
+        }
+    };
+
+    compare();
+
+    // several instances of a top-level list cannot be printed separately in JSON
+    srSess.setItem("/example:top-level-list[name='a']", std::nullopt);
+    srSess.setItem("/example:top-level-list[name='b']", std::nullopt);
+    srSess.applyChanges();
+    compare();
+
+    // a single top-level subtree which is much bigger than the HTTP/2 flow control window is split at the list entries
+    for (int i = 100; i < 20000; ++i) {
+        srSess.setItem("/example:ordered-lists/lst[name='" + std::to_string(i) + "']", std::nullopt);
+    }
+    srSess.applyChanges();
+    compare();
+
+    // a client which goes away in the middle of a response
+    {
+        auto server = rousette::restconf::Server{srConn, SERVER_ADDRESS, SERVER_PORT, {.serializerThreads = 2}};
+
+        boost::asio::io_service io;
+        auto client = std::make_shared<ng_client::session>(io, SERVER_ADDRESS, SERVER_PORT);
+        std::size_t received = 0;
+        client->on_connect([&](auto) {
+            boost::system::error_code ec;
+            const ng::header_map headers{{"authorization", {"Basic cm9vdDpzZWtyaXQ=", false}}};
+            auto req = client->submit(ec, "GET", "http://["s + SERVER_ADDRESS + "]:" + SERVER_PORT + RESTCONF_ROOT_DS("operational"), headers);
+            req->on_response([&](const ng_client::response& res) {
+                res.on_data([&](const uint8_t*, std::size_t length) {
+                    if (received == 0 && length > 0) {
+                        client->shutdown();
+                    }
+                    received += length;
+                });
+            });
+        });
+        client->on_error([](const boost::system::error_code&) {});
+        io.run();
+        REQUIRE(received > 0);
+
+        // the rest of the response is thrown away, and the server keeps working
+        REQUIRE(get(RESTCONF_ROOT_DS("operational"), {AUTH_ROOT}).statusCode == 200);
+    }
+}
+
+TEST_CASE_FIXTURE(SysrepoFixture, "mirror of the configuration datastores")
+{
+    srSess.setItem("/ietf-system:system/contact", "contact");
+    srSess.setItem("/ietf-system:system/hostname", "mirrored");
+    srSess.setItem("/ietf-system:system/radius/server[name='a']/udp/address", "1.1.1.1");
+    srSess.setItem("/ietf-system:system/radius/server[name='a']/udp/shared-secret", "shared-secret");
+    srSess.applyChanges();
+    setupRealNacm(srSess);
+
+    auto fetch = [this](bool mirror, const std::string& uri, const std::map<std::string, std::string>& headers) {
+        auto server = rousette::restconf::Server{srConn, SERVER_ADDRESS, SERVER_PORT, {.serializerThreads = 0, .cache = {.datastoreMirror = mirror}}};
+        auto first = get(uri, headers);
+        // the second request is served from the mirror's copy
+        REQUIRE(get(uri, headers) == first);
+        return first;
+    };
+
+    auto compare = [&]() {
+        for (const auto& uri : {
+                 RESTCONF_ROOT_DS("running") "/ietf-system:system"s,
+                 RESTCONF_ROOT_DS("running") "/ietf-system:system/radius/server=a/udp"s,
+                 RESTCONF_ROOT_DS("running") "/ietf-system:system/hostname?with-defaults=report-all"s,
+                 RESTCONF_ROOT_DS("startup") "/ietf-system:system"s,
+             }) {
+            for (const auto& headers : {
+                     std::map<std::string, std::string>{},
+                     std::map<std::string, std::string>{AUTH_DWDM},
+                     std::map<std::string, std::string>{AUTH_ROOT},
+                 }) {
+                CAPTURE(uri);
+                REQUIRE(fetch(true, uri, headers) == fetch(false, uri, headers));
+            }
+        }
+    };
+
+    compare();
+
+    SECTION("changes are picked up")
+    {
+        auto server = rousette::restconf::Server{srConn, SERVER_ADDRESS, SERVER_PORT, {.serializerThreads = 0, .cache = {.datastoreMirror = true}}};
+        REQUIRE(get(RESTCONF_ROOT_DS("running") "/ietf-system:system/hostname", {}) == Response{200, jsonHeaders, R"({
+  "ietf-system:system": {
+    "hostname": "mirrored"
+  }
+}
+)"});
+
+        srSess.setItem("/ietf-system:system/hostname", "changed");
+        srSess.applyChanges();
+        // the notification about the change is delivered asynchronously
+        waitFor([]() {
+            return get(RESTCONF_ROOT_DS("running") "/ietf-system:system/hostname", {}) == Response{200, jsonHeaders, R"({
+  "ietf-system:system": {
+    "hostname": "changed"
+  }
+}
+)"};
+        });
+
+        // edits made through rousette are visible as soon as they are acknowledged
+        REQUIRE(put(RESTCONF_ROOT_DS("running") "/ietf-system:system/hostname", {AUTH_ROOT, CONTENT_TYPE_JSON}, R"({"ietf-system:hostname": "edited"}")") == Response{204, noContentTypeHeaders, ""});
+        REQUIRE(get(RESTCONF_ROOT_DS("running") "/ietf-system:system/hostname", {}) == Response{200, jsonHeaders, R"({
+  "ietf-system:system": {
+    "hostname": "edited"
+  }
+}
+)"});
+
+        // NACM changes apply to the data which have been mirrored already
+        srSess.setItem("/ietf-netconf-acm:nacm/rule-list[name='anon rule']/rule[name='11']/action", "deny");
+        srSess.applyChanges();
+        waitFor([]() {
+            return get(RESTCONF_ROOT_DS("running") "/ietf-system:system/hostname", {}).statusCode == 404;
+        });
+    }
+}
+
+TEST_CASE_FIXTURE(SysrepoFixture, "response cache")
+{
+    srSess.setItem("/ietf-system:system/contact", "contact");
+    srSess.setItem("/ietf-system:system/hostname", "cached");
+    srSess.setItem("/ietf-system:system/radius/server[name='a']/udp/address", "1.1.1.1");
+    srSess.setItem("/ietf-system:system/radius/server[name='a']/udp/shared-secret", "shared-secret");
+    srSess.applyChanges();
+    setupRealNacm(srSess);
+
+    auto server = rousette::restconf::Server{srConn, SERVER_ADDRESS, SERVER_PORT, {.serializerThreads = 0, .cache = {.responseCacheSize = 1024 * 1024}}};
+
+    auto stats = [](const std::string& hits, const std::string& misses) {
+        auto resp = get(RESTCONF_DATA_ROOT "/rousette:response-cache", {AUTH_ROOT});
+        REQUIRE(resp.statusCode == 200);
+        REQUIRE(resp.data.find(R"("hits": ")" + hits + R"(")") != std::string::npos);
+        REQUIRE(resp.data.find(R"("misses": ")" + misses + R"(")") != std::string::npos);
+    };
+
+    const auto anonymous = get(RESTCONF_ROOT_DS("running") "/ietf-system:system", {});
+    REQUIRE(anonymous == Response{200, jsonHeaders, R"({
+  "ietf-system:system": {
+    "contact": "contact",
+    "hostname": "cached"
+  }
+}
+)"});
+    const auto dwdm = get(RESTCONF_ROOT_DS("running") "/ietf-system:system", {AUTH_DWDM});
+    REQUIRE(dwdm.statusCode == 200);
+    REQUIRE(dwdm.data.find("shared-secret") != std::string::npos);
+    stats("0", "2");
+
+    // users in different NACM groups get different responses
+    REQUIRE(get(RESTCONF_ROOT_DS("running") "/ietf-system:system", {}) == anonymous);
+    REQUIRE(get(RESTCONF_ROOT_DS("running") "/ietf-system:system", {AUTH_DWDM}) == dwdm);
+    stats("2", "2");
+
+    // the encoding and the query parameters are a part of the key
+    REQUIRE(get(RESTCONF_ROOT_DS("running") "/ietf-system:system", {{"accept", "application/yang-data+xml"}}).statusCode == 200);
+    REQUIRE(get(RESTCONF_ROOT_DS("running") "/ietf-system:system?depth=1", {}).statusCode == 200);
+    stats("2", "4");
+
+    // operational data are never cached
+    REQUIRE(get(RESTCONF_DATA_ROOT "/ietf-system:system", {AUTH_DWDM}).statusCode == 200);
+    stats("2", "4");
+
+    srSess.setItem("/ietf-system:system/hostname", "changed");
+    srSess.applyChanges();
+    // the notification about the change is delivered asynchronously, and until then the old response might be served
+    int staleHits = 0;
+    waitFor([&staleHits]() {
+        if (get(RESTCONF_ROOT_DS("running") "/ietf-system:system", {}) == Response{200, jsonHeaders, R"({
+  "ietf-system:system": {
+    "contact": "contact",
+    "hostname": "changed"
+  }
+}
+)"}) {
+            return true;
+        }
+        ++staleHits;
+        return false;
+    });
+    stats(std::to_string(2 + staleHits), "5");
+
+    // edits made through rousette are visible as soon as they are acknowledged
+    REQUIRE(put(RESTCONF_ROOT_DS("running") "/ietf-system:system/hostname", {AUTH_ROOT, CONTENT_TYPE_JSON}, R"({"ietf-system:hostname": "edited"}")") == Response{204, noContentTypeHeaders, ""});
+    REQUIRE(get(RESTCONF_ROOT_DS("running") "/ietf-system:system", {}) == Response{200, jsonHeaders, R"({
+  "ietf-system:system": {
+    "contact": "contact",
+    "hostname": "edited"
+  }
+}
+)"});
+    stats(std::to_string(2 + staleHits), "6");
+}
+
+TEST_CASE_FIXTURE(SysrepoFixture, "caching of operational data")
+{
+    const auto timeToLive = std::chrono::milliseconds{300};
+    std::atomic<int> calls{0};
+    std::promise<void> unblock;
+    auto unblocked = unblock.get_future().share();
+    auto sub = srSess.onOperGet(
+        "example", [&](auto, auto, auto, auto, auto, auto, auto& parent) {
+            const auto call = ++calls;
+            if (call == 4) {
+                // the background refresh of the stale data, which waits until the test has seen what is served meanwhile
+                unblocked.wait();
+            }
+            parent->newPath("nonconfig-node", std::to_string(call));
+            return sysrepo::ErrorCode::Ok;
+        },
+        "/example:config-nonconfig/nonconfig-node");
+
+    srSess.setItem("/rousette:operational-cache/policy[path='/example:config-nonconfig/nonconfig-node']/ttl", std::to_string(timeToLive.count()));
+    srSess.applyChanges();
+    setupRealNacm(srSess);
+
+    auto server = rousette::restconf::Server{srConn, SERVER_ADDRESS, SERVER_PORT, {.serializerThreads = 0, .cache = {.responseCacheSize = 1024 * 1024}}};
+
+    auto reading = [](const std::string& value) {
+        return Response{200, jsonHeaders, R"({
+  "example:config-nonconfig": {
+    "nonconfig-node": ")" + value + R"("
+  }
+}
+)"};
+    };
+
+    REQUIRE(get(RESTCONF_DATA_ROOT "/example:config-nonconfig/nonconfig-node", {}) == reading("1"));
+    REQUIRE(get(RESTCONF_DATA_ROOT "/example:config-nonconfig/nonconfig-node", {}) == reading("1"));
+    REQUIRE(calls == 1);
+
+    // paths without a policy are not cached
+    REQUIRE(get(RESTCONF_DATA_ROOT "/example:config-nonconfig", {}).statusCode == 200);
+    REQUIRE(calls == 2);
+
+    // clients can ask for fresh data, and these replace the cached ones
+    REQUIRE(get(RESTCONF_DATA_ROOT "/example:config-nonconfig/nonconfig-node", {{"cache-control", "no-cache"}}) == reading("3"));
+    REQUIRE(get(RESTCONF_DATA_ROOT "/example:config-nonconfig/nonconfig-node", {}) == reading("3"));
+    REQUIRE(calls == 3);
+
+    // once the TTL expires, the stale data are served while they are being refreshed
+    waitFor([&]() {
+        REQUIRE(get(RESTCONF_DATA_ROOT "/example:config-nonconfig/nonconfig-node", {}) == reading("3"));
+        return calls == 4;
+    });
+    REQUIRE(get(RESTCONF_DATA_ROOT "/example:config-nonconfig/nonconfig-node", {}) == reading("3"));
+    REQUIRE(calls == 4);
+    unblock.set_value();
+    waitFor([&]() {
+        return get(RESTCONF_DATA_ROOT "/example:config-nonconfig/nonconfig-node", {}) == reading("4");
+    });
+    const auto refreshed = std::chrono::steady_clock::now();
+
+    // data which have been stale for too long are not served at all; nothing but the clock can tell when that is
+    std::this_thread::sleep_until(refreshed + 2 * timeToLive);
+    REQUIRE(get(RESTCONF_DATA_ROOT "/example:config-nonconfig/nonconfig-node", {}) == reading("5"));
+}
+
+namespace {
+/** @short Counts the log messages which contain some text */
+class LogWatcher : public spdlog::sinks::base_sink<std::mutex> {
+public:
+    explicit LogWatcher(const std::string& needle)
+        : m_needle(needle)
+    {
+    }
+
+    std::atomic<int> seen{0};
+
+protected:
+    void sink_it_(const spdlog::details::log_msg& msg) override
+    {
+        if (std::string_view{msg.payload.data(), msg.payload.size()}.find(m_needle) != std::string_view::npos) {
+            ++seen;
+        }
+    }
+
+    void flush_() override
+    {
+    }
+
+private:
+    std::string m_needle;
+};
+
+UniqueResource watchLog(const std::shared_ptr<LogWatcher>& watcher)
+{
+    return make_unique_resource(
+        [watcher]() { spdlog::default_logger()->sinks().push_back(watcher); },
+        [watcher]() { std::erase(spdlog::default_logger()->sinks(), watcher); });
+}
+}
+
+TEST_CASE_FIXTURE(SysrepoFixture, "coalescing of identical reads")
+{
+    // the server logs each request which waits for an identical one
+    auto waiting = std::make_shared<LogWatcher>("Waiting for an identical request which is in progress");
+    auto logGuard = watchLog(waiting);
+
+    std::atomic<int> calls{0};
+    std::atomic<bool> failNext{false};
+    std::shared_future<void> released;
+    auto sub = srSess.onOperGet(
+        "example", [&](auto, auto, auto, auto, auto, auto, auto& parent) {
+            parent->newPath("nonconfig-node", std::to_string(++calls));
+            released.wait();
+            return failNext.exchange(false) ? sysrepo::ErrorCode::OperationFailed : sysrepo::ErrorCode::Ok;
+        },
+        "/example:config-nonconfig/nonconfig-node");
+    setupRealNacm(srSess);
+
+    auto server = rousette::restconf::Server{srConn, SERVER_ADDRESS, SERVER_PORT, {.serializerThreads = 0, .cache = {.coalesceReads = true}}};
+
+    // the first request is the one which does the work, and the operational callbacks do not return until all of the
+    // requests have either reached them, or started waiting for an identical request
+    auto readConcurrently = [&](const std::vector<std::map<std::string, std::string>>& headers, const int leaders) {
+        std::promise<void> release;
+        released = release.get_future().share();
+        const int callsBefore = calls;
+        const int waitingBefore = waiting->seen;
+
+        std::vector<std::thread> clients;
+        std::vector<Response> responses(headers.size(), Response{0, Response::Headers{}, ""});
+        auto startClient = [&](const std::size_t i) {
+            clients.emplace_back([&responses, &headers, i]() {
+                responses[i] = get(RESTCONF_DATA_ROOT "/example:config-nonconfig/nonconfig-node", headers[i]);
+            });
+        };
+        startClient(0);
+        waitFor([&]() { return calls == callsBefore + 1; });
+        for (std::size_t i = 1; i < responses.size(); ++i) {
+            startClient(i);
+        }
+        waitFor([&]() { return calls == callsBefore + leaders && waiting->seen == waitingBefore + static_cast<int>(headers.size()) - leaders; });
+
+        release.set_value();
+        for (auto& client : clients) {
+            client.join();
+        }
+        return responses;
+    };
+
+    auto responses = readConcurrently(std::vector<std::map<std::string, std::string>>(5), 1);
+    REQUIRE(calls == 1);
+    for (const auto& response : responses) {
+        REQUIRE(response == Response{200, jsonHeaders, R"({
+  "example:config-nonconfig": {
+    "nonconfig-node": "1"
+  }
+}
+)"});
+    }
+
+    // nothing is remembered once the requests are done
+    REQUIRE(get(RESTCONF_DATA_ROOT "/example:config-nonconfig/nonconfig-node", {}).statusCode == 200);
+    REQUIRE(calls == 2);
+
+    // requests with different encodings do not share their responses
+    responses = readConcurrently({
+        std::map<std::string, std::string>{{"accept", "application/yang-data+json"}},
+        std::map<std::string, std::string>{{"accept", "application/yang-data+xml"}},
+    }, 2);
+    REQUIRE(responses[0].statusCode == 200);
+    REQUIRE(responses[1].statusCode == 200);
+    REQUIRE(calls == 4);
+
+    // when the leader fails, the waiting requests get the very same error instead of trying again one after another
+    failNext = true;
+    responses = readConcurrently(std::vector<std::map<std::string, std::string>>(5), 1);
+    REQUIRE(calls == 5);
+    REQUIRE(responses[0].statusCode == 500);
+    for (const auto& response : responses) {
+        REQUIRE(response == responses[0]);
+    }
+}
+
+TEST_CASE_FIXTURE(SysrepoFixture, "entity tags")
+{
+    srSess.setItem("/ietf-system:system/contact", "contact");
+    srSess.setItem("/ietf-system:system/hostname", "tagged");
+    srSess.applyChanges();
+    setupRealNacm(srSess);
+
+    auto server = rousette::restconf::Server{srConn, SERVER_ADDRESS, SERVER_PORT, {.serializerThreads = 0, .cache = {.entityTags = true}}};
+
+    auto header = [](const Response& resp, const std::string& name) -> std::string {
+        auto it = resp.headers.find(name);
+        REQUIRE(it != resp.headers.end());
+        return it->second.value;
+    };
+
+    const auto first = get(RESTCONF_ROOT_DS("running") "/ietf-system:system", {});
+    const auto firstRead = std::chrono::floor<std::chrono::seconds>(std::chrono::system_clock::now());
+    REQUIRE(first.statusCode == 200);
+    const auto etag = header(first, "etag");
+    const auto lastModified = header(first, "last-modified");
+    REQUIRE(etag.starts_with("\""));
+    REQUIRE(etag.ends_with("\""));
+
+    // the same representation has the same tag
+    REQUIRE(header(get(RESTCONF_ROOT_DS("running") "/ietf-system:system", {}), "etag") == etag);
+
+    // different representations have different tags
+    REQUIRE(header(get(RESTCONF_ROOT_DS("running") "/ietf-system:system", {{"accept", "application/yang-data+xml"}}), "etag") != etag);
+    REQUIRE(header(get(RESTCONF_ROOT_DS("running") "/ietf-system:system?depth=1", {}), "etag") != etag);
+    REQUIRE(header(get(RESTCONF_ROOT_DS("running") "/ietf-system:system", {AUTH_DWDM}), "etag") != etag);
+
+    // operational data can change at any time, so there are no validators
+    REQUIRE(get(RESTCONF_DATA_ROOT "/ietf-system:system", {}).headers.count("etag") == 0);
+
+    // conditional reads
+    const Response notModified{304, Response::Headers{{"access-control-allow-origin", "*"}, {"etag", etag}, {"last-modified", lastModified}}, ""};
+    REQUIRE(get(RESTCONF_ROOT_DS("running") "/ietf-system:system", {{"if-none-match", etag}}) == notModified);
+    REQUIRE(get(RESTCONF_ROOT_DS("running") "/ietf-system:system", {{"if-none-match", "\"other\", W/" + etag}}) == notModified);
+    REQUIRE(get(RESTCONF_ROOT_DS("running") "/ietf-system:system", {{"if-modified-since", lastModified}}) == notModified);
+    REQUIRE(get(RESTCONF_ROOT_DS("running") "/ietf-system:system", {{"if-none-match", "\"other\""}}).statusCode == 200);
+    REQUIRE(get(RESTCONF_ROOT_DS("running") "/ietf-system:system", {{"if-modified-since", "Sun, 06 Nov 1994 08:49:37 GMT"}}).statusCode == 200);
+    // If-None-Match takes precedence
+    REQUIRE(get(RESTCONF_ROOT_DS("running") "/ietf-system:system", {{"if-none-match", "\"other\""}, {"if-modified-since", lastModified}}).statusCode == 200);
+
+    // Last-Modified has a resolution of one second
+    waitFor([firstRead]() { return std::chrono::floor<std::chrono::seconds>(std::chrono::system_clock::now()) > firstRead; });
+    srSess.setItem("/ietf-system:system/hostname", "changed");
+    srSess.applyChanges();
+    // the notification about the change is delivered asynchronously
+    waitFor([&etag]() {
+        return get(RESTCONF_ROOT_DS("running") "/ietf-system:system", {{"if-none-match", etag}}).statusCode == 200;
+    });
+
+    const auto changed = get(RESTCONF_ROOT_DS("running") "/ietf-system:system", {{"if-none-match", etag}});
+    REQUIRE(changed.statusCode == 200);
+    REQUIRE(changed.data.find("changed") != std::string::npos);
+    REQUIRE(header(changed, "etag") != etag);
+    REQUIRE(header(changed, "last-modified") != lastModified);
+    REQUIRE(get(RESTCONF_ROOT_DS("running") "/ietf-system:system", {{"if-modified-since", lastModified}}).statusCode == 200);
+
+    // changes of other modules do not matter; the notifications of all modules are delivered in order, so once the
+    // tag of the whole datastore changes, the change has been processed
+    const auto datastoreTag = header(get(RESTCONF_ROOT_DS("running"), {AUTH_ROOT}), "etag");
+    srSess.setItem("/example:top-level-leaf", "something");
+    srSess.applyChanges();
+    waitFor([&datastoreTag]() {
+        return get(RESTCONF_ROOT_DS("running"), {AUTH_ROOT, {"if-none-match", datastoreTag}}).statusCode == 200;
+    });
+    REQUIRE(get(RESTCONF_ROOT_DS("running") "/ietf-system:system", {{"if-none-match", header(changed, "etag")}}).statusCode == 304);
+}
+
+namespace {
+std::string inflate(const std::string& data)
+{
+    z_stream stream{};
+    REQUIRE(inflateInit2(&stream, 15 + 32 /* detect zlib or gzip */) == Z_OK);
+    stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.data()));
+    stream.avail_in = data.size();
+    std::string res;
+    std::array<char, 4096> buf;
+    int ret;
+    do {
+        stream.next_out = reinterpret_cast<Bytef*>(buf.data());
+        stream.avail_out = buf.size();
+        ret = ::inflate(&stream, Z_NO_FLUSH);
+        res.append(buf.data(), buf.size() - stream.avail_out);
+    } while (ret == Z_OK);
+    inflateEnd(&stream);
+    REQUIRE(ret == Z_STREAM_END);
+    return res;
+}
+}
+
+TEST_CASE_FIXTURE(SysrepoFixture, "compact and compressed output")
+{
+    srSess.setItem("/ietf-system:system/hostname", "compact");
+    srSess.applyChanges();
+    setupRealNacm(srSess);
+
+    auto server = rousette::restconf::Server{srConn, SERVER_ADDRESS, SERVER_PORT, {.serializerThreads = 0, .output = {.compact = true, .compressionThreshold = 200}}};
+
+    const std::string compact = R"({"ietf-system:system":{"hostname":"compact"}})";
+    REQUIRE(get(RESTCONF_ROOT_DS("running") "/ietf-system:system/hostname", {AUTH_ROOT}) == Response{200, jsonHeaders, compact});
+    REQUIRE(get(RESTCONF_ROOT_DS("running") "/ietf-system:system/hostname?pretty=false", {AUTH_ROOT}) == Response{200, jsonHeaders, compact});
+    REQUIRE(get(RESTCONF_ROOT_DS("running") "/ietf-system:system/hostname?pretty=true", {AUTH_ROOT}) == Response{200, jsonHeaders, R"({
+  "ietf-system:system": {
+    "hostname": "compact"
+  }
+}
+)"});
+    REQUIRE(get(RESTCONF_ROOT_DS("running") "/ietf-system:system/hostname?pretty=yes", {AUTH_ROOT}).statusCode == 400);
+
+    // small responses are not worth compressing, so they do not depend on the client's preferences
+    REQUIRE(get(RESTCONF_ROOT_DS("running") "/ietf-system:system/hostname", {AUTH_ROOT, {"accept-encoding", "gzip"}}) == Response{200, jsonHeaders, compact});
+
+    // big ones would be compressed for another client, and caches have to know that
+    const auto plain = get(RESTCONF_ROOT_DS("running"), {AUTH_ROOT});
+    REQUIRE(plain.statusCode == 200);
+    REQUIRE(plain.data.size() > 200);
+    REQUIRE(plain.headers.count("content-encoding") == 0);
+    REQUIRE(plain.headers.find("vary") != plain.headers.end());
+    REQUIRE(plain.headers.find("vary")->second.value == "accept-encoding");
+
+    for (const auto& [acceptEncoding, contentEncoding] : {
+             std::pair<std::string, std::string>{"gzip", "gzip"},
+             {"deflate", "deflate"},
+             {"gzip;q=0.5, deflate", "deflate"},
+             {"br, zstd", "zstd"},
+         }) {
+        CAPTURE(acceptEncoding);
+        auto resp = get(RESTCONF_ROOT_DS("running"), {AUTH_ROOT, {"accept-encoding", acceptEncoding}});
+        REQUIRE(resp.statusCode == 200);
+        REQUIRE(resp.headers.find("content-encoding") != resp.headers.end());
+        REQUIRE(resp.headers.find("content-encoding")->second.value == contentEncoding);
+        REQUIRE(resp.data != plain.data);
+        if (contentEncoding != "zstd") {
+            REQUIRE(inflate(resp.data) == plain.data);
+        }
+    }
+
+    // no compression for clients which do not support any of the codings
+    REQUIRE(get(RESTCONF_ROOT_DS("running"), {AUTH_ROOT, {"accept-encoding", "br, identity"}}) == plain);
+
+    auto schema = get(YANG_ROOT "/ietf-system@2014-08-06", {AUTH_ROOT, {"accept-encoding", "gzip"}});
+    REQUIRE(schema.statusCode == 200);
+    REQUIRE(schema.headers.find("content-encoding")->second.value == "gzip");
+    REQUIRE(inflate(schema.data) == get(YANG_ROOT "/ietf-system@2014-08-06", {AUTH_ROOT}).data);
+}
+
+TEST_CASE_FIXTURE(SysrepoFixture, "list pagination")
+{
+    for (const auto& name : {"a", "b", "c", "d", "e"}) {
+        srSess.setItem("/example:ordered-lists/lst[name='"s + name + "']", std::nullopt);
+    }
+    srSess.setItem("/example:tlc/list[name='x']/choice1", "c1");
+    for (const auto& value : {"1", "2", "3"}) {
+        srSess.setItem("/example:tlc/list[name='x']/collection[.='"s + value + "']", std::nullopt);
+    }
+    srSess.applyChanges();
+    setupRealNacm(srSess);
+
+    auto server = rousette::restconf::Server{srConn, SERVER_ADDRESS, SERVER_PORT, {.serializerThreads = 0, .output = {.compact = true}}};
+
+    auto withLink = [](const std::string& next) {
+        auto headers = jsonHeaders;
+        headers.emplace("link", ng::header_value{"<?" + next + ">; rel=\"next\"", false});
+        return headers;
+    };
+    auto lst = [](const std::vector<std::string>& names) {
+        std::string res;
+        for (const auto& name : names) {
+            res += (res.empty() ? "" : ",") + R"({"name":")"s + name + R"("})";
+        }
+        return R"({"example:ordered-lists":{"lst":[)" + res + "]}}";
+    };
+
+    // the cursor refers to the last entry of the previous page, it is just the hex-encoded key
+    REQUIRE(get(RESTCONF_ROOT_DS("running") "/example:ordered-lists/lst?limit=2", {AUTH_ROOT}) == Response{200, withLink("limit=2&cursor=62"), lst({"a", "b"})});
+    REQUIRE(get(RESTCONF_ROOT_DS("running") "/example:ordered-lists/lst?limit=2&cursor=62", {AUTH_ROOT}) == Response{200, withLink("limit=2&cursor=64"), lst({"c", "d"})});
+    REQUIRE(get(RESTCONF_ROOT_DS("running") "/example:ordered-lists/lst?limit=2&cursor=64", {AUTH_ROOT}) == Response{200, jsonHeaders, lst({"e"})});
+    REQUIRE(get(RESTCONF_ROOT_DS("running") "/example:ordered-lists/lst?offset=1&limit=3", {AUTH_ROOT}) == Response{200, withLink("limit=3&cursor=64"), lst({"b", "c", "d"})});
+    REQUIRE(get(RESTCONF_ROOT_DS("running") "/example:ordered-lists/lst?offset=3", {AUTH_ROOT}) == Response{200, jsonHeaders, lst({"d", "e"})});
+    REQUIRE(get(RESTCONF_ROOT_DS("running") "/example:ordered-lists/lst?limit=unbounded", {AUTH_ROOT}) == Response{200, jsonHeaders, lst({"a", "b", "c", "d", "e"})});
+
+    // going backwards, the entries are still in the order of the list
+    REQUIRE(get(RESTCONF_ROOT_DS("running") "/example:ordered-lists/lst?direction=backwards&limit=2", {AUTH_ROOT}) == Response{200, withLink("direction=backwards&limit=2&cursor=64"), lst({"d", "e"})});
+    REQUIRE(get(RESTCONF_ROOT_DS("running") "/example:ordered-lists/lst?direction=backwards&limit=2&cursor=64", {AUTH_ROOT}) == Response{200, withLink("direction=backwards&limit=2&cursor=62"), lst({"b", "c"})});
+    REQUIRE(get(RESTCONF_ROOT_DS("running") "/example:ordered-lists/lst?direction=backwards&limit=2&cursor=62", {AUTH_ROOT}) == Response{200, jsonHeaders, lst({"a"})});
+
+    // a cursor stays valid when entries before it go away
+    srSess.deleteItem("/example:ordered-lists/lst[name='a']");
+    srSess.applyChanges();
+    REQUIRE(get(RESTCONF_ROOT_DS("running") "/example:ordered-lists/lst?limit=2&cursor=62", {AUTH_ROOT}) == Response{200, withLink("limit=2&cursor=64"), lst({"c", "d"})});
+
+    REQUIRE(get(RESTCONF_ROOT_DS("running") "/example:ordered-lists/lst?limit=2&cursor=7a", {AUTH_ROOT}) == Response{400, jsonHeaders, R"({
+  "ietf-restconf:errors": {
+    "error": [
+      {
+        "error-type": "protocol",
+        "error-tag": "invalid-value",
+        "error-message": "The list entry at the cursor does not exist"
+      }
+    ]
+  }
+}
+)"});
+    REQUIRE(get(RESTCONF_ROOT_DS("running") "/example:ordered-lists/lst?limit=2&cursor=6", {AUTH_ROOT}) == Response{400, jsonHeaders, R"({
+  "ietf-restconf:errors": {
+    "error": [
+      {
+        "error-type": "protocol",
+        "error-tag": "invalid-value",
+        "error-message": "Invalid cursor"
+      }
+    ]
+  }
+}
+)"});
+    REQUIRE(get(RESTCONF_ROOT_DS("running") "/example:ordered-lists/lst?offset=10", {AUTH_ROOT}) == Response{400, jsonHeaders, R"({
+  "ietf-restconf:errors": {
+    "error": [
+      {
+        "error-type": "protocol",
+        "error-tag": "invalid-value",
+        "error-message": "Offset is out of range"
+      }
+    ]
+  }
+}
+)"});
+    // a cursor already says where the page starts
+    REQUIRE(get(RESTCONF_ROOT_DS("running") "/example:ordered-lists/lst?offset=1&cursor=62", {AUTH_ROOT}) == Response{400, jsonHeaders, R"({
+  "ietf-restconf:errors": {
+    "error": [
+      {
+        "error-type": "protocol",
+        "error-tag": "invalid-value",
+        "error-message": "Query parameters 'offset' and 'cursor' cannot be used together"
+      }
+    ]
+  }
+}
+)"});
+    REQUIRE(get(RESTCONF_ROOT_DS("running") "/example:ordered-lists/lst?sort-by=name", {AUTH_ROOT}) == Response{501, jsonHeaders, R"({
+  "ietf-restconf:errors": {
+    "error": [
+      {
+        "error-type": "application",
+        "error-tag": "operation-not-supported",
+        "error-message": "Sorting of list entries is not supported"
+      }
+    ]
+  }
+}
+)"});
+
+    REQUIRE(get(RESTCONF_ROOT_DS("running") "/example:tlc/list=x?sublist-limit=2", {AUTH_ROOT}) == Response{200, jsonHeaders, R"({"example:tlc":{"list":[{"name":"x","collection":[1,2],"choice1":"c1"}]}})"});
+    REQUIRE(get(RESTCONF_ROOT_DS("running") "/example:tlc/list?limit=1&sublist-limit=1", {AUTH_ROOT}) == Response{200, jsonHeaders, R"({"example:tlc":{"list":[{"name":"x","collection":[1],"choice1":"c1"}]}})"});
+}
@@ -82,7 +82,7 @@ TEST_CASE("invoking actions and rpcs")
     {
         SECTION("JSON")
         {
-            REQUIRE(get(RESTCONF_OPER_ROOT, {AUTH_ROOT}) == Response{200, jsonHeaders, R"({
+            REQUIRE(get(RESTCONF_OPER_ROOT, {AUTH_ROOT}) == Response{200, jsonVaryHeaders, R"({
   "ietf-restconf:restconf": {
     "operations": {
       "ietf-factory-default:factory-reset": [null],
@@ -105,7 +105,9 @@ TEST_CASE("invoking actions and rpcs")
       "example:test-rpc": [null],
       "example:test-rpc-no-output": [null],
       "example:test-rpc-no-input": [null],
-      "example:test-rpc-no-input-no-output": [null]
+      "example:test-rpc-no-input-no-output": [null],
+      "rousette:changes-since": [null],
+      "rousette:bulk-read": [null]
     }
   }
 }
@@ -115,7 +117,7 @@ TEST_CASE("invoking actions and rpcs")
         SECTION("XML")
         {
             REQUIRE(get(RESTCONF_OPER_ROOT, {AUTH_ROOT, CONTENT_TYPE_XML})
-                    == Response{200, xmlHeaders,
+                    == Response{200, xmlVaryHeaders,
                                 R"(<restconf xmlns="urn:ietf:params:xml:ns:yang:ietf-restconf">
   <operations>
     <factory-reset xmlns="urn:ietf:params:xml:ns:yang:ietf-factory-default"/>
@@ -139,6 +141,8 @@ TEST_CASE("invoking actions and rpcs")
     <test-rpc-no-output xmlns="http://example.tld/example"/>
     <test-rpc-no-input xmlns="http://example.tld/example"/>
     <test-rpc-no-input-no-output xmlns="http://example.tld/example"/>
+    <changes-since xmlns="urn:cesnet:params:xml:ns:yang:czechlight:rousette"/>
+    <bulk-read xmlns="urn:cesnet:params:xml:ns:yang:czechlight:rousette"/>
   </operations>
 </restconf>
 )"});
@@ -437,6 +441,459 @@ TEST_CASE("invoking actions and rpcs")
     ]
   }
 }
+)"});
+
+        // the change journal is not enabled
+        REQUIRE(post(RESTCONF_OPER_ROOT "/rousette:changes-since", {AUTH_ROOT, CONTENT_TYPE_JSON}, R"({"rousette:input": {}})") == Response{501, jsonHeaders, R"({
+  "ietf-restconf:errors": {
+    "error": [
+      {
+        "error-type": "application",
+        "error-tag": "operation-not-supported",
+        "error-path": "/rousette:changes-since",
+        "error-message": "Unsupported RPC call to /rousette:changes-since"
+      }
+    ]
+  }
+}
 )"});
     }
 }
+
+TEST_CASE("change journal")
+{
+    spdlog::set_level(spdlog::level::trace);
+    sysrepo::setGlobalContextOptions(sysrepo::ContextFlags::LibYangPrivParsed | sysrepo::ContextFlags::NoPrinted, sysrepo::GlobalContextEffect::Immediate);
+    auto srConn = sysrepo::Connection{};
+    auto srSess = srConn.sessionStart(sysrepo::Datastore::Running);
+    srSess.sendRPC(srSess.getContext().newPath("/ietf-factory-default:factory-reset"));
+    auto nacmGuard = manageNacm(srSess);
+    setupRealNacm(srSess);
+
+    auto server = rousette::restconf::Server{srConn, SERVER_ADDRESS, SERVER_PORT, {.serializerThreads = 0, .cache = {.changeJournalSize = 3}}};
+
+    auto changesSince = [](const std::optional<std::string>& revision) {
+        return post(RESTCONF_OPER_ROOT "/rousette:changes-since", {AUTH_ROOT, CONTENT_TYPE_JSON},
+                    revision ? R"({"rousette:input": {"revision": ")" + *revision + R"("}})" : R"({"rousette:input": {}})");
+    };
+    auto revisionOf = [](const Response& resp) {
+        REQUIRE(resp.statusCode == 200);
+        const std::string key = R"("revision": ")";
+        auto begin = resp.data.find(key);
+        REQUIRE(begin != std::string::npos);
+        begin += key.size();
+        return resp.data.substr(begin, resp.data.find('"', begin) - begin);
+    };
+    auto commit = [&]() {
+        const auto before = revisionOf(changesSince(std::nullopt));
+        srSess.applyChanges();
+        // the journal learns about changes asynchronously
+        waitFor([&]() { return revisionOf(changesSince(std::nullopt)) != before; });
+    };
+    const std::string gone = R"({
+  "ietf-restconf:errors": {
+    "error": [
+      {
+        "error-type": "application",
+        "error-tag": "operation-failed",
+        "error-message": "Changes since this revision are not known; the data have to be read again."
+      }
+    ]
+  }
+}
+)";
+
+    // the operation is not permitted unless there is an explicit NACM rule
+    REQUIRE(post(RESTCONF_OPER_ROOT "/rousette:changes-since", {AUTH_DWDM, CONTENT_TYPE_JSON}, R"({"rousette:input": {}})").statusCode == 403);
+
+    const auto initial = revisionOf(changesSince(std::nullopt));
+    REQUIRE(changesSince(initial) == Response{200, jsonHeaders, R"({
+  "rousette:output": {
+    "revision": ")" + initial + R"("
+  }
+}
+)"});
+
+    srSess.setItem("/ietf-system:system/hostname", "first");
+    commit();
+    auto resp = changesSince(initial);
+    const auto afterCreate = revisionOf(resp);
+    REQUIRE(afterCreate != initial);
+    REQUIRE(resp == Response{200, jsonHeaders, R"({
+  "rousette:output": {
+    "revision": ")" + afterCreate + R"(",
+    "edit": [
+      {
+        "edit-id": "1",
+        "operation": "create",
+        "target": "/ietf-system:system/hostname",
+        "value": {
+          "ietf-system:hostname": "first"
+        }
+      }
+    ]
+  }
+}
+)"});
+
+    srSess.setItem("/ietf-system:system/hostname", "second");
+    srSess.setItem("/ietf-system:system/radius/server[name='a b']/udp/address", "1.1.1.1");
+    srSess.setItem("/ietf-system:system/radius/server[name='a b']/udp/shared-secret", "secret");
+    commit();
+    resp = changesSince(afterCreate);
+    REQUIRE(resp == Response{200, jsonHeaders, R"({
+  "rousette:output": {
+    "revision": ")" + revisionOf(resp) + R"(",
+    "edit": [
+      {
+        "edit-id": "2",
+        "operation": "replace",
+        "target": "/ietf-system:system/hostname",
+        "value": {
+          "ietf-system:hostname": "second"
+        }
+      },
+      {
+        "edit-id": "3",
+        "operation": "create",
+        "target": "/ietf-system:system/radius/server=a%20b",
+        "value": {
+          "ietf-system:server": [
+            {
+              "name": "a b",
+              "udp": {
+                "address": "1.1.1.1",
+                "shared-secret": "secret"
+              }
+            }
+          ]
+        }
+      }
+    ]
+  }
+}
+)"});
+
+    // the edits of other datastores are not included
+    REQUIRE(post(RESTCONF_OPER_ROOT "/rousette:changes-since", {AUTH_ROOT, CONTENT_TYPE_JSON}, R"({"rousette:input": {"datastore": "startup", "revision": ")" + initial + R"("}})") == Response{200, jsonHeaders, R"({
+  "rousette:output": {
+    "revision": ")" + revisionOf(resp) + R"("
+  }
+}
+)"});
+
+    srSess.deleteItem("/ietf-system:system/radius/server[name='a b']");
+    commit();
+    resp = changesSince(revisionOf(resp));
+    REQUIRE(resp == Response{200, jsonHeaders, R"({
+  "rousette:output": {
+    "revision": ")" + revisionOf(resp) + R"(",
+    "edit": [
+      {
+        "edit-id": "4",
+        "operation": "delete",
+        "target": "/ietf-system:system/radius/server=a%20b"
+      }
+    ]
+  }
+}
+)"});
+
+    // only the three most recent edits are remembered
+    REQUIRE(changesSince(initial) == Response{410, jsonHeaders, gone});
+    REQUIRE(changesSince(afterCreate).statusCode == 200);
+
+    // revisions of some other journal
+    REQUIRE(changesSince("0-1") == Response{410, jsonHeaders, gone});
+    REQUIRE(changesSince("garbage") == Response{410, jsonHeaders, gone});
+}
+
+TEST_CASE("change journal and NACM")
+{
+    spdlog::set_level(spdlog::level::trace);
+    sysrepo::setGlobalContextOptions(sysrepo::ContextFlags::LibYangPrivParsed | sysrepo::ContextFlags::NoPrinted, sysrepo::GlobalContextEffect::Immediate);
+    auto srConn = sysrepo::Connection{};
+    auto srSess = srConn.sessionStart(sysrepo::Datastore::Running);
+    srSess.sendRPC(srSess.getContext().newPath("/ietf-factory-default:factory-reset"));
+    auto nacmGuard = manageNacm(srSess);
+    setupRealNacm(srSess);
+    srSess.setItem("/ietf-netconf-acm:nacm/rule-list[name='norules journal']/group[.='norules']", "");
+    srSess.setItem("/ietf-netconf-acm:nacm/rule-list[name='norules journal']/rule[name='1']/module-name", "rousette");
+    srSess.setItem("/ietf-netconf-acm:nacm/rule-list[name='norules journal']/rule[name='1']/rpc-name", "changes-since");
+    srSess.setItem("/ietf-netconf-acm:nacm/rule-list[name='norules journal']/rule[name='1']/access-operations", "exec");
+    srSess.setItem("/ietf-netconf-acm:nacm/rule-list[name='norules journal']/rule[name='1']/action", "permit");
+    srSess.setItem("/ietf-netconf-acm:nacm/rule-list[name='norules journal']/rule[name='2']/module-name", "ietf-system");
+    srSess.setItem("/ietf-netconf-acm:nacm/rule-list[name='norules journal']/rule[name='2']/path", "/ietf-system:system/location");
+    srSess.setItem("/ietf-netconf-acm:nacm/rule-list[name='norules journal']/rule[name='2']/access-operations", "read");
+    srSess.setItem("/ietf-netconf-acm:nacm/rule-list[name='norules journal']/rule[name='2']/action", "deny");
+    srSess.setItem("/ietf-netconf-acm:nacm/rule-list[name='norules journal']/rule[name='3']/module-name", "ietf-system");
+    srSess.setItem("/ietf-netconf-acm:nacm/rule-list[name='norules journal']/rule[name='3']/path", "/ietf-system:system/radius/server[udp/address='2.2.2.2']");
+    srSess.setItem("/ietf-netconf-acm:nacm/rule-list[name='norules journal']/rule[name='3']/access-operations", "read");
+    srSess.setItem("/ietf-netconf-acm:nacm/rule-list[name='norules journal']/rule[name='3']/action", "deny");
+    srSess.applyChanges();
+
+    auto server = rousette::restconf::Server{srConn, SERVER_ADDRESS, SERVER_PORT, {.serializerThreads = 0, .cache = {.changeJournalSize = 10}}};
+
+    auto changesSince = [](const std::pair<std::string, std::string>& auth, const std::optional<std::string>& revision) {
+        return post(RESTCONF_OPER_ROOT "/rousette:changes-since", {auth, CONTENT_TYPE_JSON},
+                    revision ? R"({"rousette:input": {"revision": ")" + *revision + R"("}})" : R"({"rousette:input": {}})");
+    };
+    auto revisionOf = [](const Response& resp) {
+        REQUIRE(resp.statusCode == 200);
+        const std::string key = R"("revision": ")";
+        auto begin = resp.data.find(key);
+        REQUIRE(begin != std::string::npos);
+        begin += key.size();
+        return resp.data.substr(begin, resp.data.find('"', begin) - begin);
+    };
+    auto commit = [&]() {
+        const auto before = revisionOf(changesSince(AUTH_ROOT, std::nullopt));
+        srSess.applyChanges();
+        // the journal learns about changes asynchronously
+        waitFor([&]() { return revisionOf(changesSince(AUTH_ROOT, std::nullopt)) != before; });
+    };
+
+    const auto initial = revisionOf(changesSince(AUTH_NORULES, std::nullopt));
+
+    srSess.setItem("/ietf-system:system/hostname", "visible");
+    srSess.setItem("/ietf-system:system/location", "hidden");
+    srSess.setItem("/ietf-system:system/radius/server[name='a']/udp/address", "1.1.1.1");
+    srSess.setItem("/ietf-system:system/radius/server[name='a']/udp/shared-secret", "secret");
+    srSess.setItem("/ietf-system:system/radius/server[name='b']/udp/address", "2.2.2.2");
+    srSess.setItem("/ietf-system:system/radius/server[name='b']/udp/shared-secret", "secret");
+    commit();
+
+    // all edits are there for the recovery user
+    auto resp = changesSince(AUTH_ROOT, initial);
+    REQUIRE(resp.statusCode == 200);
+    REQUIRE(resp.data.find("/ietf-system:system/location") != std::string::npos);
+    REQUIRE(resp.data.find("/ietf-system:system/radius/server=b") != std::string::npos);
+    REQUIRE(resp.data.find(R"("shared-secret": "secret")") != std::string::npos);
+
+    // the location is denied explicitly, the server "b" is denied by a rule which looks at something else than the list
+    // key, and the shared secret is marked as nacm:default-deny-all
+    resp = changesSince(AUTH_NORULES, initial);
+    REQUIRE(resp == Response{200, jsonHeaders, R"({
+  "rousette:output": {
+    "revision": ")" + revisionOf(resp) + R"(",
+    "edit": [
+      {
+        "edit-id": "1",
+        "operation": "create",
+        "target": "/ietf-system:system/hostname",
+        "value": {
+          "ietf-system:hostname": "visible"
+        }
+      },
+      {
+        "edit-id": "3",
+        "operation": "create",
+        "target": "/ietf-system:system/radius/server=a",
+        "value": {
+          "ietf-system:server": [
+            {
+              "name": "a",
+              "udp": {
+                "address": "1.1.1.1"
+              }
+            }
+          ]
+        }
+      }
+    ]
+  }
+}
+)"});
+
+    // the same applies to edits which replace the data
+    const auto beforeReplace = revisionOf(resp);
+    srSess.setItem("/ietf-system:system/radius/server[name='a']/udp/shared-secret", "another");
+    srSess.setItem("/ietf-system:system/radius/server[name='b']/udp/shared-secret", "another");
+    commit();
+    REQUIRE(changesSince(AUTH_NORULES, beforeReplace) == Response{200, jsonHeaders, R"({
+  "rousette:output": {
+    "revision": ")" + revisionOf(changesSince(AUTH_NORULES, std::nullopt)) + R"("
+  }
+}
+)"});
+
+    // there is no telling whether the user could read a deleted node, so the data have to be read again
+    const auto beforeDelete = revisionOf(changesSince(AUTH_NORULES, std::nullopt));
+    srSess.deleteItem("/ietf-system:system/location");
+    commit();
+    REQUIRE(changesSince(AUTH_NORULES, beforeDelete) == Response{410, jsonHeaders, R"({
+  "ietf-restconf:errors": {
+    "error": [
+      {
+        "error-type": "application",
+        "error-tag": "operation-failed",
+        "error-message": "Changes since this revision include a deletion; the data have to be read again."
+      }
+    ]
+  }
+}
+)"});
+    resp = changesSince(AUTH_ROOT, beforeDelete);
+    REQUIRE(resp == Response{200, jsonHeaders, R"({
+  "rousette:output": {
+    "revision": ")" + revisionOf(resp) + R"(",
+    "edit": [
+      {
+        "edit-id": "7",
+        "operation": "delete",
+        "target": "/ietf-system:system/location"
+      }
+    ]
+  }
+}
+)"});
+}
+
+TEST_CASE("bulk read")
+{
+    spdlog::set_level(spdlog::level::trace);
+    sysrepo::setGlobalContextOptions(sysrepo::ContextFlags::LibYangPrivParsed | sysrepo::ContextFlags::NoPrinted, sysrepo::GlobalContextEffect::Immediate);
+    auto srConn = sysrepo::Connection{};
+    auto srSess = srConn.sessionStart(sysrepo::Datastore::Running);
+    srSess.sendRPC(srSess.getContext().newPath("/ietf-factory-default:factory-reset"));
+    auto nacmGuard = manageNacm(srSess);
+    srSess.setItem("/ietf-system:system/hostname", "bulk");
+    srSess.setItem("/ietf-system:system/location", "lab");
+    for (const auto& name : {"a", "b"}) {
+        srSess.setItem("/ietf-system:system/radius/server[name='" + std::string{name} + "']/udp/address", "1.1.1.1");
+        srSess.setItem("/ietf-system:system/radius/server[name='" + std::string{name} + "']/udp/shared-secret", "shared-secret");
+    }
+    srSess.setItem("/ietf-system:system/dns-resolver/search[.='example.com']", std::nullopt);
+    srSess.setItem("/ietf-system:system/dns-resolver/search[.='example.net']", std::nullopt);
+    srSess.applyChanges();
+    setupRealNacm(srSess);
+
+    auto server = rousette::restconf::Server{srConn, SERVER_ADDRESS, SERVER_PORT};
+
+    // the hostname and the missing leaf are read together, and the invalid fields are reported just for their own read
+    REQUIRE(post(RESTCONF_OPER_ROOT "/rousette:bulk-read", {AUTH_ROOT, CONTENT_TYPE_JSON}, R"({"rousette:input": {"read": [
+        {"id": "hostname", "path": "/restconf/data/ietf-system:system/hostname"},
+        {"id": "location", "path": "/restconf/ds/ietf-datastores:running/ietf-system:system/location"},
+        {"id": "broken", "path": "/restconf/data/ietf-system:system", "fields": "nonexistent"},
+        {"id": "missing", "path": "/restconf/data/example:top-level-leaf", "depth": "unbounded"},
+        {"id": "invalid", "path": "/restconf/data/ietf-system:system/hostname=x"}
+    ]}})") == Response{200, jsonVaryHeaders, R"({
+  "rousette:output": {
+    "result": [
+      {
+        "id": "hostname",
+        "data": {
+          "ietf-system:system": {
+            "hostname": "bulk"
+          }
+        }
+      },
+      {
+        "id": "location",
+        "data": {
+          "ietf-system:system": {
+            "location": "lab"
+          }
+        }
+      },
+      {
+        "id": "broken",
+        "error": {
+          "status": 400,
+          "error-type": "application",
+          "error-tag": "operation-failed",
+          "error-message": "Can't find schema node for '/ietf-system:system/nonexistent'"
+        }
+      },
+      {
+        "id": "missing",
+        "error": {
+          "status": 404,
+          "error-type": "application",
+          "error-tag": "invalid-value",
+          "error-message": "No data from sysrepo."
+        }
+      },
+      {
+        "id": "invalid",
+        "error": {
+          "status": 400,
+          "error-type": "application",
+          "error-tag": "operation-failed",
+          "error-message": "No keys allowed for node '/ietf-system:system/hostname'"
+        }
+      }
+    ]
+  }
+}
+)"});
+
+    // entries of lists and leaf-lists are picked from the combined data as well
+    REQUIRE(post(RESTCONF_OPER_ROOT "/rousette:bulk-read", {AUTH_ROOT, CONTENT_TYPE_JSON}, R"({"rousette:input": {"read": [
+        {"id": "hostname", "path": "/restconf/data/ietf-system:system/hostname"},
+        {"id": "a", "path": "/restconf/data/ietf-system:system/radius/server=a"},
+        {"id": "b", "path": "/restconf/data/ietf-system:system/radius/server=b/udp/address"},
+        {"id": "search", "path": "/restconf/data/ietf-system:system/dns-resolver/search=example.net"}
+    ]}})") == Response{200, jsonVaryHeaders, R"({
+  "rousette:output": {
+    "result": [
+      {
+        "id": "hostname",
+        "data": {
+          "ietf-system:system": {
+            "hostname": "bulk"
+          }
+        }
+      },
+      {
+        "id": "a",
+        "data": {
+          "ietf-system:system": {
+            "radius": {
+              "server": [
+                {
+                  "name": "a",
+                  "udp": {
+                    "address": "1.1.1.1",
+                    "shared-secret": "shared-secret"
+                  }
+                }
+              ]
+            }
+          }
+        }
+      },
+      {
+        "id": "b",
+        "data": {
+          "ietf-system:system": {
+            "radius": {
+              "server": [
+                {
+                  "name": "b",
+                  "udp": {
+                    "address": "1.1.1.1"
+                  }
+                }
+              ]
+            }
+          }
+        }
+      },
+      {
+        "id": "search",
+        "data": {
+          "ietf-system:system": {
+            "dns-resolver": {
+              "search": [
+                "example.net"
+              ]
+            }
+          }
+        }
+      }
+    ]
+  }
+}
+)"});
+}
@@ -805,7 +805,7 @@ TEST_CASE("Cleaning up inactive subscriptions")
 
     auto nacmGuard = manageNacm(srSess);
     constexpr auto inactivityTimeout = 2s;
-    auto server = rousette::restconf::Server{srConn, SERVER_ADDRESS, SERVER_PORT, 0ms, 55s, inactivityTimeout};
+    auto server = rousette::restconf::Server{srConn, SERVER_ADDRESS, SERVER_PORT, {.subNotifInactivityTimeout = inactivityTimeout}};
 
     auto [id, uri, replayStartTimeRevision] = establishSubscription(srSess.getContext(), libyang::DataFormat::JSON, {AUTH_ROOT}, std::nullopt, {}, std::nullopt);
 
@@ -5,9 +5,12 @@
  *
  */
 
+#include <future>
 #include <nghttp2/asio_http2.h>
+#include <set>
 #include <spdlog/spdlog.h>
 #include <sysrepo-cpp/utils/utils.hpp>
+#include <thread>
 #include "restconf/Server.h"
 #include "tests/aux-utils.h"
 #include "tests/event_watchers.h"
@@ -1861,3 +1864,203 @@ TEST_CASE("writing data")
         }
     }
 }
+
+TEST_CASE("conditional writes")
+{
+    spdlog::set_level(spdlog::level::trace);
+    sysrepo::setGlobalContextOptions(sysrepo::ContextFlags::LibYangPrivParsed | sysrepo::ContextFlags::NoPrinted, sysrepo::GlobalContextEffect::Immediate);
+    auto srConn = sysrepo::Connection{};
+    auto srSess = srConn.sessionStart(sysrepo::Datastore::Running);
+    auto nacmGuard = manageNacm(srSess);
+    srSess.sendRPC(srSess.getContext().newPath("/ietf-factory-default:factory-reset"));
+    srSess.setItem("/example:top-level-leaf", "initial");
+    srSess.applyChanges();
+    setupRealNacm(srSess);
+
+    auto server = rousette::restconf::Server{srConn, SERVER_ADDRESS, SERVER_PORT, {.serializerThreads = 0, .cache = {.entityTags = true}}};
+
+    auto entityTag = [](const std::map<std::string, std::string>& headers) {
+        auto resp = get(RESTCONF_ROOT_DS("running") "/example:top-level-leaf", headers);
+        REQUIRE(resp.statusCode == 200);
+        return resp.headers.find("etag")->second.value;
+    };
+    auto preconditionFailed = [](const std::string& message) {
+        return Response{412, jsonHeaders, R"({
+  "ietf-restconf:errors": {
+    "error": [
+      {
+        "error-type": "protocol",
+        "error-tag": "operation-failed",
+        "error-message": ")" + message + R"("
+      }
+    ]
+  }
+}
+)"};
+    };
+    const std::string staleTag = "The data have been modified since the entity tag was obtained.";
+    auto waitForNotification = []() {
+        // the revision is bumped right after a commit, and once more when sysrepo's notification of the change arrives
+        std::this_thread::sleep_for(std::chrono::milliseconds{100});
+    };
+
+    const auto etag = entityTag({AUTH_ROOT});
+    REQUIRE(put(RESTCONF_DATA_ROOT "/example:top-level-leaf", {AUTH_ROOT, CONTENT_TYPE_JSON, {"if-match", etag}}, R"({"example:top-level-leaf": "first"}")") == Response{204, noContentTypeHeaders, ""});
+    waitForNotification();
+
+    // somebody else has changed the data meanwhile
+    REQUIRE(put(RESTCONF_DATA_ROOT "/example:top-level-leaf", {AUTH_ROOT, CONTENT_TYPE_JSON, {"if-match", etag}}, R"({"example:top-level-leaf": "second"}")") == preconditionFailed(staleTag));
+    REQUIRE(patch(RESTCONF_DATA_ROOT "/example:top-level-leaf", {AUTH_ROOT, CONTENT_TYPE_JSON, {"if-match", etag}}, R"({"example:top-level-leaf": "second"}")") == preconditionFailed(staleTag));
+    REQUIRE(httpDelete(RESTCONF_DATA_ROOT "/example:top-level-leaf", {AUTH_ROOT, {"if-match", etag}}) == preconditionFailed(staleTag));
+    REQUIRE(get(RESTCONF_ROOT_DS("running") "/example:top-level-leaf", {AUTH_ROOT}).data.find("first") != std::string::npos);
+
+    // any representation of the current data will do
+    const auto xmlTag = entityTag({AUTH_ROOT, {"accept", "application/yang-data+xml"}});
+    REQUIRE(put(RESTCONF_DATA_ROOT "/example:top-level-leaf", {AUTH_ROOT, CONTENT_TYPE_JSON, {"if-match", "\"other\", " + xmlTag}}, R"({"example:top-level-leaf": "second"}")") == Response{204, noContentTypeHeaders, ""});
+    waitForNotification();
+
+    // the wildcard only requires that the target exists
+    REQUIRE(put(RESTCONF_DATA_ROOT "/example:top-level-leaf", {AUTH_ROOT, CONTENT_TYPE_JSON, {"if-match", "*"}}, R"({"example:top-level-leaf": "third"}")") == Response{204, noContentTypeHeaders, ""});
+    REQUIRE(put(RESTCONF_DATA_ROOT "/example:two-leafs/a", {AUTH_ROOT, CONTENT_TYPE_JSON, {"if-match", "*"}}, R"({"example:a": "a"}")") == preconditionFailed("Target resource does not exist."));
+
+    // dates have a precision of one second
+    REQUIRE(put(RESTCONF_DATA_ROOT "/example:top-level-leaf", {AUTH_ROOT, CONTENT_TYPE_JSON, {"if-unmodified-since", "Sun, 06 Nov 1994 08:49:37 GMT"}}, R"({"example:top-level-leaf": "fourth"}")") == preconditionFailed("The data have been modified since the given time."));
+    REQUIRE(put(RESTCONF_DATA_ROOT "/example:top-level-leaf", {AUTH_ROOT, CONTENT_TYPE_JSON, {"if-unmodified-since", "Fri, 31 Dec 2100 23:59:59 GMT"}}, R"({"example:top-level-leaf": "fourth"}")") == Response{204, noContentTypeHeaders, ""});
+    waitForNotification();
+
+    REQUIRE(httpDelete(RESTCONF_DATA_ROOT "/example:top-level-leaf", {AUTH_ROOT, {"if-match", entityTag({AUTH_ROOT})}}) == Response{204, noContentTypeHeaders, ""});
+}
+
+TEST_CASE("concurrent conditional writes")
+{
+    spdlog::set_level(spdlog::level::trace);
+    sysrepo::setGlobalContextOptions(sysrepo::ContextFlags::LibYangPrivParsed | sysrepo::ContextFlags::NoPrinted, sysrepo::GlobalContextEffect::Immediate);
+    auto srConn = sysrepo::Connection{};
+    auto srSess = srConn.sessionStart(sysrepo::Datastore::Running);
+    auto nacmGuard = manageNacm(srSess);
+    srSess.sendRPC(srSess.getContext().newPath("/ietf-factory-default:factory-reset"));
+    srSess.setItem("/example:top-level-leaf", "initial");
+    srSess.applyChanges();
+    setupRealNacm(srSess);
+
+    auto server = rousette::restconf::Server{srConn, SERVER_ADDRESS, SERVER_PORT, {.serializerThreads = 0, .cache = {.entityTags = true}}};
+
+    auto resp = get(RESTCONF_ROOT_DS("running") "/example:top-level-leaf", {AUTH_ROOT});
+    REQUIRE(resp.statusCode == 200);
+    const auto etag = resp.headers.find("etag")->second.value;
+
+    // both clients have seen the same version of the data, and both send their edits before any of them is applied
+    std::vector<std::future<Response>> responses;
+    {
+        auto lock = sysrepo::Lock{srConn.sessionStart(sysrepo::Datastore::Running), "example"};
+        for (const std::string value : {"first", "second"}) {
+            responses.emplace_back(std::async(std::launch::async, [etag, value]() {
+                return put(RESTCONF_DATA_ROOT "/example:top-level-leaf", {AUTH_ROOT, CONTENT_TYPE_JSON, {"if-match", etag}, {"request-timeout", "2000"}}, R"({"example:top-level-leaf": ")" + value + R"("})");
+            }));
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds{500});
+    }
+
+    // only one of them wins, the other one learns that its edit would overwrite a change that it has not seen
+    std::multiset<int> statusCodes;
+    for (auto& response : responses) {
+        statusCodes.insert(response.get().statusCode);
+    }
+    REQUIRE(statusCodes == std::multiset<int>{204, 412});
+}
+
+TEST_CASE("PUT locks only the target's module")
+{
+    spdlog::set_level(spdlog::level::trace);
+    sysrepo::setGlobalContextOptions(sysrepo::ContextFlags::LibYangPrivParsed | sysrepo::ContextFlags::NoPrinted, sysrepo::GlobalContextEffect::Immediate);
+    auto srConn = sysrepo::Connection{};
+    auto srSess = srConn.sessionStart(sysrepo::Datastore::Running);
+    auto nacmGuard = manageNacm(srSess);
+    srSess.sendRPC(srSess.getContext().newPath("/ietf-factory-default:factory-reset"));
+    setupRealNacm(srSess);
+
+    auto server = rousette::restconf::Server{srConn, SERVER_ADDRESS, SERVER_PORT};
+
+    {
+        // somebody else is working with an unrelated module
+        auto lock = sysrepo::Lock{srConn.sessionStart(sysrepo::Datastore::Running), "ietf-system"};
+        REQUIRE(put(RESTCONF_DATA_ROOT "/example:top-level-leaf", {AUTH_ROOT, CONTENT_TYPE_JSON}, R"({"example:top-level-leaf": "str"}")") == Response{201, noContentTypeHeaders, ""});
+        REQUIRE(patch(RESTCONF_DATA_ROOT "/example:top-level-leaf", {AUTH_ROOT, CONTENT_TYPE_JSON}, R"({"example:top-level-leaf": "other"}")") == Response{204, noContentTypeHeaders, ""});
+        REQUIRE(put(RESTCONF_DATA_ROOT "/example:a/example-augment:b", {AUTH_ROOT, CONTENT_TYPE_JSON}, R"({"example-augment:b": {"c": {"enabled": false}}}")") == Response{201, noContentTypeHeaders, ""});
+    }
+
+    {
+        // ...but the target's own module is still locked
+        auto lock = sysrepo::Lock{srConn.sessionStart(sysrepo::Datastore::Running), "example"};
+        REQUIRE(put(RESTCONF_DATA_ROOT "/example:top-level-leaf", {AUTH_ROOT, CONTENT_TYPE_JSON}, R"({"example:top-level-leaf": "third"}")").statusCode != 204);
+    }
+
+    {
+        // the data which another module augments into the subtree are stored with the subtree's top-level node
+        auto lock = sysrepo::Lock{srConn.sessionStart(sysrepo::Datastore::Running), "example"};
+        auto resp = put(RESTCONF_DATA_ROOT "/example:a/example-augment:b", {AUTH_ROOT, CONTENT_TYPE_JSON}, R"({"example-augment:b": {"c": {"enabled": false}}}")");
+        REQUIRE(resp.statusCode != 201);
+        REQUIRE(resp.statusCode != 204);
+    }
+    REQUIRE(put(RESTCONF_DATA_ROOT "/example:a/example-augment:b", {AUTH_ROOT, CONTENT_TYPE_JSON}, R"({"example-augment:b": {"c": {"enabled": true}}}")") == Response{204, noContentTypeHeaders, ""});
+}
+
+TEST_CASE("edits of clients which have gone away are not applied")
+{
+    spdlog::set_level(spdlog::level::trace);
+    sysrepo::setGlobalContextOptions(sysrepo::ContextFlags::LibYangPrivParsed | sysrepo::ContextFlags::NoPrinted, sysrepo::GlobalContextEffect::Immediate);
+    auto srConn = sysrepo::Connection{};
+    auto srSess = srConn.sessionStart(sysrepo::Datastore::Running);
+    auto nacmGuard = manageNacm(srSess);
+    srSess.sendRPC(srSess.getContext().newPath("/ietf-factory-default:factory-reset"));
+    srSess.setItem("/example:top-level-leaf", "initial");
+    srSess.applyChanges();
+    setupRealNacm(srSess);
+
+    // a single worker, so that it can be kept busy by a slow read
+    auto server = rousette::restconf::Server{srConn, SERVER_ADDRESS, SERVER_PORT, {.workerThreads = 1}};
+
+    std::promise<void> callbackEntered;
+    std::promise<void> unblock;
+    auto unblocked = unblock.get_future().share();
+    auto sub = srSess.onOperGet(
+        "example", [&](auto, auto, auto, auto, auto, auto, auto& parent) {
+            callbackEntered.set_value();
+            unblocked.wait();
+            parent->newPath("nonconfig-node", "slow");
+            return sysrepo::ErrorCode::Ok;
+        },
+        "/example:config-nonconfig/nonconfig-node");
+
+    auto slowRead = std::async(std::launch::async, []() {
+        return get(RESTCONF_DATA_ROOT "/example:config-nonconfig/nonconfig-node", {AUTH_ROOT});
+    });
+    callbackEntered.get_future().wait();
+
+    // these wait in the queue until their clients give up and close their streams
+    REQUIRE_THROWS_AS(put(RESTCONF_DATA_ROOT "/example:top-level-leaf", {AUTH_ROOT, CONTENT_TYPE_JSON}, R"({"example:top-level-leaf": "abandoned"})", boost::posix_time::milliseconds{300}), std::runtime_error);
+    REQUIRE_THROWS_AS(patch(RESTCONF_DATA_ROOT, {AUTH_ROOT, CONTENT_TYPE_YANG_PATCH_JSON}, R"({
+  "ietf-yang-patch:yang-patch": {
+    "patch-id": "abandoned",
+    "edit": [
+      {
+        "edit-id": "1",
+        "operation": "replace",
+        "target": "/example:top-level-leaf",
+        "value": {
+          "example:top-level-leaf": "abandoned by a YANG patch"
+        }
+      }
+    ]
+  }
+})", boost::posix_time::milliseconds{300}), std::runtime_error);
+
+    unblock.set_value();
+    REQUIRE(slowRead.get().statusCode == 200);
+
+    // the worker has skipped both edits
+    REQUIRE(get(RESTCONF_DATA_ROOT "/example:top-level-leaf", {AUTH_ROOT}) == Response{200, jsonHeaders, R"({
+  "example:top-level-leaf": "initial"
+}
+)"});
+}
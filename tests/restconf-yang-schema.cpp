@@ -180,7 +180,7 @@ TEST_CASE("obtaining YANG schemas")
                 SECTION("correct revision in uri")
                 {
                     auto resp = get(YANG_ROOT "/ietf-system@2014-08-06", {AUTH_ROOT});
-                    auto expectedShortenedResp = Response{200, yangHeaders, "module ietf-system {\n  namespa"};
+                    auto expectedShortenedResp = Response{200, yangVaryHeaders, "module ietf-system {\n  namespa"};
 
                     REQUIRE(resp.equalStatusCodeAndHeaders(expectedShortenedResp));
                     REQUIRE(resp.data.substr(0, 30) == expectedShortenedResp.data);
@@ -214,11 +214,14 @@ TEST_CASE("obtaining YANG schemas")
                 {
                     std::string moduleName;
                     std::string expectedResponseStart;
+                    // only the big schemas are worth compressing
+                    ng::header_map expectedHeaders = yangHeaders;
 
                     SECTION("loaded module")
                     {
                         moduleName = "example";
                         expectedResponseStart = "module example {";
+                        expectedHeaders = yangVaryHeaders;
                     }
                     SECTION("loaded submodule")
                     {
@@ -236,10 +239,10 @@ TEST_CASE("obtaining YANG schemas")
                         expectedResponseStart = "submodule imp-submod {";
                     }
 
-                    REQUIRE(head(YANG_ROOT "/" + moduleName, {AUTH_ROOT}) == Response{200, yangHeaders, ""});
+                    REQUIRE(head(YANG_ROOT "/" + moduleName, {AUTH_ROOT}) == Response{200, expectedHeaders, ""});
 
                     auto resp = get(YANG_ROOT "/" + moduleName, {AUTH_ROOT});
-                    auto expectedShortenedResp = Response{200, yangHeaders, expectedResponseStart};
+                    auto expectedShortenedResp = Response{200, expectedHeaders, expectedResponseStart};
 
                     REQUIRE(resp.equalStatusCodeAndHeaders(expectedShortenedResp));
                     REQUIRE(resp.data.substr(0, expectedResponseStart.size()) == expectedShortenedResp.data);
@@ -6,6 +6,9 @@
  *
  */
 
+#include <array>
+#include <spdlog/spdlog.h>
+#include <sysrepo-cpp/utils/utils.hpp>
 #include "restconf_utils.h"
 #include "sysrepo-cpp/Session.hpp"
 
@@ -17,6 +20,19 @@ namespace {
 std::string serverAddressAndPort(const std::string& server_address, const std::string& server_port) {
     return "http://["s + server_address + "]" + ":" + server_port;
 }
+
+sysrepo::Connection freshConnection()
+{
+    spdlog::set_level(spdlog::level::trace);
+    sysrepo::setGlobalContextOptions(sysrepo::ContextFlags::LibYangPrivParsed | sysrepo::ContextFlags::NoPrinted, sysrepo::GlobalContextEffect::Immediate);
+    return sysrepo::Connection{};
+}
+
+UniqueResource factoryReset(sysrepo::Session session)
+{
+    session.sendRPC(session.getContext().newPath("/ietf-factory-default:factory-reset"));
+    return manageNacm(session);
+}
 }
 
 Response::Response(int statusCode, const Response::Headers& headers, const std::string& data)
@@ -121,6 +137,13 @@ UniqueResource manageNacm(sysrepo::Session session)
         });
 }
 
+SysrepoFixture::SysrepoFixture()
+    : srConn{freshConnection()}
+    , srSess{srConn.sessionStart(sysrepo::Datastore::Running)}
+    , nacmGuard{factoryReset(srSess)}
+{
+}
+
 void setupRealNacm(sysrepo::Session session)
 {
     session.switchDatastore(sysrepo::Datastore::Running);
@@ -201,9 +224,46 @@ SSEClient::SSEClient(
 
         auto req = client->submit(ec, "GET", serverAddressAndPort(server_address, server_port) + uri, "", reqHeaders);
         req->on_response([&, silenceTimeout, reportIgnoredLines](const ng_client::response& res) {
+            if (auto it = res.header().find("content-encoding"); it != res.header().end()) {
+                contentEncoding = it->second.value;
+                if (*contentEncoding == "zstd") {
+                    zstdDecoder = std::shared_ptr<ZSTD_DCtx>(ZSTD_createDCtx(), ZSTD_freeDCtx);
+                    REQUIRE(zstdDecoder);
+                } else {
+                    REQUIRE((*contentEncoding == "gzip" || *contentEncoding == "deflate"));
+                    inflater = std::shared_ptr<z_stream>(new z_stream{}, [](z_stream* stream) {
+                        inflateEnd(stream);
+                        delete stream;
+                    });
+                    REQUIRE(inflateInit2(inflater.get(), 15 + 32 /* detect zlib or gzip */) == Z_OK);
+                }
+            }
             requestSent.release();
             res.on_data([&, silenceTimeout, reportIgnoredLines](const uint8_t* data, std::size_t len) {
-                dataBuffer.append(std::string(reinterpret_cast<const char*>(data), len));
+                if (inflater) {
+                    // each event is flushed by the server, so it can be decoded right away
+                    inflater->next_in = const_cast<Bytef*>(data);
+                    inflater->avail_in = len;
+                    std::array<char, 4096> buf;
+                    do {
+                        inflater->next_out = reinterpret_cast<Bytef*>(buf.data());
+                        inflater->avail_out = buf.size();
+                        auto ret = inflate(inflater.get(), Z_SYNC_FLUSH);
+                        REQUIRE((ret == Z_OK || ret == Z_STREAM_END || ret == Z_BUF_ERROR));
+                        dataBuffer.append(buf.data(), buf.size() - inflater->avail_out);
+                    } while (inflater->avail_out == 0);
+                } else if (zstdDecoder) {
+                    ZSTD_inBuffer in{data, len, 0};
+                    std::array<char, 4096> buf;
+                    ZSTD_outBuffer out;
+                    do {
+                        out = {buf.data(), buf.size(), 0};
+                        REQUIRE(!ZSTD_isError(ZSTD_decompressStream(zstdDecoder.get(), &out, &in)));
+                        dataBuffer.append(buf.data(), out.pos);
+                    } while (in.pos < in.size || out.pos == out.size);
+                } else {
+                    dataBuffer.append(std::string(reinterpret_cast<const char*>(data), len));
+                }
                 parseEvents(eventWatcher, reportIgnoredLines);
                 t.expires_after(std::chrono::seconds(silenceTimeout));
             });
@@ -9,14 +9,15 @@
 #pragma once
 #include "trompeloeil_doctest.h"
 #include <nghttp2/asio_http2_client.h>
+#include <optional>
 #include <semaphore>
+#include <sysrepo-cpp/Connection.hpp>
+#include <sysrepo-cpp/Session.hpp>
+#include <zlib.h>
+#include <zstd.h>
 #include "event_watchers.h"
 #include "UniqueResource.h"
 
-namespace sysrepo {
-class Session;
-}
-
 namespace ng = nghttp2::asio_http2;
 namespace ng_client = ng::client;
 
@@ -84,10 +85,22 @@ Response clientRequest(
 UniqueResource manageNacm(sysrepo::Session session);
 void setupRealNacm(sysrepo::Session session);
 
+/** @short A sysrepo connection with the factory-default data, whose NACM rules are restored once the test is done */
+struct SysrepoFixture {
+    SysrepoFixture();
+
+    sysrepo::Connection srConn;
+    sysrepo::Session srSess;
+    UniqueResource nacmGuard;
+};
+
 struct SSEClient {
     std::shared_ptr<ng_client::session> client;
     boost::asio::steady_timer t;
     std::string dataBuffer;
+    std::optional<std::string> contentEncoding;
+    std::shared_ptr<z_stream> inflater; ///< Decompresses a gzip or deflate stream, if the server sent one
+    std::shared_ptr<ZSTD_DCtx> zstdDecoder; ///< Decompresses a zstd stream, if the server sent one
 
     enum class ReportIgnoredLines {
         No,
@@ -0,0 +1,112 @@
+/*
+ * Copyright (C) 2026 CESNET, https://photonics.cesnet.cz/
+ *
+ * Written by Jan Kundrát <jan.kundrat@cesnet.cz>
+ *
+ */
+
+#include "trompeloeil_doctest.h"
+#include <filesystem>
+#include <libyang-cpp/Context.hpp>
+#include "restconf/utils/print.h"
+#include "tests/configure.cmake.h"
+
+using namespace std::string_literals;
+
+namespace {
+/** @short Print the tree through the ParallelTreePrinter, just like the server does, and return the individual chunks */
+std::vector<std::string> printChunks(libyang::DataNode&& tree, const libyang::DataFormat format, const libyang::PrintFlags flags, const std::size_t entriesPerPiece, const bool block = false)
+{
+    rousette::restconf::ParallelTreePrinter printer{
+        rousette::restconf::TreePrinter{std::move(tree), format, flags, entriesPerPiece},
+        [](std::function<void()> task) { task(); },
+        []() {},
+        2};
+
+    std::vector<std::string> chunks;
+    std::string chunk;
+    while (true) {
+        auto status = block ? printer.wait(chunk) : printer.next(chunk);
+        REQUIRE(status != rousette::restconf::ParallelTreePrinter::Status::Pending);
+        if (status == rousette::restconf::ParallelTreePrinter::Status::Finished) {
+            return chunks;
+        }
+        chunks.emplace_back(std::move(chunk));
+    }
+}
+
+std::string concat(const std::vector<std::string>& chunks)
+{
+    std::string res;
+    for (const auto& chunk : chunks) {
+        res += chunk;
+    }
+    return res;
+}
+}
+
+TEST_CASE("printing a tree piece by piece")
+{
+    auto ctx = libyang::Context{libyang::internalModuleDirectory(), libyang::ContextOptions::DisableSearchCwd};
+    ctx.setSearchDir(std::filesystem::path{CMAKE_CURRENT_SOURCE_DIR} / "tests" / "yang");
+    ctx.loadModule("example", std::nullopt, {"f1"});
+    ctx.loadModule("example-augment");
+
+    const std::vector<std::pair<libyang::DataFormat, libyang::PrintFlags>> outputs{
+        {libyang::DataFormat::JSON, libyang::PrintFlags::EmptyContainers},
+        {libyang::DataFormat::JSON, libyang::PrintFlags::EmptyContainers | libyang::PrintFlags::Shrink},
+        {libyang::DataFormat::XML, libyang::PrintFlags::EmptyContainers},
+        {libyang::DataFormat::XML, libyang::PrintFlags::EmptyContainers | libyang::PrintFlags::Shrink},
+    };
+
+    auto tree = ctx.newPath("/example:ordered-lists");
+
+    SECTION("a single container with a big list")
+    {
+        for (int i = 0; i < 1000; ++i) {
+            tree.newPath("/example:ordered-lists/lst[name='" + std::to_string(i) + "']");
+        }
+        tree.newPath("/example:ordered-lists/ll[.='x']");
+
+        for (const auto& [format, flags] : outputs) {
+            auto chunks = printChunks(libyang::DataNode{tree}, format, flags, 256);
+            // four pieces of the list, the leaf-list, and the end of the container
+            REQUIRE(chunks.size() == 6);
+            REQUIRE(concat(chunks) == *tree.firstSibling().printStr(format, flags | libyang::PrintFlags::Siblings));
+            REQUIRE(printChunks(libyang::DataNode{tree}, format, flags, 256, true) == chunks);
+        }
+    }
+
+    SECTION("big lists deep down")
+    {
+        tree.newPath("/example:top-level-leaf", "a");
+        tree.newPath("/example:top-level-list[name='a']");
+        tree.newPath("/example:top-level-list[name='b']");
+        for (const auto& name : {"x", "y"}) {
+            const auto entry = "/example:tlc/list[name='"s + name + "']";
+            tree.newPath(entry + "/choice1", "c");
+            for (int i = 0; i < 10; ++i) {
+                tree.newPath(entry + "/collection[.='" + std::to_string(i) + "']");
+                const auto nested = entry + "/nested[first='f'][second='" + std::to_string(i) + "'][third='t']";
+                tree.newPath(nested + "/fourth", "4");
+                tree.newPath(nested + "/data/other-data/b", "b");
+            }
+        }
+        tree.newPath("/example:tlc/list[name='z']/choice2", "small");
+        tree.newPath("/example:tlc/status", "on");
+        for (int i = 0; i < 10; ++i) {
+            tree.newPath("/example:ordered-lists/lst[name='" + std::to_string(i) + "']");
+            tree.newPath("/example:ordered-lists/ll2[.='" + std::to_string(i) + "']");
+        }
+        tree.newPath("/example:a/example-augment:b/c/enabled", "false");
+        tree.newPath("/example:a/something", "s");
+
+        for (const auto& [format, flags] : outputs) {
+            const auto expected = *tree.firstSibling().printStr(format, flags | libyang::PrintFlags::Siblings);
+            REQUIRE(concat(printChunks(libyang::DataNode{tree}, format, flags, 256)) == expected);
+            auto chunks = printChunks(libyang::DataNode{tree}, format, flags, 3);
+            REQUIRE(chunks.size() > 20);
+            REQUIRE(concat(chunks) == expected);
+        }
+    }
+}
@@ -2,6 +2,7 @@
 
 #include <doctest/doctest.h>
 #include <doctest/trompeloeil.hpp>
+#include <functional>
 #include <trompeloeil.hpp>
 
 #define SECTION(name) DOCTEST_SUBCASE(name)
@@ -19,3 +20,4 @@ using doctest::Approx;
 #define REQUIRE_NOTHROW(expr) DOCTEST_REQUIRE_NOTHROW(static_cast<void>(expr))
 
 void waitForCompletionAndBitMore(const trompeloeil::sequence& seq);
+void waitFor(const std::function<bool()>& condition);
@@ -838,7 +838,21 @@ TEST_CASE("URI path parser")
             QUERY_PARAMS_SYNTAX_ERROR(parseQueryParams("insert=foo"), 7, "'first', 'last', 'after' or 'before'");
             REQUIRE(parseQueryParams("depth=4&insert=last&with-defaults=trim") == QueryParams{{"depth", 4u}, {"insert", insert::Last{}}, {"with-defaults", withDefaults::Trim{}}});
             REQUIRE(parseQueryParams("insert=before") == QueryParams{{"insert", insert::Before{}}});
+            REQUIRE(parseQueryParams("pretty=true") == QueryParams{{"pretty", pretty::Enabled{}}});
+            REQUIRE(parseQueryParams("depth=2&pretty=false") == QueryParams{{"depth", 2u}, {"pretty", pretty::Disabled{}}});
+            QUERY_PARAMS_SYNTAX_ERROR(parseQueryParams("pretty="), 7, "'true' or 'false'");
+            QUERY_PARAMS_SYNTAX_ERROR(parseQueryParams("pretty=1"), 7, "'true' or 'false'");
             REQUIRE(parseQueryParams("insert=after") == QueryParams{{"insert", insert::After{}}});
+            REQUIRE(parseQueryParams("limit=2&offset=0") == QueryParams{{"limit", 2u}, {"offset", 0u}});
+            REQUIRE(parseQueryParams("limit=unbounded&sublist-limit=1") == QueryParams{{"limit", UnboundedLimit{}}, {"sublist-limit", 1u}});
+            QUERY_PARAMS_SYNTAX_ERROR(parseQueryParams("limit=0"), 6, "a positive number or 'unbounded'");
+            QUERY_PARAMS_SYNTAX_ERROR(parseQueryParams("offset=-1"), 7, "a number");
+            REQUIRE(parseQueryParams("cursor=6f6e65-74776f&direction=backwards") == QueryParams{{"cursor", "6f6e65-74776f"s}, {"direction", direction::Backwards{}}});
+            REQUIRE(parseQueryParams("direction=forwards") == QueryParams{{"direction", direction::Forwards{}}});
+            QUERY_PARAMS_SYNTAX_ERROR(parseQueryParams("direction=up"), 10, "'forwards' or 'backwards'");
+            QUERY_PARAMS_SYNTAX_ERROR(parseQueryParams("cursor="), 7, "cursor");
+            REQUIRE(parseQueryParams("sort-by=example:data/a") == QueryParams{{"sort-by", "example:data/a"s}});
+            QUERY_PARAMS_SYNTAX_ERROR(parseQueryParams("sort-by=/a"), 8, "identifier");
             QUERY_PARAMS_SYNTAX_ERROR(parseQueryParams("insert=uwu"), 7, "'first', 'last', 'after' or 'before'");
             REQUIRE(parseQueryParams("filter=asd") == QueryParams{{"filter", "asd"s}});
             REQUIRE(parseQueryParams("filter=/") == QueryParams{{"filter", "/"s}});
@@ -1066,8 +1080,94 @@ TEST_CASE("URI path parser")
                 REQUIRE(std::holds_alternative<NotificationStreamRequest>(resp));
                 REQUIRE(std::get<NotificationStreamRequest>(resp).queryParams == QueryParams({{"filter", "/asd"s}}));
 
-                REQUIRE_THROWS_WITH_AS(asRestconfRequest(ctx, "GET", "/restconf/data/example:ordered-lists", "filter=something"),
-                                       serializeErrorResponse(400, "protocol", "invalid-value", "Query parameter 'filter' can be used only with streams").c_str(),
+                REQUIRE(asRestconfRequest(ctx, "GET", "/restconf/data", "filter=/example:tlc/list[choice1='x']").queryParams == QueryParams({{"filter", "/example:tlc/list[choice1='x']"s}}));
+                REQUIRE(asRestconfRequest(ctx, "HEAD", "/restconf/data/example:tlc", "filter=/example:tlc/list/nested[fourth='x']").path == "/example:tlc");
+                // a relative filter is evaluated from the target
+                REQUIRE(asRestconfRequest(ctx, "GET", "/restconf/data/example:tlc/list=eth0", "filter=nested[fourth='x']").path == "/example:tlc/list[name='eth0']");
+                REQUIRE_THROWS_AS(asRestconfRequest(ctx, "GET", "/restconf/data/example:tlc", "filter=example:tlc"), rousette::restconf::ErrorResponse);
+
+                REQUIRE_THROWS_AS(asRestconfRequest(ctx, "GET", "/restconf/data/example:ordered-lists", "filter=/example:nonexistent"), rousette::restconf::ErrorResponse);
+                REQUIRE_THROWS_AS(asRestconfRequest(ctx, "GET", "/restconf/data/example:ordered-lists", "filter=something["), rousette::restconf::ErrorResponse);
+                REQUIRE_THROWS_WITH_AS(asRestconfRequest(ctx, "PUT", "/restconf/data/example:ordered-lists", "filter=/example:ordered-lists"),
+                                       serializeErrorResponse(400, "protocol", "invalid-value", "Query parameter 'filter' can be used only with GET and HEAD methods").c_str(),
+                                       rousette::restconf::ErrorResponse);
+                REQUIRE_THROWS_WITH_AS(asRestconfRequest(ctx, "GET", "/restconf/data/example:tlc", "filter=/example:tlc/list&fields=list"),
+                                       serializeErrorResponse(400, "protocol", "invalid-value", "Query parameters 'filter' and 'fields' cannot be used together").c_str(),
+                                       rousette::restconf::ErrorResponse);
+                REQUIRE_THROWS_WITH_AS(asRestconfRequest(ctx, "GET", "/restconf/data/example:tlc/list", "filter=/example:tlc/list&limit=1"),
+                                       serializeErrorResponse(400, "protocol", "invalid-value", "Query parameter 'filter' cannot be used with list pagination").c_str(),
+                                       rousette::restconf::ErrorResponse);
+
+                for (const auto& [target, filter, xpath] : {
+                         std::tuple<std::string, std::string, std::string>{"/*", "/example:tlc/list[choice1='x']", "/example:tlc/list[choice1='x']"},
+                         {"/*", "example:tlc/list | example:a", "/example:tlc/list | /example:a"},
+                         {"/example:tlc", "/example:tlc/list[choice1='x']", "/example:tlc/list[choice1='x']"},
+                         {"/example:tlc/list[name='a/b']", "/example:tlc/list[choice1='x']/nested", "/example:tlc/list[choice1='x'][name='a/b']/nested"},
+                         {"/example:tlc/list[name='eth0']", "/example:tlc/example:list[1]", "/example:tlc/list[1][name='eth0']"},
+                         {"/example:tlc/list[name='eth0']", "nested[fourth='x'] | collection", "/example:tlc/list[name='eth0']/nested[fourth='x'] | /example:tlc/list[name='eth0']/collection"},
+                         // anything else is checked node by node
+                         {"/example:tlc/list[name='eth0']", "/example:tlc", "(/example:tlc)[ancestor-or-self::node()[count(. | /example:tlc/list[name='eth0']) = count(/example:tlc/list[name='eth0'])]]"},
+                         {"/example:tlc", "//nested", "(//nested)[ancestor-or-self::node()[count(. | /example:tlc) = count(/example:tlc)]]"},
+                         {"/example:tlc", "list/descendant::fourth", "(/example:tlc/list/descendant::fourth)[ancestor-or-self::node()[count(. | /example:tlc) = count(/example:tlc)]]"},
+                         {"/example:tlc", "/example:tlc/list | /example:a", "(/example:tlc/list | /example:a)[ancestor-or-self::node()[count(. | /example:tlc) = count(/example:tlc)]]"},
+                     }) {
+                    CAPTURE(target);
+                    CAPTURE(filter);
+                    REQUIRE(rousette::restconf::filterToXPath(target, filter) == xpath);
+                }
+            }
+
+            SECTION("pretty")
+            {
+                REQUIRE(asRestconfRequest(ctx, "GET", "/restconf/data/example:ordered-lists", "pretty=false").queryParams == QueryParams({{"pretty", pretty::Disabled{}}}));
+                REQUIRE(asRestconfRequest(ctx, "POST", "/restconf/operations/example:test-rpc", "pretty=true").queryParams == QueryParams({{"pretty", pretty::Enabled{}}}));
+
+                REQUIRE_THROWS_WITH_AS(asRestconfStreamRequest("GET", "/streams/NETCONF/XML", "pretty=true"),
+                                       serializeErrorResponse(400, "protocol", "invalid-value", "Query parameter 'pretty' can't be used with streams").c_str(),
+                                       rousette::restconf::ErrorResponse);
+            }
+
+            SECTION("list pagination")
+            {
+                auto req = asRestconfRequest(ctx, "GET", "/restconf/data/example:tlc/list=eth0/nested", "limit=2&sort-by=fourth");
+                REQUIRE(req.type == RestconfRequest::Type::GetData);
+                REQUIRE(req.path == "/example:tlc/list[name='eth0']/nested");
+                REQUIRE(req.queryParams == QueryParams({{"limit", 2u}, {"sort-by", "fourth"s}}));
+
+                REQUIRE(asRestconfRequest(ctx, "GET", "/restconf/data/example:top-level-leaf-list", "direction=backwards").path == "/example:top-level-leaf-list");
+                REQUIRE(asRestconfRequest(ctx, "HEAD", "/restconf/ds/ietf-datastores:running/example:tlc/list", "offset=1").path == "/example:tlc/list");
+
+                // sublist-limit alone does not turn the request into a paginated one
+                REQUIRE(asRestconfRequest(ctx, "GET", "/restconf/data/example:tlc/list=eth0", "sublist-limit=1").path == "/example:tlc/list[name='eth0']");
+
+                REQUIRE_THROWS_WITH_AS(asRestconfRequest(ctx, "GET", "/restconf/data/example:tlc/list=eth0", "limit=1"),
+                                       serializeErrorResponse(400, "protocol", "invalid-value", "List pagination requires a list or a leaf-list as the target").c_str(),
+                                       rousette::restconf::ErrorResponse);
+                REQUIRE_THROWS_WITH_AS(asRestconfRequest(ctx, "GET", "/restconf/data/example:tlc", "limit=1"),
+                                       serializeErrorResponse(400, "protocol", "invalid-value", "List pagination requires a list or a leaf-list as the target").c_str(),
+                                       rousette::restconf::ErrorResponse);
+                REQUIRE_THROWS_WITH_AS(asRestconfRequest(ctx, "GET", "/restconf/data", "limit=1"),
+                                       serializeErrorResponse(400, "protocol", "invalid-value", "List pagination requires a list or a leaf-list as the target").c_str(),
+                                       rousette::restconf::ErrorResponse);
+                REQUIRE_THROWS_WITH_AS(asRestconfRequest(ctx, "GET", "/restconf/data/example:tlc/list", "offset=1&cursor=6f6e65"),
+                                       serializeErrorResponse(400, "protocol", "invalid-value", "Query parameters 'offset' and 'cursor' cannot be used together").c_str(),
+                                       rousette::restconf::ErrorResponse);
+                REQUIRE_THROWS_WITH_AS(asRestconfRequest(ctx, "DELETE", "/restconf/data/example:tlc/list=eth0", "limit=1"),
+                                       serializeErrorResponse(400, "protocol", "invalid-value", "Query parameter 'limit' can be used only with GET and HEAD methods").c_str(),
+                                       rousette::restconf::ErrorResponse);
+
+                REQUIRE(asRestconfRequest(ctx, "GET", "/restconf/data/example:tlc/list=eth0/nested", "sort-by=data/other-data/b").queryParams == QueryParams({{"sort-by", "data/other-data/b"s}}));
+                REQUIRE_THROWS_WITH_AS(asRestconfRequest(ctx, "GET", "/restconf/data/example:tlc/list=eth0/nested", "sort-by=fifth"),
+                                       serializeErrorResponse(400, "protocol", "invalid-value", "Query parameter 'sort-by': node 'fifth' is not a child of '/example:tlc/list/nested'").c_str(),
+                                       rousette::restconf::ErrorResponse);
+                REQUIRE_THROWS_WITH_AS(asRestconfRequest(ctx, "GET", "/restconf/data/example:tlc/list", "sort-by=collection"),
+                                       serializeErrorResponse(400, "protocol", "invalid-value", "Query parameter 'sort-by': '/example:tlc/list/collection' is a list or a leaf-list").c_str(),
+                                       rousette::restconf::ErrorResponse);
+                REQUIRE_THROWS_WITH_AS(asRestconfRequest(ctx, "GET", "/restconf/data/example:tlc/list=eth0/nested", "sort-by=data"),
+                                       serializeErrorResponse(400, "protocol", "invalid-value", "Query parameter 'sort-by': '/example:tlc/list/nested/data' is not a leaf").c_str(),
+                                       rousette::restconf::ErrorResponse);
+                REQUIRE_THROWS_WITH_AS(asRestconfRequest(ctx, "GET", "/restconf/data/example:top-level-leaf-list", "sort-by=name"),
+                                       serializeErrorResponse(400, "protocol", "invalid-value", "Query parameter 'sort-by' can be used only with lists").c_str(),
                                        rousette::restconf::ErrorResponse);
             }
 
@@ -1,5 +1,6 @@
 #include <chrono>
 #include <doctest/doctest.h>
+#include <functional>
 #include <thread>
 #include <trompeloeil.hpp>
 
@@ -37,3 +38,19 @@ void waitForCompletionAndBitMore(const trompeloeil::sequence& seq)
     auto duration = std::chrono::duration<double>(clock::now() - start);
     std::this_thread::sleep_for(std::max(duration, decltype(duration)(minExtraWait)));
 }
+
+/** @short Wait until the condition holds, e.g., until some asynchronously delivered change becomes visible */
+void waitFor(const std::function<bool()>& condition)
+{
+    using namespace std::literals;
+    using clock = std::chrono::steady_clock;
+
+    const auto waitingStep = 10ms;
+    const auto timeout = 5000ms;
+
+    auto start = clock::now();
+    while (!condition()) {
+        REQUIRE(clock::now() - start < timeout);
+        std::this_thread::sleep_for(waitingStep);
+    }
+}